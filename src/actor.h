@@ -623,6 +623,15 @@ struct FLinkContext
 	msecnode_t *render_list = nullptr;
 };
 
+// Area around the position a sector list was built at in which the list can't change.
+// Lets P_CreateSecNodeList skip the rebuild for small moves.
+struct FSecListCache
+{
+	DVector2 Pos;
+	double Extent;		// half size of the area, 0 if unknown
+	int Epoch;
+};
+
 struct FDropItem
 {
 	FDropItem *Next;
@@ -679,6 +688,13 @@ public:
 
 	bool CheckNoDelay();
 
+	// Idle actor parking. A parked actor is skipped by the thinker loop, which only
+	// counts down its tics, until its state runs out or something disturbs it.
+	bool IsResting();
+	void CheckPark();
+	bool TickParked();
+	void Unpark() { ObjectFlags &= ~OF_Parked; }
+
 	virtual void BeginPlay();			// Called immediately after the actor is created
 	void CallBeginPlay();
 
@@ -1113,6 +1129,8 @@ public:
 	struct msecnode_t	*touching_sectorportallist;		// same for cross-sectorportal rendering
 	struct portnode_t	*touching_lineportallist;		// and for cross-lineportal
 	struct msecnode_t	*touching_rendersectors; // this is the list of sectors that this thing interesects with it's max(radius, renderradius).
+	FSecListCache		SectorListCache;
+	FSecListCache		RenderListCache;
 	int validcount;
 
 
@@ -265,18 +265,18 @@ private:
 
 	void *operator new(size_t len, nonew&)
 	{
-		return M_Malloc(len);
+		return GC::AllocObject(len);
 	}
 public:
 
 	void operator delete (void *mem, nonew&)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 	}
 
 	void operator delete (void *mem)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 	}
 
 	// GC fiddling
@@ -343,7 +343,7 @@ protected:
 
 	void operator delete (void *mem, EInPlace *)
 	{
-		M_Free (mem);
+		GC::FreeObject (mem);
 	}
 
 	template<typename T, typename... Args>
@@ -363,6 +363,7 @@ T* Create(Args&&... args)
 	{
 		object->SetClass(RUNTIME_CLASS(T));
 		assert(object->GetClass() != nullptr);	// beware of objects that get created before the type system is up.
+		GC::CountObject(object);
 	}
 	return object;
 }
@@ -56,6 +56,8 @@
 
 // HEADER FILES ------------------------------------------------------------
 
+#include <algorithm>
+
 #include "dobject.h"
 #include "templates.h"
 #include "b_bot.h"
@@ -135,8 +137,78 @@ bool FinalGC;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+// Never freed, because objects can still be deleted while shutting down.
+static FSizeClassPool *ObjectPool;
+
 // CODE --------------------------------------------------------------------
 
+//==========================================================================
+//
+// AllocObject
+//
+// Objects are allocated from size classes so that the memory of collected
+// objects is reused by the next ones of about the same size instead of
+// going through the system allocator every time.
+//
+//==========================================================================
+
+void *AllocObject(size_t size)
+{
+	if (ObjectPool == nullptr)
+	{
+		ObjectPool = new FSizeClassPool;
+	}
+	size_t before = AllocBytes;
+	void *mem = ObjectPool->Alloc(size);
+	if (FSizeClassPool::IsPooled(mem))
+	{
+		// The arena's blocks went through M_Malloc, but for pacing the collector
+		// only the objects inside them count. Otherwise memory sitting on the
+		// free lists would never lower the estimate.
+		AllocBytes = before + FSizeClassPool::GetSize(mem);
+	}
+	return mem;
+}
+
+//==========================================================================
+//
+// FreeObject
+//
+//==========================================================================
+
+void FreeObject(void *mem)
+{
+	if (mem == nullptr) return;
+	if (FSizeClassPool::IsPooled(mem))
+	{
+		AllocBytes -= FSizeClassPool::GetSize(mem);
+	}
+	// The classes are already gone when the final collection after PClass::StaticShutdown runs.
+	auto cls = (PClass *)FSizeClassPool::GetOwner(mem);
+	if (cls != nullptr && !PClass::bShutdown)
+	{
+		cls->PoolLive--;
+	}
+	ObjectPool->Free(mem);
+}
+
+//==========================================================================
+//
+// CountObject
+//
+// Remembers the object's class in the pool header, so that FreeObject can
+// take it off the class's count no matter how the object gets deleted.
+//
+//==========================================================================
+
+void CountObject(DObject *obj)
+{
+	PClass *cls = obj->GetClass();
+	FSizeClassPool::SetOwner(obj, cls);
+	cls->PoolLive++;
+	cls->PoolAllocs++;
+}
+
 //==========================================================================
 //
 // SetThreshold
@@ -622,7 +694,7 @@ CCMD(gc)
 {
 	if (argv.argc() == 1)
 	{
-		Printf ("Usage: gc stop|now|full|count|pause [size]|stepmul [size]\n");
+		Printf ("Usage: gc stop|now|full|count|pools [count]|pause [size]|stepmul [size]\n");
 		return;
 	}
 	if (stricmp(argv[1], "stop") == 0)
@@ -643,6 +715,31 @@ CCMD(gc)
 		for (DObject *obj = GC::Root; obj; obj = obj->ObjNext, cnt++);
 		Printf("%d active objects counted\n", cnt);
 	}
+	else if (stricmp(argv[1], "pools") == 0)
+	{
+		if (GC::ObjectPool != nullptr)
+		{
+			GC::ObjectPool->DumpInfo();
+		}
+
+		// List the classes holding the most pool memory.
+		TArray<PClass *> classes;
+		for (auto cls : PClass::AllClasses)
+		{
+			if (cls->PoolAllocs > 0) classes.Push(cls);
+		}
+		std::sort(classes.begin(), classes.end(), [](PClass *a, PClass *b)
+		{
+			return size_t(a->PoolLive) * a->Size > size_t(b->PoolLive) * b->Size;
+		});
+		unsigned count = argv.argc() > 2 ? (unsigned)MAX(1, atoi(argv[2])) : 20u;
+		Printf("\n%-32s %6s %8s %10s\n", "Class", "Size", "Live", "Allocs");
+		for (unsigned i = 0; i < classes.Size() && i < count; i++)
+		{
+			PClass *cls = classes[i];
+			Printf("%-32s %6u %8u %10u\n", cls->TypeName.GetChars(), cls->Size, cls->PoolLive, cls->PoolAllocs);
+		}
+	}
 	else if (stricmp(argv[1], "pause") == 0)
 	{
 		if (argv.argc() == 2)
@@ -25,8 +25,10 @@ enum EObjectFlags
 	OF_Transient		= 1 << 11,		// Object should not be archived (references to it will be nulled on disk)
 	OF_Spawned			= 1 << 12,      // Thinker was spawned at all (some thinkers get deleted before spawning)
 	OF_Released			= 1 << 13,		// Object was released from the GC system and should not be processed by GC function
+	OF_Parked			= 1 << 14,		// Actor is idle and only counts down its tics until something disturbs it
 };
 
+class PClass;
 template<class T> class TObjPtr;
 
 namespace GC
@@ -39,7 +41,8 @@ namespace GC
 		GCS_Finalize
 	};
 
-	// Number of bytes currently allocated through M_Malloc/M_Realloc.
+	// Number of bytes currently allocated through M_Malloc/M_Realloc and
+	// taken by live objects in the object pool.
 	extern size_t AllocBytes;
 
 	// Amount of memory to allocate before triggering a collection.
@@ -78,6 +81,15 @@ namespace GC
 	// Frees all objects, whether they're dead or not.
 	void FreeAll();
 
+	// Allocates memory for an object from the object pool.
+	void *AllocObject(size_t size);
+
+	// Returns an object's memory to the pool.
+	void FreeObject(void *mem);
+
+	// Counts a newly created object towards its class's pool statistics.
+	void CountObject(DObject *obj);
+
 	// Does one collection step.
 	void Step();
 
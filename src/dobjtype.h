@@ -64,6 +64,8 @@ public:
 	bool				 bDecorateClass = false;	// may be subject to some idiosyncracies due to DECORATE backwards compatibility
 	bool				 bAbstract = false;
 	bool				 bOptional = false;
+	unsigned			 PoolLive = 0;			// objects of this class that have not been freed yet
+	unsigned			 PoolAllocs = 0;			// objects of this class created so far
 	TArray<VMFunction*>	 Virtuals;	// virtual function table
 	TArray<FTypeAndOffset> MetaInits;
 	TArray<FTypeAndOffset> SpecialInits;
@@ -228,7 +228,9 @@ ADD_STAT (interpolations)
 	for (auto Level : AllLevels())
 	{
 		if (out.Len() > 0) out << '\n';
+		int active = Level->interpolator.CountActiveInterpolations ();
 		out.AppendFormat("%s: %d interpolations", Level->MapName.GetChars(), Level->interpolator.CountInterpolations ());
+		if (active >= 0) out.AppendFormat(", %d active", active);
 		
 	}
 	return out;
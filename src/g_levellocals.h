@@ -364,9 +364,11 @@ public:
 
 private:	// The engine should never ever access subsectors of the game nodes. This is only needed for actually implementing PointInSector.
 	subsector_t *PointInSubsector(double x, double y);
+	void PointInSubsector(unsigned count, const double *x, const double *y, subsector_t **result);
 public:
 	sector_t *PointInSectorBuggy(double x, double y);
 	subsector_t *PointInRenderSubsector (fixed_t x, fixed_t y);
+	void PointInRenderSubsector (unsigned count, const double *x, const double *y, subsector_t **result);
 
 	sector_t *PointInSector(const DVector2 &pos)
 	{
@@ -464,6 +466,8 @@ public:
 	TMap<int, FHealthGroup> healthGroups;
 
 	FBlockmap blockmap;
+	FSubsectorGrid subsectorgrid;		// for the game nodes
+	FSubsectorGrid rendersubsectorgrid;	// for the render nodes
 	TArray<polyblock_t *> PolyBlockMap;
 	FUDMFKeyMap UDMFKeys[4];
 
@@ -625,10 +629,12 @@ public:
 	DSeqNode *SequenceListHead;
 
 	// [RH] particle globals
-	uint32_t			ActiveParticles;
-	uint32_t			InactiveParticles;
-	TArray<particle_t>	Particles;
-	TArray<uint16_t>	ParticlesInSubsec;
+	FParticleStore		ParticleData;			// simulation state of all live particles
+	TArray<particle_t>	NewParticles;			// spawned since ParticleData was last updated
+	TArray<particle_t>	Particles;				// what the renderers see, rebuilt by P_FindParticleSubsectors
+	TArray<uint32_t>	ParticlesInSubsec;
+	unsigned			MaxParticles;
+	bool				ParticlesChanged;
 	FThinkerCollection Thinkers;
 
 	TArray<DVector2>	Scrolls;		// NULL if no DScrollers in this level
@@ -64,11 +64,17 @@
 #include "a_dynlight.h"
 #include "actorinlines.h"
 #include "memarena.h"
+#include "stats.h"
 
 static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
+static FMemArena LightNodeArena(sizeof(FLightNode) * 1024);
+static TArray<FLightNode*> FreeNodes;
 static FRandom randLight;
 
+static cycle_t LightLinkCycles;
+static int LightLinkCount, LightNodesAdded, LightNodesRemoved;
+
 extern TArray<FLightDefaults *> StateLights;
 
 
@@ -92,6 +98,7 @@ static FDynamicLight *GetLight(FLevelLocals *Level)
 	if (ret->next) ret->next->prev = ret;
 	ret->visibletoplayer = true;
 	ret->mShadowmapIndex = 1024;
+	ret->mRecordIndex = -1;
 	ret->Level = Level;
 	ret->Pos.X = -10000000;	// not a valid coordinate.
 	return ret;
@@ -408,6 +415,71 @@ void FDynamicLight::UpdateLocation()
 	}
 }
 
+//=============================================================================
+//
+// Maps the targets of a light's current nodes to the nodes, so that relinking
+// doesn't have to search the node lists for every side and section it touches.
+//
+//=============================================================================
+
+static struct FLightNodeMap
+{
+	TArray<FLightNode *> Buckets;
+	unsigned Mask = 0;
+	unsigned Used = 0;
+
+	static unsigned Hash(void *targ)
+	{
+		return unsigned((uintptr_t(targ) >> 3) * 2654435761u);
+	}
+
+	void Build(FLightNode *sides, FLightNode *sectors)
+	{
+		unsigned count = 0;
+		for (auto node = sides; node; node = node->nextTarget) count++;
+		for (auto node = sectors; node; node = node->nextTarget) count++;
+
+		Clear(count);
+		for (auto node = sides; node; node = node->nextTarget) Insert(node);
+		for (auto node = sectors; node; node = node->nextTarget) Insert(node);
+	}
+
+	void Clear(unsigned count)
+	{
+		unsigned size = 16;
+		while (size < count * 2) size <<= 1;
+		Buckets.Resize(size);
+		memset(Buckets.Data(), 0, size * sizeof(FLightNode *));
+		Mask = size - 1;
+		Used = 0;
+	}
+
+	void Insert(FLightNode *node)
+	{
+		if (Used * 2 >= Buckets.Size())
+		{
+			TArray<FLightNode *> old = std::move(Buckets);
+			Clear(Used + 1);
+			for (auto n : old) if (n != nullptr) Insert(n);
+		}
+		Used++;
+		unsigned i = Hash(node->targ) & Mask;
+		while (Buckets[i] != nullptr) i = (i + 1) & Mask;
+		Buckets[i] = node;
+	}
+
+	FLightNode *Find(void *targ) const
+	{
+		unsigned i = Hash(targ) & Mask;
+		while (Buckets[i] != nullptr)
+		{
+			if (Buckets[i]->targ == targ) return Buckets[i];
+			i = (i + 1) & Mask;
+		}
+		return nullptr;
+	}
+} LightNodeMap;
+
 //=============================================================================
 //
 // These have been copied from the secnode code and modified for the light links
@@ -423,24 +495,23 @@ FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * l
 {
 	FLightNode * node;
 
-	node = nextnode;
-	while (node)
-    {
-		if (node->targ==linkto)   // Already have a node for this sector?
-		{
-			node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
-			return(nextnode);
-		}
-		node = node->nextTarget;
-    }
+	node = LightNodeMap.Find(linkto);
+	if (node != nullptr)	// Already have a node for this sector?
+	{
+		node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
+		return(nextnode);
+	}
 
 	// Couldn't find an existing node for this sector. Add one at the head
 	// of the list.
 	
-	node = new FLightNode;
+	if (FreeNodes.Size()) FreeNodes.Pop(node);
+	else node = (FLightNode*)LightNodeArena.Alloc(sizeof(FLightNode));
+	LightNodesAdded++;
 	
 	node->targ = linkto;
 	node->lightsource = light; 
+	LightNodeMap.Insert(node);
 
 	node->prevTarget = &nextnode; 
 	node->nextTarget = nextnode;
@@ -480,7 +551,8 @@ static FLightNode * DeleteLightNode(FLightNode * node)
 		
 		// Return this node to the freelist
 		tn=node->nextTarget;
-		delete node;
+		FreeNodes.Push(node);
+		LightNodesRemoved++;
 		return(tn);
 	}
 	return(nullptr);
@@ -581,11 +653,20 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 			}
 		};
 
-		for (auto &segment : section->segments)
+		// Use the section's bounds to sort out the cases where either all or none of its segments are in range.
+		auto &bounds = section->bounds;
+		double nearx = clamp(pos.X, bounds.left, bounds.right) - pos.X;
+		double neary = clamp(pos.Y, bounds.top, bounds.bottom) - pos.Y;
+		double farx = MAX(pos.X - bounds.left, bounds.right - pos.X);
+		double fary = MAX(pos.Y - bounds.top, bounds.bottom - pos.Y);
+		bool allinrange = farx * farx + fary * fary <= radius;
+		bool noneinrange = nearx * nearx + neary * neary > radius;
+
+		if (!noneinrange) for (auto &segment : section->segments)
 		{
 			// check distance from x/y to seg and if within radius add this seg and, if present the opposing subsector (lather/rinse/repeat)
 			// If out of range we do not need to bother with this seg.
-			if (DistToSeg(pos, segment.start, segment.end) <= radius)
+			if ((allinrange && segment.start->fPos() != segment.end->fPos()) || DistToSeg(pos, segment.start, segment.end) <= radius)
 			{
 				auto sidedef = segment.sidedef;
 				if (sidedef)
@@ -656,6 +737,9 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 
 void FDynamicLight::LinkLight()
 {
+	LightLinkCycles.Clock();
+	LightLinkCount++;
+
 	// mark the old light nodes
 	FLightNode * node;
 	
@@ -671,6 +755,7 @@ void FDynamicLight::LinkLight()
 		node->lightsource = nullptr;
 		node = node->nextTarget;
 	}
+	LightNodeMap.Build(touching_sides, touching_sector);
 
 	if (radius>0)
 	{
@@ -707,8 +792,29 @@ void FDynamicLight::LinkLight()
 		else
 			node = node->nextTarget;
 	}
+	LightLinkCycles.Unclock();
+}
+
+
+//==========================================================================
+//
+// Light linking statistics, counted per tic
+//
+//==========================================================================
+
+void P_ResetLightLinkCounters()
+{
+	LightLinkCycles.Reset();
+	LightLinkCount = LightNodesAdded = LightNodesRemoved = 0;
 }
 
+ADD_STAT(lightlinks)
+{
+	FString out;
+	out.Format("Light links = %04.2f ms - %d relinks, %d nodes added, %d removed, %u pooled",
+		LightLinkCycles.TimeMS(), LightLinkCount, LightNodesAdded, LightNodesRemoved, FreeNodes.Size());
+	return out;
+}
 
 //==========================================================================
 //
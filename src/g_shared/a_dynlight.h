@@ -238,6 +238,7 @@ public:
 	int m_tickCount;
 	int m_lastUpdate;
 	int mShadowmapIndex;
+	int mRecordIndex;		// Renderer's light record for the current scene.
 	bool m_active;
 	bool visibletoplayer;
 	bool shadowmapped;
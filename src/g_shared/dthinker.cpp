@@ -45,6 +45,7 @@
 
 
 static int ThinkCount;
+static int ParkedCount;
 static cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
@@ -99,6 +100,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 	int i, count;
 
 	ThinkCount = 0;
+	ParkedCount = 0;
 	ThinkCycles.Reset();
 	BotSupportCycles.Reset();
 	ActionCycles.Reset();
@@ -572,9 +574,16 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 		if (!(node->ObjectFlags & OF_EuthanizeMe))
 		{ // Only tick thinkers not scheduled for destruction
 			ThinkCount++;
-			node->CallTick();
-			node->ObjectFlags &= ~OF_JustSpawned;
-			GC::CheckGC();
+			if ((node->ObjectFlags & OF_Parked) && static_cast<AActor*>(node)->TickParked())
+			{ // Idle actor that only needed to count down its tics
+				ParkedCount++;
+			}
+			else
+			{
+				node->CallTick();
+				node->ObjectFlags &= ~OF_JustSpawned;
+				GC::CheckGC();
+			}
 		}
 		node = NextToThink;
 	}
@@ -618,6 +627,12 @@ int FThinkerList::ProfileThinkers(FThinkerList *dest)
 		if (!(node->ObjectFlags & OF_EuthanizeMe))
 		{ // Only tick thinkers not scheduled for destruction
 			ThinkCount++;
+			if ((node->ObjectFlags & OF_Parked) && static_cast<AActor*>(node)->TickParked())
+			{
+				ParkedCount++;
+				node = NextToThink;
+				continue;
+			}
 
 			auto &prof = Profiles[node->GetClass()->TypeName];
 			prof.numcalls++;
@@ -1003,3 +1018,17 @@ ADD_STAT (think)
 	out.Format ("Think time = %04.2f ms - %d thinkers, Action = %04.2f ms", ThinkCycles.TimeMS(), ThinkCount, ActionCycles.TimeMS());
 	return out;
 }
+
+//==========================================================================
+//
+// Shows how many thinkers were skipped by sv_parkidleactors. Toggle the
+// CVAR during a timedemo to compare the think time.
+//
+//==========================================================================
+
+ADD_STAT (parked)
+{
+	FString out;
+	out.Format ("Parked actors = %d of %d thinkers, Think time = %04.2f ms", ParkedCount, ThinkCount, ThinkCycles.TimeMS());
+	return out;
+}
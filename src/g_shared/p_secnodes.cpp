@@ -26,7 +26,9 @@
 
 #include "g_levellocals.h"
 #include "p_maputl.h"
+#include "p_local.h"
 #include "actor.h"
+#include "stats.h"
 
 //=============================================================================
 // phares 3/21/98
@@ -37,6 +39,17 @@
 msecnode_t *headsecnode = nullptr;
 FMemArena secnodearena;
 
+// Bumped whenever a node gets added to or removed from a thing list, so that
+// code walking these lists knows when it has to start over.
+unsigned secnodechanges;
+
+// Bumped whenever lines move. This invalidates all cached sector list areas.
+int seclistepoch;
+
+static int SecListRelinks;
+static int SecListSkips;
+static unsigned SecListChangesStart;
+
 //=============================================================================
 //
 // P_GetSecnode
@@ -116,6 +129,7 @@ nodetype *P_AddSecnode(linktype *s, AActor *thing, nodetype *nextnode, nodetype
 
 	// killough 4/4/98, 4/7/98: mark new nodes unvisited.
 	node->visited = 0;
+	secnodechanges++;
 
 	node->m_sector = s; 			// sector
 	node->m_thing = thing; 		// mobj
@@ -182,6 +196,7 @@ nodetype *P_DelSecnode(nodetype *node, nodetype *linktype::*listhead)
 		// Return this node to the freelist
 
 		P_PutSecnode((msecnode_t*)node);
+		secnodechanges++;
 		return tn;
 	}
 	return nullptr;
@@ -211,6 +226,45 @@ void P_DelSeclist(portnode_t *node, portnode_t *FLinePortal::*sechead)
 }
 
 
+//=============================================================================
+//
+// P_GetSecListExtent
+//
+// Returns the half size of the largest area around the thing in which a box
+// of the given radius cannot touch anything but the thing's own sector, or 0
+// if there is none. The line checks are the same as in P_CreateSecNodeList,
+// so a smaller box can't cross any line the area doesn't cross.
+//
+//=============================================================================
+
+static double P_GetSecListExtent(AActor *thing, double radius)
+{
+	static const double slack[] = { 64., 32., 16., 8. };
+	unsigned level = 0;
+
+	FBoundingBox box(thing->X(), thing->Y(), radius + slack[0]);
+	FBlockLinesIterator it(thing->Level, box);
+	line_t *ld;
+
+	while ((ld = it.Next()))
+	{
+		// Lines that only border the thing's own sector can't add anything to the list.
+		if (ld->frontsector == thing->Sector && (ld->backsector == nullptr || ld->backsector == thing->Sector))
+			continue;
+
+		while (level < countof(slack))
+		{
+			FBoundingBox lbox(thing->X(), thing->Y(), radius + slack[level]);
+			if (!lbox.inRange(ld) || lbox.BoxOnLineSide(ld) != -1)
+				break;
+			level++;
+		}
+		if (level == countof(slack))
+			return 0;
+	}
+	return radius + slack[level];
+}
+
 //=============================================================================
 // phares 3/14/98
 //
@@ -218,12 +272,25 @@ void P_DelSeclist(portnode_t *node, portnode_t *FLinePortal::*sechead)
 //
 // Alters/creates the sector_list that shows what sectors the object resides in
 //
+// If a cache is passed and the thing only moved inside the area in which it
+// can't touch anything but its own sector, the list is returned unchanged.
+//
 //=============================================================================
 
-msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead)
+msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead, FSecListCache *cache)
 {
 	msecnode_t *node;
 
+	if (cache != nullptr && cache->Extent > 0 && cache->Epoch == seclistepoch &&
+		sector_list != nullptr && sector_list->m_tnext == nullptr && sector_list->m_sector == thing->Sector &&
+		fabs(thing->X() - cache->Pos.X) + radius <= cache->Extent &&
+		fabs(thing->Y() - cache->Pos.Y) + radius <= cache->Extent)
+	{
+		SecListSkips++;
+		return sector_list;
+	}
+	SecListRelinks++;
+
 	// First, clear out the existing m_thing fields. As each node is
 	// added or verified as needed, m_thing will be set properly. When
 	// finished, delete all nodes where m_thing is still nullptr. These
@@ -286,9 +353,36 @@ msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector
 			node = node->m_tnext;
 		}
 	}
+
+	if (cache != nullptr)
+	{
+		cache->Pos = thing->Pos().XY();
+		cache->Epoch = seclistepoch;
+		cache->Extent = (sector_list != nullptr && sector_list->m_tnext == nullptr) ? P_GetSecListExtent(thing, radius) : 0;
+	}
 	return sector_list;
 }
 
+//=============================================================================
+//
+// Relink statistics are collected per tic
+//
+//=============================================================================
+
+void P_ResetSecnodeStats()
+{
+	SecListRelinks = 0;
+	SecListSkips = 0;
+	SecListChangesStart = secnodechanges;
+}
+
+ADD_STAT(secnodes)
+{
+	FString out;
+	out.Format("Sector list relinks = %d, skipped = %d, list changes = %u", SecListRelinks, SecListSkips, secnodechanges - SecListChangesStart);
+	return out;
+}
+
 //=============================================================================
 //
 // P_DelPortalnode
@@ -467,9 +561,8 @@ FBlockNode *FBlockNode::Create(AActor *who, int x, int y, int group)
 		block = (FBlockNode *)secnodearena.Alloc(sizeof(FBlockNode));
 	}
 	block->BlockIndex = x + y * who->Level->blockmap.bmapwidth;
+	block->CellIndex = -1;
 	block->Me = who;
-	block->NextActor = nullptr;
-	block->PrevActor = nullptr;
 	block->PrevBlock = nullptr;
 	block->NextBlock = nullptr;
 	return block;
@@ -163,6 +163,7 @@ bool Trace(const DVector3 &start, sector_t *sector, const DVector3 &direction, d
 	inf.Start = start;
 	GetPortalTransition(inf.Start, sector);
 	inf.ptflags = actorMask ? PT_ADDLINES|PT_ADDTHINGS|PT_COMPATIBLE : PT_ADDLINES;
+	if (flags & TRACE_ShareOrigin) inf.ptflags |= PT_SHAREORIGIN;
 	inf.Vec = direction;
 	inf.ActorMask = actorMask;
 	inf.WallMask = wallMask;
@@ -100,6 +100,7 @@ enum
 	TRACE_ReportPortals = 0x0010,	// Report any portal crossing to the TraceCallback
 	TRACE_3DCallback	= 0x0020,	// [ZZ] use TraceCallback to determine whether we need to go through a line to do 3D floor check, or not. without this, only line flag mask is used
 	TRACE_HitSky		= 0x0040,	// Hitting the sky returns TRACE_HasHitSky
+	TRACE_ShareOrigin	= 0x0080,	// Reuse the blockmap lines collected by the last trace from the same spot
 };
 
 // return values from callback
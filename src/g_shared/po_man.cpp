@@ -994,6 +994,9 @@ void FPolyObj::UnLinkPolyobj ()
 	int i, j;
 	int index;
 
+	// The lines are about to move so cached sector list areas are no longer valid.
+	seclistepoch++;
+
 	// remove the polyobj from each blockmap section
 	for(j = bbox[BOXBOTTOM]; j <= bbox[BOXTOP]; j++)
 	{
@@ -1026,7 +1029,6 @@ void FPolyObj::UnLinkPolyobj ()
 bool FPolyObj::CheckMobjBlocking (side_t *sd)
 {
 	static TArray<AActor *> checker;
-	FBlockNode *block;
 	AActor *mobj;
 	int i, j, k;
 	int left, right, top, bottom;
@@ -1059,9 +1061,11 @@ bool FPolyObj::CheckMobjBlocking (side_t *sd)
 	{
 		for (i = left; i <= right; i++)
 		{
-			for (block = Level->blockmap.blocklinks[j+i]; block != nullptr; block = block->NextActor)
+			auto &entries = Level->blockmap.blockcells[j+i].Entries;
+			for (int l = (int)entries.Size() - 1; l >= 0; l--)
 			{
-				mobj = block->Me;
+				mobj = entries[l].Me;
+				if (mobj == nullptr) continue;
 				for (k = (int)checker.Size()-1; k >= 0; --k)
 				{
 					if (checker[k] == mobj)
@@ -1163,6 +1167,9 @@ void FPolyObj::LinkPolyobj ()
 	int bmapwidth = Level->blockmap.bmapwidth;
 	int bmapheight = Level->blockmap.bmapheight;
 
+	// The lines are about to move so cached sector list areas are no longer valid.
+	seclistepoch++;
+
 	// calculate the polyobj bbox
 	Bounds.ClearBox();
 	for(unsigned i = 0; i < Sidedefs.Size(); i++)
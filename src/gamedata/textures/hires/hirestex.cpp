@@ -360,16 +360,21 @@ int FTexture::CheckExternalFile(bool & hascolorkey)
 
 bool FTexture::LoadHiresTexture(FTextureBuffer &texbuffer, bool checkonly)
 {
-	if (HiresLump == -1)
 	{
-		bHiresHasColorKey = false;
-		HiresLump = CheckDDPK3();
-		if (HiresLump < 0) HiresLump = CheckExternalFile(bHiresHasColorKey);
-
-		if (HiresLump >= 0)
+		// Looking for the replacement searches the file system and adds a texture, so it must be serialized
+		// with all other image and lump reads. The rest only reads through the image source and converts.
+		std::lock_guard<std::recursive_mutex> lock(FImageSource::DecodeMutex);
+		if (HiresLump == -1)
 		{
-			HiresTexture = FTexture::CreateTexture("", HiresLump, ETextureType::Any);
-			TexMan.AddTexture(HiresTexture);	// let the texture manager manage this.
+			bHiresHasColorKey = false;
+			HiresLump = CheckDDPK3();
+			if (HiresLump < 0) HiresLump = CheckExternalFile(bHiresHasColorKey);
+
+			if (HiresLump >= 0)
+			{
+				HiresTexture = FTexture::CreateTexture("", HiresLump, ETextureType::Any);
+				TexMan.AddTexture(HiresTexture);	// let the texture manager manage this.
+			}
 		}
 	}
 	if (HiresTexture != nullptr)
@@ -25,6 +25,11 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HQX_SSE2
+#include <emmintrin.h>
+#endif
+
 #define MASK_2     0x0000FF00
 #define MASK_13    0x00FF00FF
 #define MASK_RGB   0x00FFFFFF
@@ -58,6 +63,123 @@ static inline int Diff(uint32_t c1, uint32_t c2)
     return yuv_diff(rgb_to_yuv(c1), rgb_to_yuv(c2));
 }
 
+#ifdef HQX_SSE2
+// yuv_diff for four neighbours at once. Returns one bit per lane.
+static inline int yuv_diff4(__m128i center, __m128i neighbours)
+{
+    const __m128i masks[3] = { _mm_set1_epi32(Ymask), _mm_set1_epi32(Umask), _mm_set1_epi32(Vmask) };
+    const __m128i limits[3] = { _mm_set1_epi32(trY), _mm_set1_epi32(trU), _mm_set1_epi32(trV) };
+
+    __m128i result = _mm_setzero_si128();
+    for (int i = 0; i < 3; i++)
+    {
+        __m128i d = _mm_sub_epi32(_mm_and_si128(center, masks[i]), _mm_and_si128(neighbours, masks[i]));
+        __m128i sign = _mm_srai_epi32(d, 31);
+        d = _mm_sub_epi32(_mm_xor_si128(d, sign), sign);
+        result = _mm_or_si128(result, _mm_cmpgt_epi32(d, limits[i]));
+    }
+    return _mm_movemask_ps(_mm_castsi128_ps(result));
+}
+#endif
+
+// Keeps the YUV values of the rows above, at and below the one being scaled, so that every
+// source pixel gets converted once instead of once for each of its nine neighbourhoods.
+// The rows are padded by repeating the edge pixels, which is how the kernels treat the border.
+class HQXYuvRows
+{
+public:
+    HQXYuvRows(const uint32_t *src, uint32_t srcRowBytes, int width, int height, int y)
+        : src((const uint8_t *)src), rowBytes(srcRowBytes), width(width), height(height), y(y)
+    {
+        buffer = new uint32_t[3 * (width + 2)];
+        for (int i = 0; i < 3; i++) rows[i] = buffer + i * (width + 2) + 1;
+        Convert(rows[0], y > 0 ? y - 1 : y);
+        Convert(rows[1], y);
+        Convert(rows[2], y < height - 1 ? y + 1 : y);
+    }
+
+    ~HQXYuvRows()
+    {
+        delete[] buffer;
+    }
+
+    void Next()
+    {
+        y++;
+        uint32_t *oldest = rows[0];
+        rows[0] = rows[1];
+        rows[1] = rows[2];
+        rows[2] = oldest;
+        if (y < height) Convert(rows[2], y < height - 1 ? y + 1 : y);
+    }
+
+    // Bit n is set if neighbour n (w1-w4, w6-w9) differs from the center pixel w5
+    int Pattern(int x, const uint32_t *w) const
+    {
+        const uint32_t *prev = rows[0] + x;
+        const uint32_t *cur = rows[1] + x;
+        const uint32_t *next = rows[2] + x;
+#ifdef HQX_SSE2
+        __m128i center = _mm_set1_epi32(cur[0]);
+        __m128i upper = _mm_setr_epi32(prev[-1], prev[0], prev[1], cur[-1]);
+        __m128i lower = _mm_setr_epi32(cur[1], next[-1], next[0], next[1]);
+        return yuv_diff4(center, upper) | (yuv_diff4(center, lower) << 4);
+#else
+        const uint32_t neighbours[8] = { prev[-1], prev[0], prev[1], cur[-1], cur[1], next[-1], next[0], next[1] };
+        int pattern = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            if (yuv_diff(cur[0], neighbours[k])) pattern |= 1 << k;
+        }
+        return pattern;
+#endif
+    }
+
+private:
+    void Convert(uint32_t *row, int srcY)
+    {
+        const uint32_t *line = (const uint32_t *)(src + srcY * rowBytes);
+        for (int i = 0; i < width; i++) row[i] = rgb_to_yuv(line[i]);
+        row[-1] = row[0];
+        row[width] = row[width - 1];
+    }
+
+    const uint8_t *src;
+    uint32_t rowBytes;
+    int width, height, y;
+    uint32_t *buffer;
+    uint32_t *rows[3];
+};
+
+// The original pattern test, which converts all nine pixels of every neighbourhood.
+// Has the same interface as HQXYuvRows so that the kernels can use either one.
+class HQXPixelPattern
+{
+public:
+    HQXPixelPattern(const uint32_t *src, uint32_t srcRowBytes, int width, int height, int y)
+    {
+    }
+
+    void Next()
+    {
+    }
+
+    int Pattern(int x, const uint32_t *w) const
+    {
+        int pattern = 0;
+        int flag = 1;
+        uint32_t yuv1 = rgb_to_yuv(w[5]);
+        for (int k = 1; k <= 9; k++)
+        {
+            if (k == 5) continue;
+            if (w[k] != w[5] && yuv_diff(yuv1, rgb_to_yuv(w[k])))
+                pattern |= flag;
+            flag <<= 1;
+        }
+        return pattern;
+    }
+};
+
 /* Interpolate functions */
 static inline uint32_t Interpolate_2(uint32_t c1, int w1, uint32_t c2, int w2, int s)
 {
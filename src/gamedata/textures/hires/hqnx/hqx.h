@@ -44,6 +44,8 @@
 #endif
 
 HQX_API void HQX_CALLCONV hqxInit(void);
+
+/* Scale the whole image with the original per pixel pattern test */
 HQX_API void HQX_CALLCONV hq2x_32( uint32_t * src, uint32_t * dest, int width, int height );
 HQX_API void HQX_CALLCONV hq3x_32( uint32_t * src, uint32_t * dest, int width, int height );
 HQX_API void HQX_CALLCONV hq4x_32( uint32_t * src, uint32_t * dest, int width, int height );
@@ -52,4 +54,13 @@ HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uin
 HQX_API void HQX_CALLCONV hq3x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 
+/* Scale only the source rows yFirst to yLast-1 with the cached YUV rows. The whole source image must be passed in. */
+HQX_API void HQX_CALLCONV hq2x_32_slice( uint32_t * src, uint32_t * dest, int width, int height, int yFirst, int yLast );
+HQX_API void HQX_CALLCONV hq3x_32_slice( uint32_t * src, uint32_t * dest, int width, int height, int yFirst, int yLast );
+HQX_API void HQX_CALLCONV hq4x_32_slice( uint32_t * src, uint32_t * dest, int width, int height, int yFirst, int yLast );
+
+HQX_API void HQX_CALLCONV hq2x_32_rb_slice( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
+HQX_API void HQX_CALLCONV hq3x_32_rb_slice( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
+HQX_API void HQX_CALLCONV hq4x_32_rb_slice( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
+
 #endif
@@ -44,6 +44,20 @@
 #include "xbr/xbrz_old.h"
 #include "parallel_for.h"
 #include "hwrenderer/textures/hw_material.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "files.h"
+#include "md5.h"
+#include "stats.h"
+#include "c_dispatch.h"
+#include "doomerrors.h"
+#include "templates.h"
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 EXTERN_CVAR(Int, gl_texture_hqresizemult)
 CUSTOM_CVAR(Int, gl_texture_hqresizemode, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
@@ -93,6 +107,9 @@ CUSTOM_CVAR(Int, gl_texture_hqresize_mt_height, 4, CVAR_ARCHIVE | CVAR_GLOBALCON
 	if (self > 1024) self = 1024;
 }
 
+CVAR(Bool, gl_texture_hqresize_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR(Int, gl_texture_hqresize_cache_size, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// in megabytes, 0 means no limit
+
 
 static void scale2x ( uint32_t* inputBuffer, uint32_t* outputBuffer, int inWidth, int inHeight )
 {
@@ -258,13 +275,8 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		HQnX_asm::InitLUTs();
-		initdone = true;
-	}
+	// Textures may be upscaled on the main thread and the texture streamer's thread at the same time.
+	static const bool initdone = (HQnX_asm::InitLUTs(), true);
 
 	HQnX_asm::CImage cImageIn;
 	cImageIn.SetImage(inputBuffer, inWidth, inHeight, 32);
@@ -277,7 +289,49 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 }
 #endif
 
-static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*, unsigned*, int, int ),
+//===========================================================================
+// 
+// Splits the rows of a texture into tiles that the workers keep taking
+// until all are done. A tile that takes longer than the others does not
+// hold up a whole fixed share of the image that way.
+//
+//===========================================================================
+
+template<typename Function>
+static void ScaleTiles(const int inWidth, const int inHeight, bool multithread, const Function &scaleRows)
+{
+	const int thresholdWidth  = gl_texture_hqresize_mt_width;
+	const int thresholdHeight = gl_texture_hqresize_mt_height;
+
+	if (!multithread || inWidth <= thresholdWidth || inHeight <= thresholdHeight)
+	{
+		scaleRows(0, inHeight);
+		return;
+	}
+
+	// Several tiles per worker so that the load can even out, but not so small that the scalers' setup per call dominates.
+	int numWorkers = MAX(1, (int)std::thread::hardware_concurrency());
+	int tileRows = MAX(thresholdHeight, inHeight / (numWorkers * 4));
+	int numTiles = (inHeight + tileRows - 1) / tileRows;
+	numWorkers = MIN(numWorkers, numTiles);
+
+	std::atomic<int> nextTile(0);
+	parallel_for(numWorkers, [&](int worker)
+	{
+		for (int tile = nextTile++; tile < numTiles; tile = nextTile++)
+		{
+			scaleRows(tile * tileRows, MIN(inHeight, (tile + 1) * tileRows));
+		}
+	});
+}
+
+static void InitHqx()
+{
+	// Textures may be upscaled on the main thread and the texture streamer's thread at the same time.
+	static const bool initdone = (hqxInit(), true);
+}
+
+static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( uint32_t*, uint32_t*, int, int, int, int ),
 							  const int N,
 							  unsigned char *inputBuffer,
 							  const int inWidth,
@@ -285,18 +339,15 @@ static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*,
 							  int &outWidth,
 							  int &outHeight )
 {
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		hqxInit();
-		initdone = true;
-	}
+	InitHqx();
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
-	hqNxFunction( reinterpret_cast<unsigned*>(inputBuffer), reinterpret_cast<unsigned*>(newBuffer), inWidth, inHeight );
+	ScaleTiles(inWidth, inHeight, gl_texture_hqresize_multithread, [=](int yFirst, int yLast)
+	{
+		hqNxFunction(reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer), inWidth, inHeight, yFirst, yLast);
+	});
 	delete[] inputBuffer;
 	return newBuffer;
 }
@@ -315,25 +366,12 @@ static unsigned char *xbrzHelper( void (*xbrzFunction) ( size_t, const uint32_t*
 	outHeight = N *inHeight;
 
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
-	
-	const int thresholdWidth  = gl_texture_hqresize_mt_width;
-	const int thresholdHeight = gl_texture_hqresize_mt_height;
-	
-	if (gl_texture_hqresize_multithread
-		&& inWidth  > thresholdWidth
-		&& inHeight > thresholdHeight)
-	{
-		parallel_for(inHeight, thresholdHeight, [=](int sliceY)
-		{
-			xbrzFunction(N, reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer),
-				inWidth, inHeight, xbrz::ColorFormat::ARGB, xbrz::ScalerCfg(), sliceY, sliceY + thresholdHeight);
-		});
-	}
-	else
+
+	ScaleTiles(inWidth, inHeight, gl_texture_hqresize_multithread, [=](int yFirst, int yLast)
 	{
 		xbrzFunction(N, reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer),
-			inWidth, inHeight, xbrz::ColorFormat::ARGB, xbrz::ScalerCfg(), 0, std::numeric_limits<int>::max());
-	}
+			inWidth, inHeight, xbrz::ColorFormat::ARGB, xbrz::ScalerCfg(), yFirst, yLast);
+	});
 
 	delete[] inputBuffer;
 	return newBuffer;
@@ -346,6 +384,252 @@ static void xbrzOldScale(size_t factor, const uint32_t* src, uint32_t* trg, int
 }
 
 
+//===========================================================================
+// 
+// Disk cache for upscaled textures
+//
+// The result only depends on the source pixels and the scaler, so it is
+// stored under the hash of those and reused by every later run, no matter
+// which texture the pixels came from.
+//
+//===========================================================================
+
+// Increase this when a scaler's output changes so that old results are not picked up anymore.
+static const uint32_t UpscaleCacheVersion = 1;
+static const char UpscaleCacheMagic[4] = { 'U', 'P', 'S', 'C' };
+
+static cycle_t UpscaleCycles;
+static cycle_t UpscaleCacheCycles;
+static int UpscaleCount;
+static int UpscaleCacheHits;
+static int UpscaleCacheWrites;
+static int64_t UpscaleCacheBytes = -1;	// size of the cache directory, -1 if it has not been scanned yet
+
+// Guards the statistics and the cache directory. The scalers themselves run without it.
+static std::mutex UpscaleCacheMutex;
+
+ADD_STAT(upscale)
+{
+	FString out;
+	out.Format("Upscaled textures: %d, cache hits: %d, written: %d\nscaling=%2.3f ms, cache=%2.3f ms",
+		UpscaleCount, UpscaleCacheHits, UpscaleCacheWrites, UpscaleCycles.TimeMS(), UpscaleCacheCycles.TimeMS());
+	return out;
+}
+
+static FString GetUpscaleCachePath(bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/upscale";
+	if (create) CreatePath(path);
+	return path;
+}
+
+static FString GetUpscaleCacheName(const unsigned char *buffer, int width, int height, int type, int mult)
+{
+	uint32_t header[5] = { UpscaleCacheVersion, (uint32_t)width, (uint32_t)height, (uint32_t)type, (uint32_t)mult };
+	for (auto &v : header) v = LittleLong(v);
+
+	uint8_t digest[16];
+	MD5Context md5;
+	md5.Update((const uint8_t *)header, sizeof(header));
+	md5.Update(buffer, width * height * 4);
+	md5.Final(digest);
+
+	FString path = GetUpscaleCachePath(false);
+	path << '/';
+	for (int i = 0; i < 16; i++) path.AppendFormat("%02x", digest[i]);
+	path << ".upc";
+	return path;
+}
+
+static unsigned char *LoadUpscaledTexture(const FString &path, int outWidth, int outHeight)
+{
+	FileReader fr;
+	if (!fr.OpenFile(path)) return nullptr;
+
+	char magic[4];
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, UpscaleCacheMagic, 4)) return nullptr;
+	uint32_t width = fr.ReadUInt32();
+	uint32_t height = fr.ReadUInt32();
+	uint32_t compressedsize = fr.ReadUInt32();
+	if (width != (uint32_t)outWidth || height != (uint32_t)outHeight) return nullptr;
+
+	// Don't trust the size from the file. It must fit in what is left of it and can't exceed what zlib would produce for this image.
+	uLong rawsize = uLong(outWidth) * outHeight * 4;
+	if (compressedsize > (uint32_t)(fr.GetLength() - fr.Tell()) || compressedsize > compressBound(rawsize)) return nullptr;
+
+	TArray<Bytef> compressed(compressedsize, true);
+	if (fr.Read(compressed.Data(), compressedsize) != compressedsize) return nullptr;
+
+	uLongf size = rawsize;
+	unsigned char *buffer = new unsigned char[size];
+	if (uncompress(buffer, &size, compressed.Data(), compressedsize) != Z_OK || size != rawsize)
+	{
+		delete[] buffer;
+		return nullptr;
+	}
+	return buffer;
+}
+
+static void SaveUpscaledTexture(const FString &path, const unsigned char *buffer, int width, int height)
+{
+	uLong size = width * height * 4;
+	uLongf compressedsize = compressBound(size);
+	TArray<Bytef> compressed(compressedsize + 16, true);
+	if (compress2(compressed.Data() + 16, &compressedsize, buffer, size, Z_BEST_SPEED) != Z_OK) return;
+
+	uint32_t header[3] = { LittleLong((uint32_t)width), LittleLong((uint32_t)height), LittleLong((uint32_t)compressedsize) };
+	memcpy(compressed.Data(), UpscaleCacheMagic, 4);
+	memcpy(compressed.Data() + 4, header, 12);
+
+	// A partially written file fails the size check when loading, so there is no need to clean up after errors.
+	FileWriter *fw = FileWriter::Open(path);
+	if (fw != nullptr)
+	{
+		if (fw->Write(compressed.Data(), compressedsize + 16) == compressedsize + 16)
+		{
+			UpscaleCacheWrites++;
+			if (UpscaleCacheBytes >= 0) UpscaleCacheBytes += compressedsize + 16;
+		}
+		delete fw;
+	}
+}
+
+//===========================================================================
+// 
+// Keeps the cache below gl_texture_hqresize_cache_size by deleting the
+// least recently used files. Cache hits touch their file for this. It trims down to three quarters of the limit so that this
+// does not need to run again right after the next few writes.
+//
+//===========================================================================
+
+struct FUpscaleCacheFile
+{
+	FString Filename;
+	size_t Size;
+	time_t Time;
+};
+
+static void TrimUpscaleCache()
+{
+	int64_t limit = int64_t(gl_texture_hqresize_cache_size) << 20;
+	if (limit <= 0) return;
+	if (UpscaleCacheBytes >= 0 && UpscaleCacheBytes <= limit) return;
+
+	TArray<FFileList> list;
+	FString path = GetUpscaleCachePath(false);
+	path += "/";
+	try
+	{
+		ScanDirectory(list, path);
+	}
+	catch (CRecoverableError &)
+	{
+		return;
+	}
+
+	TArray<FUpscaleCacheFile> files;
+	int64_t total = 0;
+	for (auto &entry : list)
+	{
+		FUpscaleCacheFile file;
+		if (entry.isDirectory || entry.Filename.Right(4).CompareNoCase(".upc") != 0) continue;
+		if (!GetFileInfo(entry.Filename, &file.Size, &file.Time)) continue;
+		file.Filename = entry.Filename;
+		total += file.Size;
+		files.Push(file);
+	}
+
+	if (total > limit)
+	{
+		std::sort(files.begin(), files.end(), [](const FUpscaleCacheFile &a, const FUpscaleCacheFile &b) { return a.Time < b.Time; });
+		for (auto &file : files)
+		{
+			if (total <= limit * 3 / 4) break;
+			if (remove(file.Filename) == 0) total -= file.Size;
+		}
+	}
+	UpscaleCacheBytes = total;
+}
+
+UNSAFE_CCMD(clearupscalecache)
+{
+	TArray<FFileList> list;
+	FString path = GetUpscaleCachePath(false);
+	path += "/";
+
+	try
+	{
+		ScanDirectory(list, path);
+	}
+	catch (CRecoverableError &err)
+	{
+		Printf("%s\n", err.GetMessage());
+		return;
+	}
+
+	int count = 0;
+	for (auto &entry : list)
+	{
+		if (entry.isDirectory || entry.Filename.Right(4).CompareNoCase(".upc") != 0) continue;
+		if (remove(entry.Filename) == 0) count++;
+	}
+	std::lock_guard<std::mutex> lock(UpscaleCacheMutex);
+	UpscaleCacheBytes = -1;
+	Printf("%d cached textures removed\n", count);
+}
+
+//===========================================================================
+// 
+// Runs the selected scaler. Returns false if there is none for the given settings.
+//
+//===========================================================================
+
+static bool RunUpscaler(int type, int mult, unsigned char *&buffer, int inWidth, int inHeight, int &outWidth, int &outHeight)
+{
+	if (type == 1)
+	{
+		if (mult == 2)
+			buffer = scaleNxHelper(&scale2x, 2, buffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 3)
+			buffer = scaleNxHelper(&scale3x, 3, buffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 4)
+			buffer = scaleNxHelper(&scale4x, 4, buffer, inWidth, inHeight, outWidth, outHeight);
+		else return false;
+	}
+	else if (type == 2)
+	{
+		if (mult == 2)
+			buffer = hqNxHelper(&hq2x_32_slice, 2, buffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 3)
+			buffer = hqNxHelper(&hq3x_32_slice, 3, buffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 4)
+			buffer = hqNxHelper(&hq4x_32_slice, 4, buffer, inWidth, inHeight, outWidth, outHeight);
+		else return false;
+	}
+#ifdef HAVE_MMX
+	else if (type == 3)
+	{
+		if (mult == 2)
+			buffer = hqNxAsmHelper(&HQnX_asm::hq2x_32, 2, buffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 3)
+			buffer = hqNxAsmHelper(&HQnX_asm::hq3x_32, 3, buffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 4)
+			buffer = hqNxAsmHelper(&HQnX_asm::hq4x_32, 4, buffer, inWidth, inHeight, outWidth, outHeight);
+		else return false;
+	}
+#endif
+	else if (type == 4)
+		buffer = xbrzHelper(xbrz::scale, mult, buffer, inWidth, inHeight, outWidth, outHeight);
+	else if (type == 5)
+		buffer = xbrzHelper(xbrzOldScale, mult, buffer, inWidth, inHeight, outWidth, outHeight);
+	else if (type == 6)
+		buffer = normalNxHelper(&normalNx, mult, buffer, inWidth, inHeight, outWidth, outHeight);
+	else
+		return false;
+	return true;
+}
+
 //===========================================================================
 // 
 // [BB] Upsamples the texture in texbuffer.mBuffer, frees texbuffer.mBuffer and returns
@@ -402,46 +686,50 @@ void FTexture::CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasA
 
 	if (!checkonly)
 	{
-		if (type == 1)
+		std::unique_lock<std::mutex> lock(UpscaleCacheMutex);
+		UpscaleCount++;
+
+		FString cachename;
+		unsigned char *cached = nullptr;
+		if (gl_texture_hqresize_cache)
 		{
-			if (mult == 2)
-				texbuffer.mBuffer = scaleNxHelper(&scale2x, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = scaleNxHelper(&scale3x, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = scaleNxHelper(&scale4x, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
+			UpscaleCacheCycles.Clock();
+			cachename = GetUpscaleCacheName(texbuffer.mBuffer, inWidth, inHeight, type, mult);
+			cached = LoadUpscaledTexture(cachename, inWidth * mult, inHeight * mult);
+			UpscaleCacheCycles.Unclock();
 		}
-		else if (type == 2)
+
+		if (cached != nullptr)
 		{
-			if (mult == 2)
-				texbuffer.mBuffer = hqNxHelper(&hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = hqNxHelper(&hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = hqNxHelper(&hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
+			// Keeps the file from being trimmed while it is still in use.
+			TouchFile(cachename);
+			UpscaleCacheHits++;
+			delete[] texbuffer.mBuffer;
+			texbuffer.mBuffer = cached;
+			texbuffer.mWidth = inWidth * mult;
+			texbuffer.mHeight = inHeight * mult;
 		}
-#ifdef HAVE_MMX
-		else if (type == 3)
+		else
 		{
-			if (mult == 2)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
+			// The clock only adds up start and end times, so overlapping calls still give the right total.
+			UpscaleCycles.Clock();
+			lock.unlock();
+			bool scaled = RunUpscaler(type, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+			lock.lock();
+			UpscaleCycles.Unclock();
+			if (!scaled) return;
+
+			if (gl_texture_hqresize_cache)
+			{
+				static bool pathcreated = false;
+				UpscaleCacheCycles.Clock();
+				if (!pathcreated) GetUpscaleCachePath(true);
+				pathcreated = true;
+				SaveUpscaledTexture(cachename, texbuffer.mBuffer, texbuffer.mWidth, texbuffer.mHeight);
+				TrimUpscaleCache();
+				UpscaleCacheCycles.Unclock();
+			}
 		}
-#endif
-		else if (type == 4)
-			texbuffer.mBuffer = xbrzHelper(xbrz::scale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else if (type == 5)
-			texbuffer.mBuffer = xbrzHelper(xbrzOldScale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else if (type == 6)
-			texbuffer.mBuffer = normalNxHelper(&normalNx, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else
-			return;
 	}
 	else
 	{
@@ -455,3 +743,102 @@ void FTexture::CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasA
 	contentId.scalefactor = mult;
 	texbuffer.mContentId = contentId.id;
 }
+
+//===========================================================================
+// 
+// Compares the tiled and vectorized scalers with the plain single threaded
+// ones on a selection of the loaded textures and checks that they produce
+// the same pixels.
+//
+// bench_upscale [mode] [multiplier] [textures per type]
+//
+//===========================================================================
+
+CCMD(bench_upscale)
+{
+	int type = argv.argc() > 1 ? atoi(argv[1]) : 4;
+	int mult = argv.argc() > 2 ? atoi(argv[2]) : 4;
+	int perType = argv.argc() > 3 ? atoi(argv[3]) : 16;
+
+	if (type != 2 && type != 4 && type != 5)
+	{
+		Printf("Only modes 2 (hqNx), 4 (xBRZ) and 5 (old xBRZ) can be benchmarked\n");
+		return;
+	}
+	if (mult < 2 || mult > (type == 2 ? 4 : 6))
+	{
+		Printf("Invalid multiplier %d for mode %d\n", mult, type);
+		return;
+	}
+
+	// Mix large and tiny images
+	static const ETextureType types[] = { ETextureType::Wall, ETextureType::Flat, ETextureType::Sprite, ETextureType::FontChar };
+	TArray<FTexture *> textures;
+	for (auto useType : types)
+	{
+		int count = 0;
+		for (int i = 0; i < TexMan.NumTextures() && count < perType; i++)
+		{
+			FTexture *tex = TexMan.ByIndex(i);
+			if (tex != nullptr && tex->GetUseType() == useType && tex->GetImage() != nullptr)
+			{
+				textures.Push(tex);
+				count++;
+			}
+		}
+	}
+
+	void (HQX_CALLCONV *hqNxFunction)(uint32_t*, uint32_t*, int, int, int, int) = mult == 2 ? &hq2x_32_slice : mult == 3 ? &hq3x_32_slice : &hq4x_32_slice;
+	void (HQX_CALLCONV *hqNxReference)(uint32_t*, uint32_t*, int, int) = mult == 2 ? &hq2x_32 : mult == 3 ? &hq3x_32 : &hq4x_32;
+	InitHqx();
+
+	cycle_t referenceTime, newTime;
+	referenceTime.Reset();
+	newTime.Reset();
+	int mismatches = 0;
+	int scaled = 0;
+	double megapixels = 0;
+
+	for (auto tex : textures)
+	{
+		FTextureBuffer source = tex->CreateTexBuffer(0);
+		const int width = source.mWidth;
+		const int height = source.mHeight;
+		int outWidth, outHeight;
+		if (width > gl_texture_hqresize_maxinputsize || height > gl_texture_hqresize_maxinputsize) continue;
+
+		// The reference is the original path: the whole image in one call on this thread,
+		// with the hqNx kernels using their per pixel pattern test.
+		referenceTime.Clock();
+		unsigned char *expected = new unsigned char[width * mult * height * mult * 4];
+		uint32_t *src = reinterpret_cast<uint32_t*>(source.mBuffer);
+		uint32_t *dest = reinterpret_cast<uint32_t*>(expected);
+		if (type == 2) hqNxReference(src, dest, width, height);
+		else if (type == 4) xbrz::scale(mult, src, dest, width, height, xbrz::ColorFormat::ARGB, xbrz::ScalerCfg(), 0, std::numeric_limits<int>::max());
+		else xbrzOldScale(mult, src, dest, width, height, xbrz::ColorFormat::ARGB, xbrz::ScalerCfg(), 0, std::numeric_limits<int>::max());
+		referenceTime.Unclock();
+
+		newTime.Clock();
+		unsigned char *input = new unsigned char[width * height * 4];
+		memcpy(input, source.mBuffer, width * height * 4);
+		unsigned char *result;
+		if (type == 2) result = hqNxHelper(hqNxFunction, mult, input, width, height, outWidth, outHeight);
+		else if (type == 4) result = xbrzHelper(xbrz::scale, mult, input, width, height, outWidth, outHeight);
+		else result = xbrzHelper(xbrzOldScale, mult, input, width, height, outWidth, outHeight);
+		newTime.Unclock();
+
+		if (memcmp(expected, result, outWidth * outHeight * 4) != 0)
+		{
+			Printf("Output differs for %s\n", tex->GetName().GetChars());
+			mismatches++;
+		}
+		megapixels += outWidth * outHeight / 1000000.;
+		scaled++;
+		delete[] expected;
+		delete[] result;
+	}
+
+	Printf("%d textures, %.2f megapixels: single threaded %.2f ms, tiled %.2f ms (%.2fx), %d mismatches\n",
+		scaled, megapixels, referenceTime.TimeMS(), newTime.TimeMS(),
+		newTime.TimeMS() > 0 ? referenceTime.TimeMS() / newTime.TimeMS() : 0., mismatches);
+}
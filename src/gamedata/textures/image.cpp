@@ -43,6 +43,7 @@
 FMemArena FImageSource::ImageArena(32768);
 TArray<FImageSource *>FImageSource::ImageForLump;
 int FImageSource::NextID;
+std::recursive_mutex FImageSource::DecodeMutex;
 static PrecacheInfo precacheInfo;
 
 struct PrecacheDataPaletted
@@ -79,6 +80,7 @@ TArray<uint8_t> FImageSource::CreatePalettedPixels(int conversion)
 
 PalettedPixels FImageSource::GetCachedPalettedPixels(int conversion)
 {
+	std::lock_guard<std::recursive_mutex> lock(DecodeMutex);
 	PalettedPixels ret;
 
 	FString name;
@@ -140,6 +142,7 @@ PalettedPixels FImageSource::GetCachedPalettedPixels(int conversion)
 
 TArray<uint8_t> FImageSource::GetPalettedPixels(int conversion)
 {
+	std::lock_guard<std::recursive_mutex> lock(DecodeMutex);
 	auto pix = GetCachedPalettedPixels(conversion);
 	if (pix.ownsPixels())
 	{
@@ -196,6 +199,7 @@ int FImageSource::CopyTranslatedPixels(FBitmap *bmp, PalEntry *remap)
 
 FBitmap FImageSource::GetCachedBitmap(PalEntry *remap, int conversion, int *ptrans)
 {
+	std::lock_guard<std::recursive_mutex> lock(DecodeMutex);
 	FBitmap ret;
 	
 	FString name;
@@ -297,13 +301,18 @@ void FImageSource::CollectForPrecache(PrecacheInfo &info, bool requiretruecolor)
 
 void FImageSource::BeginPrecaching()
 {
+	std::lock_guard<std::recursive_mutex> lock(DecodeMutex);
 	precacheInfo.Clear();
 }
 
 void FImageSource::EndPrecaching()
 {
+	std::lock_guard<std::recursive_mutex> lock(DecodeMutex);
 	precacheDataPaletted.Clear();
 	precacheDataRgba.Clear();
+	// Without the reference counts nothing read later can end up in the cache, where the returned data
+	// would only be a reference that outlives the lock.
+	precacheInfo.Clear();
 }
 
 void FImageSource::RegisterForPrecache(FImageSource *img)
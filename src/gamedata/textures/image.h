@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <mutex>
 #include "tarray.h"
 #include "textures/bitmap.h"
 #include "memarena.h"
@@ -65,6 +66,10 @@ public:
 	int8_t bTranslucent = -1;					// Image has pixels with a non-0/1 value. (-1 means the user needs to do a real check)
 
 	int GetId() const { return ImageID; }
+
+	// Image sources share lump readers and the precache buffers, so everything that reads them must hold this lock.
+	// The hardware renderer's texture streamer decodes on a background thread while the scene is being processed.
+	static std::recursive_mutex DecodeMutex;
 	
 	// 'noremap0' will only be looked at by FPatchTexture and forwarded by FMultipatchTexture.
 
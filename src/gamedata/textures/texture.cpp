@@ -52,9 +52,14 @@
 #include "image.h"
 #include "formats/multipatchtexture.h"
 #include "g_levellocals.h"
+#include <mutex>
 
 FTexture *CreateBrightmapTexture(FImageSource*);
 
+// Guards what textures find out about their pixels. The texture streamer's decode thread and the BSP workers
+// may both get there for the same texture, and the flags share their storage. Never held while reading an image.
+static std::mutex TextureStateMutex;
+
 // Make sprite offset adjustment user-configurable per renderer.
 int r_spriteadjustSW, r_spriteadjustHW;
 CUSTOM_CVAR(Int, r_spriteadjust, 2, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
@@ -298,24 +303,37 @@ PalEntry FTexture::averageColor(const uint32_t *data, int size, int maxout)
 
 PalEntry FTexture::GetSkyCapColor(bool bottom)
 {
-	if (!bSWSkyColorDone)
 	{
-		bSWSkyColorDone = true;
+		std::lock_guard<std::mutex> lock(TextureStateMutex);
+		if (bSWSkyColorDone) return bottom ? FloorSkyColor : CeilingSkyColor;
+	}
 
-		FBitmap bitmap = GetBgraBitmap(nullptr);
-		int w = bitmap.GetWidth();
-		int h = bitmap.GetHeight();
+	// The image read locks by itself, so the averaging does not hold up the texture streamer.
+	FBitmap bitmap = GetBgraBitmap(nullptr);
+	int w = bitmap.GetWidth();
+	int h = bitmap.GetHeight();
+
+	PalEntry ceiling = 0, floor = 0;
+	const uint32_t *buffer = (const uint32_t *)bitmap.GetPixels();
+	if (buffer)
+	{
+		ceiling = averageColor((uint32_t *)buffer, w * MIN(30, h), 0);
+		if (h>30)
+		{
+			floor = averageColor(((uint32_t *)buffer) + (h - 30)*w, w * 30, 0);
+		}
+		else floor = ceiling;
+	}
 
-		const uint32_t *buffer = (const uint32_t *)bitmap.GetPixels();
+	std::lock_guard<std::mutex> lock(TextureStateMutex);
+	if (!bSWSkyColorDone)
+	{
 		if (buffer)
 		{
-			CeilingSkyColor = averageColor((uint32_t *)buffer, w * MIN(30, h), 0);
-			if (h>30)
-			{
-				FloorSkyColor = averageColor(((uint32_t *)buffer) + (h - 30)*w, w * 30, 0);
-			}
-			else FloorSkyColor = CeilingSkyColor;
+			CeilingSkyColor = ceiling;
+			FloorSkyColor = floor;
 		}
+		bSWSkyColorDone = true;
 	}
 	return bottom ? FloorSkyColor : CeilingSkyColor;
 }
@@ -412,6 +430,8 @@ void FTexture::AddAutoMaterials()
 //===========================================================================
 void FTexture::CreateDefaultBrightmap()
 {
+	// Only FMaterial's constructor calls this, and it creates one material at a time.
+	// The image read locks by itself, so only adding the texture needs FImageSource::DecodeMutex.
 	if (!bBrightmapChecked)
 	{
 		// Check for brightmaps
@@ -430,21 +450,22 @@ void FTexture::CreateDefaultBrightmap()
 				{
 					// Create a brightmap
 					DPrintf(DMSG_NOTIFY, "brightmap created for texture '%s'\n", Name.GetChars());
-					Brightmap = CreateBrightmapTexture(static_cast<FImageTexture*>(this)->GetImage());
+					{
+						std::lock_guard<std::recursive_mutex> lock(FImageSource::DecodeMutex);
+						Brightmap = CreateBrightmapTexture(static_cast<FImageTexture*>(this)->GetImage());
+						TexMan.AddTexture(Brightmap);
+					}
+					std::lock_guard<std::mutex> lock(TextureStateMutex);
 					bBrightmapChecked = true;
-					TexMan.AddTexture(Brightmap);
 					return;
 				}
 			}
 			// No bright pixels found
 			DPrintf(DMSG_SPAMMY, "No bright pixels found in texture '%s'\n", Name.GetChars());
-			bBrightmapChecked = 1;
-		}
-		else
-		{
-			// does not have one so set the flag to 'done'
-			bBrightmapChecked = 1;
 		}
+		// otherwise it does not have one, so either way set the flag to 'done'
+		std::lock_guard<std::mutex> lock(TextureStateMutex);
+		bBrightmapChecked = 1;
 	}
 }
 
@@ -460,10 +481,12 @@ void FTexture::GetGlowColor(float *data)
 	if (bGlowing && GlowColor == 0)
 	{
 		auto buffer = GetBgraBitmap(nullptr);
-		GlowColor = averageColor((uint32_t*)buffer.GetPixels(), buffer.GetWidth() * buffer.GetHeight(), 153);
+		PalEntry color = averageColor((uint32_t*)buffer.GetPixels(), buffer.GetWidth() * buffer.GetHeight(), 153);
 
+		std::lock_guard<std::mutex> lock(TextureStateMutex);
+		GlowColor = color;
 		// Black glow equals nothing so switch glowing off
-		if (GlowColor == 0) bGlowing = false;
+		if (color == 0) bGlowing = false;
 	}
 	data[0] = GlowColor.r / 255.0f;
 	data[1] = GlowColor.g / 255.0f;
@@ -474,6 +497,7 @@ void FTexture::GetGlowColor(float *data)
 // 
 //	Finds gaps in the texture which can be skipped by the renderer
 //  This was mainly added to speed up one area in E4M6 of 007LTSD
+//  Must be called with TextureStateMutex held.
 //
 //===========================================================================
 
@@ -568,25 +592,27 @@ bool FTexture::FindHoles(const unsigned char * buffer, int w, int h)
 
 void FTexture::CheckTrans(unsigned char * buffer, int size, int trans)
 {
-	if (bTranslucent == -1)
 	{
-		bTranslucent = trans;
-		if (trans == -1)
+		std::lock_guard<std::mutex> lock(TextureStateMutex);
+		if (bTranslucent != -1) return;
+	}
+	if (trans == -1)
+	{
+		trans = 0;
+		uint32_t * dwbuf = (uint32_t*)buffer;
+		for (int i = 0; i<size; i++)
 		{
-			uint32_t * dwbuf = (uint32_t*)buffer;
-			for (int i = 0; i<size; i++)
-			{
-				uint32_t alpha = dwbuf[i] >> 24;
+			uint32_t alpha = dwbuf[i] >> 24;
 
-				if (alpha != 0xff && alpha != 0)
-				{
-					bTranslucent = 1;
-					return;
-				}
+			if (alpha != 0xff && alpha != 0)
+			{
+				trans = 1;
+				break;
 			}
-			bTranslucent = 0;
 		}
 	}
+	std::lock_guard<std::mutex> lock(TextureStateMutex);
+	bTranslucent = trans;
 }
 
 
@@ -668,11 +694,15 @@ bool FTexture::SmoothEdges(unsigned char * buffer, int w, int h)
 
 bool FTexture::ProcessData(unsigned char * buffer, int w, int h, bool ispatch)
 {
-	if (bMasked)
 	{
-		bMasked = SmoothEdges(buffer, w, h);
-		if (bMasked && !ispatch) FindHoles(buffer, w, h);
+		std::lock_guard<std::mutex> lock(TextureStateMutex);
+		if (!bMasked) return true;
 	}
+	bool masked = SmoothEdges(buffer, w, h);
+
+	std::lock_guard<std::mutex> lock(TextureStateMutex);
+	bMasked = masked;
+	if (masked && !ispatch) FindHoles(buffer, w, h);
 	return true;
 }
 
@@ -684,6 +714,8 @@ bool FTexture::ProcessData(unsigned char * buffer, int w, int h, bool ispatch)
 
 FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 {
+	// The hardware renderer's texture streamer decodes on a background thread. Only the reads of image sources
+	// and lumps hold FImageSource::DecodeMutex, so the conversion and upscaling here don't hold up the BSP workers.
 	FTextureBuffer result;
 
 	unsigned char * buffer = nullptr;
@@ -716,6 +748,7 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 		if (remap == nullptr)
 		{
 			CheckTrans(buffer, W*H, trans);
+			std::lock_guard<std::mutex> lock(TextureStateMutex);
 			isTransparent = bTranslucent;
 		}
 		else
@@ -782,8 +815,9 @@ bool FTexture::GetTranslucency()
 
 void FTexture::SetSpriteAdjust()
 {
-	for (auto mat : Material)
+	for (auto &material : Material)
 	{
+		FMaterial *mat = material;
 		if (mat != nullptr) mat->SetSpriteRect();
 	}
 }
@@ -44,6 +44,7 @@
 #include "r_data/r_translate.h"
 #include "hwrenderer/textures/hw_texcontainer.h"
 #include <vector>
+#include <atomic>
 
 // 15 because 0th texture is our texture
 #define MAX_CUSTOM_HW_SHADER_TEXTURES 15
@@ -371,7 +372,8 @@ protected:
 	int SourceLump;
 	FTextureID id;
 
-	FMaterial *Material[2] = { nullptr, nullptr };
+	// Read by the BSP workers without a lock, so these only get set once the material is complete.
+	std::atomic<FMaterial *> Material[2] = { {nullptr}, {nullptr} };
 public:
 	FHardwareTextureContainer SystemTextures;
 protected:
@@ -417,9 +419,9 @@ protected:
 	uint8_t bDisableFullbright : 1;				// This texture will not be displayed as fullbright sprite
 	uint8_t bSkybox : 1;						// is a cubic skybox
 	uint8_t bNoCompress : 1;
-	uint8_t bNoExpand : 1;
 	int8_t bTranslucent : 2;
 	bool bHiresHasColorKey = false;				// Support for old color-keyed Doomsday textures
+	std::atomic<bool> bNoExpand { false };		// Not a bit field because the BSP workers may set it while others read it.
 
 	uint16_t Rotations;
 	int16_t SkyOffset;
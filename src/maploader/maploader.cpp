@@ -78,6 +78,7 @@
 #include "fragglescript/t_fs.h"
 #include "swrenderer/r_swrenderer.h"
 #include "hwrenderer/data/flatvertices.h"
+#include "hwrenderer/scene/hw_geometrycache.h"
 #include "xlat/xlat.h"
 
 enum
@@ -2646,8 +2647,8 @@ void MapLoader::LoadBlockMap (MapData * map)
 
 	// clear out mobj chains
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
-	Level->blockmap.blocklinks = new FBlockNode *[count];
-	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.blockcells = new FBlockCell[count];
+	Level->blockmap.dirtycells.Clear();
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
@@ -3180,6 +3181,8 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	Level->headgamenode = Level->gamenodes.Size() > 0 ? &Level->gamenodes[Level->gamenodes.Size() - 1] : Level->nodes.Size() ? &Level->nodes[Level->nodes.Size() - 1] : nullptr;
 
 	LoadBlockMap(map);
+	Level->subsectorgrid.Build(Level->HeadGamenode(), Level->vertexes);
+	Level->rendersubsectorgrid.Build(Level->HeadNode(), Level->vertexes);
 
 	LoadReject(map, false);
 	GroupLines(false);
@@ -3241,6 +3244,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	InitRenderInfo();				// create hardware independent renderer resources for the level. This must be done BEFORE the PolyObj Spawn!!!
 	Level->ClearDynamic3DFloorData();	// CreateVBO must be run on the plain 3D floor data.
 	screen->mVertexData->CreateVBO(Level->sectors);
+	hw_ClearGeometryCache();
 
 	for (auto &sec : Level->sectors)
 	{
@@ -2,6 +2,7 @@
 #define __P_BLOCKMAP_H
 
 #include "doomtype.h"
+#include "tarray.h"
 
 class AActor;
 
@@ -9,10 +10,9 @@ class AActor;
 struct FBlockNode
 {
 	AActor *Me;						// actor this node references
-	int BlockIndex;					// index into blocklinks for the block this node is in
+	int BlockIndex;					// index into blockcells for the block this node is in
+	int CellIndex;					// index of this node's entry in the block's cell
 	int Group;						// portal group this link belongs to (can be different than the actor's own group
-	FBlockNode **PrevActor;			// previous actor in this block
-	FBlockNode *NextActor;			// next actor in this block
 	FBlockNode **PrevBlock;			// previous block this actor is in
 	FBlockNode *NextBlock;			// next block this actor is in
 
@@ -22,6 +22,24 @@ struct FBlockNode
 	static FBlockNode *FreeBlocks;
 };
 
+// One actor linked into a block
+struct FBlockEntry
+{
+	AActor *Me;						// nullptr if the actor got unlinked since the last compaction
+	FBlockNode *Node;
+};
+
+// The actors in a block, oldest first. Walking it backwards gives the same order
+// the old linked lists had, which put every new actor at the head. Unlinking only
+// leaves a hole so that the order of the others never changes. The holes are removed
+// by FBlockmap::CompactCells once per tic and after player prediction, when no
+// iterator can be active.
+struct FBlockCell
+{
+	TArray<FBlockEntry> Entries;
+	int Holes = 0;
+};
+
 // BLOCKMAP
 // Created from axis aligned bounding box
 // of the map, a rectangular array of
@@ -39,7 +57,8 @@ struct FBlockmap
 	int					bmapheight; 	// in mapblocks
 	double				bmaporgx;
 	double				bmaporgy;		// origin of block map
-	FBlockNode**		blocklinks; 	// for thing chains
+	FBlockCell*			blockcells; 	// for thing lists
+	TArray<int>			dirtycells;		// blocks with holes in them
 
 	// mapblocks are used to check movement
 	// against lines and things
@@ -75,6 +94,29 @@ struct FBlockmap
 
 	bool VerifyBlockMap(int count, unsigned numlines);
 
+	void LinkNode(FBlockNode *node)
+	{
+		FBlockCell &cell = blockcells[node->BlockIndex];
+		node->CellIndex = cell.Entries.Push({ node->Me, node });
+	}
+
+	void UnlinkNode(FBlockNode *node)
+	{
+		FBlockCell &cell = blockcells[node->BlockIndex];
+		cell.Entries[node->CellIndex].Me = nullptr;
+		if (cell.Holes++ == 0) dirtycells.Push(node->BlockIndex);
+	}
+
+	// Puts a node unlinked by UnlinkNode back in its old place. Only valid before the next compaction.
+	void RestoreNode(FBlockNode *node)
+	{
+		FBlockCell &cell = blockcells[node->BlockIndex];
+		cell.Entries[node->CellIndex].Me = node->Me;
+		cell.Holes--;
+	}
+
+	void CompactCells();
+
 	void Clear()
 	{
 		if (blockmaplump != nullptr)
@@ -82,11 +124,12 @@ struct FBlockmap
 			delete[] blockmaplump;
 			blockmaplump = nullptr;
 		}
-		if (blocklinks != nullptr)
+		if (blockcells != nullptr)
 		{
-			delete[] blocklinks;
-			blocklinks = nullptr;
+			delete[] blockcells;
+			blockcells = nullptr;
 		}
+		dirtycells.Clear();
 	}
 
 	~FBlockmap()
@@ -96,4 +139,37 @@ struct FBlockmap
 
 };
 
+struct node_t;
+struct subsector_t;
+struct vertex_t;
+
+// Uniform grid over the map that stores for each cell where a BSP descent
+// for a point in it ends up: the subsector if the entire cell lies in one,
+// otherwise the deepest node whose partition line crosses the cell.
+// Points outside the grid start at the root.
+struct FSubsectorGrid
+{
+	TArray<void *> Cells;		// tagged like node_t::children
+	void *Head = nullptr;
+	int64_t OriginX = 0;
+	int64_t OriginY = 0;
+	int Width = 0;
+	int Height = 0;
+	int Shift = 0;
+
+	void Build(node_t *head, const TArray<vertex_t> &vertexes);
+	subsector_t *Find(fixed_t x, fixed_t y) const;
+	void Find(unsigned count, const double *x, const double *y, subsector_t **result) const;
+
+	void Clear()
+	{
+		Cells.Reset();
+		Head = nullptr;
+		Width = Height = 0;
+	}
+
+private:
+	void BuildBlock(void *node, int cx0, int cy0, int cx1, int cy1);
+};
+
 #endif
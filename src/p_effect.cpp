@@ -49,6 +49,8 @@
 #include "vm.h"
 #include "actorinlines.h"
 #include "g_game.h"
+#include "c_dispatch.h"
+#include "stats.h"
 
 CVAR (Int, cl_rockettrails, 1, CVAR_ARCHIVE);
 CVAR (Bool, r_rail_smartspiral, 0, CVAR_ARCHIVE);
@@ -99,19 +101,115 @@ static const struct ColorList {
 	{NULL, 0, 0, 0 }
 };
 
+//==========================================================================
+//
+// FParticleStore
+//
+//==========================================================================
+
+void FParticleStore::Resize(unsigned size)
+{
+	for (auto a : { &PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &AccX, &AccY, &AccZ, &Size, &SizeStep }) a->Resize(size);
+	for (auto a : { &Alpha, &FadeStep }) a->Resize(size);
+	for (auto a : { &Bright, &NoTimeFreeze, &Expired }) a->Resize(size);
+	TTL.Resize(size);
+	Color.Resize(size);
+	Subsector.Resize(size);
+	Count = MIN(Count, size);
+}
+
+void FParticleStore::Append(const particle_t &p)
+{
+	unsigned i = Count++;
+	PosX[i] = p.Pos.X;
+	PosY[i] = p.Pos.Y;
+	PosZ[i] = p.Pos.Z;
+	VelX[i] = p.Vel.X;
+	VelY[i] = p.Vel.Y;
+	VelZ[i] = p.Vel.Z;
+	AccX[i] = p.Acc.X;
+	AccY[i] = p.Acc.Y;
+	AccZ[i] = p.Acc.Z;
+	Size[i] = p.size;
+	SizeStep[i] = p.sizestep;
+	Alpha[i] = p.alpha;
+	FadeStep[i] = p.fadestep;
+	TTL[i] = p.ttl;
+	Color[i] = p.color;
+	Bright[i] = p.bright;
+	NoTimeFreeze[i] = p.notimefreeze;
+	Expired[i] = false;
+	Subsector[i] = p.subsector;
+}
+
+void FParticleStore::Move(unsigned from, unsigned to)
+{
+	PosX[to] = PosX[from];
+	PosY[to] = PosY[from];
+	PosZ[to] = PosZ[from];
+	VelX[to] = VelX[from];
+	VelY[to] = VelY[from];
+	VelZ[to] = VelZ[from];
+	AccX[to] = AccX[from];
+	AccY[to] = AccY[from];
+	AccZ[to] = AccZ[from];
+	Size[to] = Size[from];
+	SizeStep[to] = SizeStep[from];
+	Alpha[to] = Alpha[from];
+	FadeStep[to] = FadeStep[from];
+	TTL[to] = TTL[from];
+	Color[to] = Color[from];
+	Bright[to] = Bright[from];
+	NoTimeFreeze[to] = NoTimeFreeze[from];
+	Subsector[to] = Subsector[from];
+}
+
+void FParticleStore::Get(unsigned i, particle_t &p) const
+{
+	p.Pos = { PosX[i], PosY[i], PosZ[i] };
+	p.Vel = { VelX[i], VelY[i], VelZ[i] };
+	p.Acc = { AccX[i], AccY[i], AccZ[i] };
+	p.size = Size[i];
+	p.sizestep = SizeStep[i];
+	p.subsector = Subsector[i];
+	p.ttl = TTL[i];
+	p.bright = Bright[i];
+	p.notimefreeze = !!NoTimeFreeze[i];
+	p.fadestep = FadeStep[i];
+	p.alpha = Alpha[i];
+	p.color = Color[i];
+	p.snext = NO_PARTICLE;
+}
+
+//==========================================================================
+//
+// New particles are collected separately and only moved into the store
+// when the particles get updated or rendered next. The returned pointer
+// is only valid until the next particle gets spawned.
+//
+//==========================================================================
+
 inline particle_t *NewParticle (FLevelLocals *Level)
 {
-	particle_t *result = nullptr;
-	if (Level->InactiveParticles != NO_PARTICLE)
+	if (Level->ParticleData.Count + Level->NewParticles.Size() >= Level->MaxParticles)
 	{
-		result = &Level->Particles[Level->InactiveParticles];
-		Level->InactiveParticles = result->tnext;
-		result->tnext = Level->ActiveParticles;
-		Level->ActiveParticles = uint32_t(result - Level->Particles.Data());
+		return nullptr;
 	}
+	particle_t *result = &Level->NewParticles[Level->NewParticles.Reserve(1)];
+	memset (result, 0, sizeof(particle_t));
+	Level->ParticlesChanged = true;
 	return result;
 }
 
+static void P_FlushNewParticles (FLevelLocals *Level)
+{
+	for (auto &p : Level->NewParticles)
+	{
+		Level->ParticleData.Append(p);
+	}
+	Level->NewParticles.Clear();
+}
+
 //
 // [RH] Particle functions
 //
@@ -129,21 +227,18 @@ void P_InitParticles (FLevelLocals *Level)
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	Level->MaxParticles = clamp<int>(num, 100, 500000);
 
-	Level->Particles.Resize(NumParticles);
+	Level->ParticleData.Resize(Level->MaxParticles);
 	P_ClearParticles (Level);
 }
 
 void P_ClearParticles (FLevelLocals *Level)
 {
-	int i = 0;
-	memset (Level->Particles.Data(), 0, Level->Particles.Size() * sizeof(particle_t));
-	Level->ActiveParticles = NO_PARTICLE;
-	Level->InactiveParticles = 0;
-	for (auto &p : Level->Particles)
-		p.tnext = ++i;
-	Level->Particles.Last().tnext = NO_PARTICLE;
+	Level->ParticleData.Count = 0;
+	Level->NewParticles.Clear();
+	Level->Particles.Clear();
+	Level->ParticlesChanged = true;
 }
 
 // Group particles by subsectors. Because particles are always
@@ -157,18 +252,55 @@ void P_FindParticleSubsectors (FLevelLocals *Level)
 		Level->ParticlesInSubsec.Reserve (Level->subsectors.Size() - Level->ParticlesInSubsec.Size());
 	}
 
-	fillshort (&Level->ParticlesInSubsec[0], Level->subsectors.Size(), NO_PARTICLE);
+	for (auto &ss : Level->ParticlesInSubsec) ss = NO_PARTICLE;
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (uint16_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
+
+	// The render view only needs to be rebuilt after the particles have changed.
+	if (Level->ParticlesChanged)
 	{
-		 // Try to reuse the subsector from the last portal check, if still valid.
-		if (Level->Particles[i].subsector == nullptr) Level->Particles[i].subsector = Level->PointInRenderSubsector(Level->Particles[i].Pos);
-		int ssnum = Level->Particles[i].subsector->Index();
-		Level->Particles[i].snext = Level->ParticlesInSubsec[ssnum];
+		P_FlushNewParticles(Level);
+
+		auto &data = Level->ParticleData;
+		static TArray<unsigned> lookup;
+		static TArray<double> lookupx, lookupy;
+		static TArray<subsector_t *> lookupres;
+		lookup.Clear();
+		lookupx.Clear();
+		lookupy.Clear();
+
+		Level->Particles.Resize(data.Count);
+		for (unsigned i = 0; i < data.Count; i++)
+		{
+			data.Get(i, Level->Particles[i]);
+			// Particles that just crossed a portal or were just spawned still need their subsector.
+			if (data.Subsector[i] == nullptr)
+			{
+				lookup.Push(i);
+				lookupx.Push(data.PosX[i]);
+				lookupy.Push(data.PosY[i]);
+			}
+		}
+		if (lookup.Size() > 0)
+		{
+			lookupres.Resize(lookup.Size());
+			Level->PointInRenderSubsector(lookup.Size(), lookupx.Data(), lookupy.Data(), lookupres.Data());
+			for (unsigned j = 0; j < lookup.Size(); j++)
+			{
+				data.Subsector[lookup[j]] = Level->Particles[lookup[j]].subsector = lookupres[j];
+			}
+		}
+		Level->ParticlesChanged = false;
+	}
+
+	for (unsigned i = 0; i < Level->Particles.Size(); i++)
+	{
+		auto &p = Level->Particles[i];
+		int ssnum = p.subsector->Index();
+		p.snext = Level->ParticlesInSubsec[ssnum];
 		Level->ParticlesInSubsec[ssnum] = i;
 	}
 }
@@ -210,64 +342,139 @@ void P_InitEffects ()
 	blood2 = ParticleColor(RPART(kind)/3, GPART(kind)/3, BPART(kind)/3);
 }
 
+//==========================================================================
+//
+// P_ThinkParticles
+//
+// Each step is a separate pass over the particle arrays. Without a time
+// freeze (i.e. almost always) the passes have no per-particle branches
+// apart from the portal checks so the compiler can vectorize them.
+//
+//==========================================================================
+
 void P_ThinkParticles (FLevelLocals *Level)
 {
-	int i;
-	particle_t *particle, *prev;
+	P_FlushNewParticles(Level);
 
-	i = Level->ActiveParticles;
-	prev = NULL;
-	while (i != NO_PARTICLE)
+	auto &data = Level->ParticleData;
+	unsigned count = data.Count;
+	if (count == 0)
+	{
+		return;
+	}
+	Level->ParticlesChanged = true;
+
+	const bool frozen = Level->isFrozen();
+	float *alpha = data.Alpha.Data();
+	const float *fadestep = data.FadeStep.Data();
+	double *size = data.Size.Data();
+	const double *sizestep = data.SizeStep.Data();
+	int32_t *ttl = data.TTL.Data();
+	uint8_t *expired = data.Expired.Data();
+	const uint8_t *notimefreeze = data.NoTimeFreeze.Data();
+
+	// Fade, grow and age.
+	auto age = [=](unsigned i)
 	{
-		particle = &Level->Particles[i];
-		i = particle->tnext;
-		if (!particle->notimefreeze && Level->isFrozen())
+		float oldtrans = alpha[i];
+		alpha[i] -= fadestep[i];
+		size[i] += sizestep[i];
+		ttl[i]--;
+		expired[i] = (alpha[i] <= 0) | (oldtrans < alpha[i]) | (ttl[i] <= 0) | (size[i] <= 0);
+	};
+	if (!frozen)
+	{
+		for (unsigned i = 0; i < count; i++) age(i);
+	}
+	else
+	{
+		for (unsigned i = 0; i < count; i++)
 		{
-			prev = particle;
-			continue;
+			if (notimefreeze[i]) age(i);
+			else expired[i] = false;
 		}
-		
-		auto oldtrans = particle->alpha;
-		particle->alpha -= particle->fadestep;
-		particle->size += particle->sizestep;
-		if (particle->alpha <= 0 || oldtrans < particle->alpha || --particle->ttl <= 0 || (particle->size <= 0))
-		{ // The particle has expired, so free it
-			memset (particle, 0, sizeof(particle_t));
-			if (prev)
-				prev->tnext = i;
-			else
-				Level->ActiveParticles = i;
-			particle->tnext = Level->InactiveParticles;
-			Level->InactiveParticles = (int)(particle - Level->Particles.Data());
-			continue;
+	}
+
+	// Remove the expired ones. This keeps the remaining ones in order.
+	unsigned live = 0;
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (!expired[i])
+		{
+			if (i != live) data.Move(i, live);
+			live++;
+		}
+	}
+	data.Count = count = live;
+
+	// Move.
+	double *px = data.PosX.Data(), *py = data.PosY.Data(), *pz = data.PosZ.Data();
+	double *vx = data.VelX.Data(), *vy = data.VelY.Data(), *vz = data.VelZ.Data();
+	const double *ax = data.AccX.Data(), *ay = data.AccY.Data(), *az = data.AccZ.Data();
+	notimefreeze = data.NoTimeFreeze.Data();
+	const bool lineportals = Level->PortalBlockmap.containsLines;
+
+	auto move = [=](unsigned i)
+	{
+		if (lineportals)
+		{
+			// Handle crossing a line portal
+			DVector2 newxy = Level->GetPortalOffsetPosition(px[i], py[i], vx[i], vy[i]);
+			px[i] = newxy.X;
+			py[i] = newxy.Y;
+		}
+		else
+		{
+			px[i] += vx[i];
+			py[i] += vy[i];
 		}
+		pz[i] += vz[i];
+		vx[i] += ax[i];
+		vy[i] += ay[i];
+		vz[i] += az[i];
+	};
+	if (!frozen)
+	{
+		for (unsigned i = 0; i < count; i++) move(i);
+	}
+	else
+	{
+		for (unsigned i = 0; i < count; i++) if (notimefreeze[i]) move(i);
+	}
+
+	// Find the new subsectors. Frozen particles stay where they are.
+	subsector_t **subsector = data.Subsector.Data();
+	if (!frozen)
+	{
+		Level->PointInRenderSubsector(count, px, py, subsector);
+	}
+	else
+	{
+		for (unsigned i = 0; i < count; i++) if (notimefreeze[i]) subsector[i] = Level->PointInRenderSubsector(DVector2(px[i], py[i]));
+	}
+
+	// Handle crossing a sector portal.
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (frozen && !notimefreeze[i]) continue;
 
-		// Handle crossing a line portal
-		DVector2 newxy = Level->GetPortalOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
-		particle->Pos.X = newxy.X;
-		particle->Pos.Y = newxy.Y;
-		particle->Pos.Z += particle->Vel.Z;
-		particle->Vel += particle->Acc;
-		particle->subsector = Level->PointInRenderSubsector(particle->Pos);
-		sector_t *s = particle->subsector->sector;
-		// Handle crossing a sector portal.
+		sector_t *s = subsector[i]->sector;
+		DVector2 disp;
 		if (!s->PortalBlocksMovement(sector_t::ceiling))
 		{
-			if (particle->Pos.Z > s->GetPortalPlaneZ(sector_t::ceiling))
-			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::ceiling);
-				particle->subsector = NULL;
-			}
+			if (pz[i] <= s->GetPortalPlaneZ(sector_t::ceiling)) continue;
+			disp = s->GetPortalDisplacement(sector_t::ceiling);
 		}
 		else if (!s->PortalBlocksMovement(sector_t::floor))
 		{
-			if (particle->Pos.Z < s->GetPortalPlaneZ(sector_t::floor))
-			{
-				particle->Pos += s->GetPortalDisplacement(sector_t::floor);
-				particle->subsector = NULL;
-			}
+			if (pz[i] >= s->GetPortalPlaneZ(sector_t::floor)) continue;
+			disp = s->GetPortalDisplacement(sector_t::floor);
 		}
-		prev = particle;
+		else continue;
+
+		px[i] += disp.X;
+		py[i] += disp.Y;
+		subsector[i] = nullptr;
 	}
 }
 
@@ -915,3 +1122,54 @@ void P_DisconnectEffect (AActor *actor)
 		p->size = 4;
 	}
 }
+
+//==========================================================================
+//
+// bench_particles [count] [tics]
+//
+// Spawns a particle storm around the player and times the updates.
+// The particle limit is temporarily raised to fit the storm.
+//
+//==========================================================================
+
+CCMD(bench_particles)
+{
+	if (gamestate != GS_LEVEL || players[consoleplayer].mo == nullptr)
+	{
+		Printf("bench_particles can only be used in a level\n");
+		return;
+	}
+	auto Level = primaryLevel;
+	auto mo = players[consoleplayer].mo;
+	int count = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 4000000) : 100000;
+	int tics = argv.argc() > 2 ? MAX(atoi(argv[2]), 1) : 100;
+
+	Level->MaxParticles = count;
+	Level->ParticleData.Resize(count);
+	P_ClearParticles(Level);
+
+	for (int i = 0; i < count; i++)
+	{
+		DVector3 pos = mo->Vec3Offset((M_Random() - 128) * 2., (M_Random() - 128) * 2., M_Random() / 2.);
+		DVector3 vel((M_Random() - 128) / 64., (M_Random() - 128) / 64., M_Random() / 64.);
+		P_SpawnParticle(Level, pos, vel, DVector3(0, 0, -1. / 8), 0xffffff, 1., tics + (M_Random() & 31), 2., -1, 0.);
+	}
+
+	cycle_t think, group;
+	think.Reset();
+	group.Reset();
+	for (int i = 0; i < tics; i++)
+	{
+		think.Clock();
+		P_ThinkParticles(Level);
+		think.Unclock();
+		group.Clock();
+		P_FindParticleSubsectors(Level);
+		group.Unclock();
+	}
+	Printf("%d particles, %d tics: update = %2.3f ms/tic, grouping = %2.3f ms/tic, %u still alive\n",
+		count, tics, think.TimeMS() / tics, group.TimeMS() / tics, Level->ParticleData.Count);
+
+	// Back to the configured limit. This also removes the storm.
+	P_InitParticles(Level);
+}
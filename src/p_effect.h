@@ -44,6 +44,9 @@ struct subsector_t;
 struct FLevelLocals;
 
 // [RH] Particle details
+//
+// This is what spawning code fills in and what the renderers get to see.
+// The simulation itself runs on FParticleStore.
 
 struct particle_t
 {
@@ -59,11 +62,31 @@ struct particle_t
 	float	fadestep;
 	float	alpha;
 	int		color;
-	uint16_t	tnext;
-	uint16_t	snext;
+	uint32_t	snext;
 };
 
-const uint16_t NO_PARTICLE = 0xffff;
+const uint32_t NO_PARTICLE = 0xffffffffu;
+
+// Live particles, one array per field so that the per-tic update can
+// stream through the data. Particles are kept dense and in spawn order.
+struct FParticleStore
+{
+	TArray<double> PosX, PosY, PosZ;
+	TArray<double> VelX, VelY, VelZ;
+	TArray<double> AccX, AccY, AccZ;
+	TArray<double> Size, SizeStep;
+	TArray<float> Alpha, FadeStep;
+	TArray<int32_t> TTL;
+	TArray<int> Color;
+	TArray<uint8_t> Bright, NoTimeFreeze, Expired;
+	TArray<subsector_t *> Subsector;
+	unsigned Count = 0;
+
+	void Resize(unsigned size);
+	void Append(const particle_t &p);
+	void Move(unsigned from, unsigned to);
+	void Get(unsigned index, particle_t &p) const;
+};
 
 void P_InitParticles(FLevelLocals *);
 void P_ClearParticles (FLevelLocals *Level);
@@ -1254,13 +1254,15 @@ int P_LookForMonsters (AActor *actor)
 AActor *LookForTIDInBlock (AActor *lookee, int index, void *extparams)
 {
 	FLookExParams *params = (FLookExParams *)extparams;
-	FBlockNode *block;
 	AActor *link;
 	AActor *other;
 	
-	for (block = lookee->Level->blockmap.blocklinks[index]; block != NULL; block = block->NextActor)
+	auto &entries = lookee->Level->blockmap.blockcells[index].Entries;
+	for (int i = (int)entries.Size() - 1; i >= 0; i--)
 	{
-		link = block->Me;
+		link = entries[i].Me;
+		if (link == NULL)
+			continue;			// unlinked since the last compaction
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -1424,14 +1426,16 @@ int P_LookForTID (AActor *actor, INTBOOL allaround, FLookExParams *params)
 
 AActor *LookForEnemiesInBlock (AActor *lookee, int index, void *extparam)
 {
-	FBlockNode *block;
 	AActor *link;
 	AActor *other;
 	FLookExParams *params = (FLookExParams *)extparam;
 	
-	for (block = lookee->Level->blockmap.blocklinks[index]; block != NULL; block = block->NextActor)
+	auto &entries = lookee->Level->blockmap.blockcells[index].Entries;
+	for (int i = (int)entries.Size() - 1; i >= 0; i--)
 	{
-		link = block->Me;
+		link = entries[i].Me;
+		if (link == NULL)
+			continue;			// unlinked since the last compaction
 
         if (!(link->flags & MF_SHOOTABLE))
 			continue;			// not shootable (observer or dead)
@@ -1014,6 +1014,8 @@ static int DamageMobj (AActor *target, AActor *inflictor, AActor *source, int da
 	{ // Shouldn't happen
 		return -1;
 	}
+	// Anything that gets hit has to think again right away.
+	target->Unpark();
 	FName MeansOfDeath = mod;
 
 	// Spectral targets only take damage from spectral projectiles.
@@ -46,6 +46,7 @@ struct line_t;
 struct sector_t;
 struct msecnode_t;
 struct portnode_t;
+struct FSecListCache;
 struct secplane_t;
 struct FCheckPosition;
 struct FTranslatedLineTarget;
@@ -273,6 +274,7 @@ enum ESightFlags
 };
 
 void	P_ResetSightCounters (bool full);
+void	P_ResetLightLinkCounters ();
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
 int	P_UsePuzzleItem (AActor *actor, int itemType);
@@ -400,6 +402,8 @@ enum
 int P_GetRadiusDamage(AActor *self, AActor *thing, int damage, int distance, int fulldmgdistance, bool oldradiusdmg);
 int	P_RadiusAttack (AActor *spot, AActor *source, int damage, int distance, 
 						FName damageType, int flags, int fulldamagedistance=0);
+void	P_ResetRadiusAttackStats();
+void	P_TicHash();
 
 void	P_DelSeclist(msecnode_t *, msecnode_t *sector_t::*seclisthead);
 void	P_DelSeclist(portnode_t *, portnode_t *FLinePortal::*seclisthead);
@@ -410,7 +414,10 @@ nodetype *P_AddSecnode(linktype *s, AActor *thing, nodetype *nextnode, nodetype
 template<class nodetype, class linktype>
 nodetype* P_DelSecnode(nodetype *, nodetype *linktype::*head);
 
-msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead);
+msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead, FSecListCache *cache = nullptr);
+void	P_ResetSecnodeStats();
+extern unsigned secnodechanges;
+extern int seclistepoch;
 double	P_GetMoveFactor(const AActor *mo, double *frictionp);	// phares  3/6/98
 double		P_GetFriction(const AActor *mo, double *frictionfactor);
 
@@ -92,6 +92,7 @@
 #include "r_sky.h"
 #include "g_levellocals.h"
 #include "actorinlines.h"
+#include "stats.h"
 
 CVAR(Bool, cl_bloodsplats, true, CVAR_ARCHIVE)
 CVAR(Int, sv_smartaim, 0, CVAR_ARCHIVE | CVAR_SERVERINFO)
@@ -3986,7 +3987,7 @@ struct aim_t
 		if (ceilingportalstate) EnterSectorPortal(sector_t::ceiling, 0, lastsector, toppitch, MIN<DAngle>(0., bottompitch));
 		if (floorportalstate) EnterSectorPortal(sector_t::floor, 0, lastsector, MAX<DAngle>(0., toppitch), bottompitch);
 
-		FPathTraverse it(lastsector->Level, startpos.X, startpos.Y, aimtrace.X, aimtrace.Y, PT_ADDLINES | PT_ADDTHINGS | PT_COMPATIBLE | PT_DELTA, startfrac);
+		FPathTraverse it(lastsector->Level, startpos.X, startpos.Y, aimtrace.X, aimtrace.Y, PT_ADDLINES | PT_ADDTHINGS | PT_COMPATIBLE | PT_DELTA | PT_SHAREORIGIN, startfrac);
 		intercept_t *in;
 
 		if (aimdebug)
@@ -4471,7 +4472,8 @@ AActor *P_LineAttack(AActor *t1, DAngle angle, double distance,
 		damageType = puffDefaults->DamageType;
 	}
 
-	uint32_t tflags = TRACE_NoSky | TRACE_Impact;
+	// Multi-pellet attacks fire all their traces from the same spot.
+	uint32_t tflags = TRACE_NoSky | TRACE_Impact | TRACE_ShareOrigin;
 	if (nointeract || (puffDefaults && puffDefaults->flags6 & MF6_NOTRIGGER)) tflags &= ~TRACE_Impact;
 	if (spawnSky)
 	{
@@ -5176,6 +5178,7 @@ void P_RailAttack(FRailParams *p)
 
 	// disabled because not complete yet.
 	flags = (puffDefaults->flags6 & MF6_NOTRIGGER) ? TRACE_ReportPortals : TRACE_PCross | TRACE_Impact | TRACE_ReportPortals;
+	flags |= TRACE_ShareOrigin;
 	rail_data.StopAtInvul = (puffDefaults->flags3 & MF3_FOILINVUL) ? false : true;
 	rail_data.MThruSpecies = ((puffDefaults->flags6 & MF6_MTHRUSPECIES)) ? true : false;
 	
@@ -5666,6 +5669,12 @@ int P_UsePuzzleItem(AActor *PuzzleItemUser, int PuzzleItemType)
 // [RH] Damage scale to apply to thing that shot the missile.
 static float selfthrustscale;
 
+// Performance meters
+static int RadiusAttacks, RadiusCandidates, RadiusSightChecks, RadiusDamaged;
+static int RadiusAttackDepth;
+static cycle_t RadiusCycles;
+static cycle_t MaxRadiusCycles;
+
 CUSTOM_CVAR(Float, splashfactor, 1.f, CVAR_SERVERINFO)
 {
 	if (self <= 0.f)
@@ -5779,6 +5788,8 @@ static int GetOldRadiusDamage(bool fromaction, AActor *bombspot, AActor *thing,
 	if (dist >= bombdistance)
 		return ret;  // out of range
 
+	if (!fromaction) RadiusSightChecks++;
+
 	// When called from the action function, ignore the sight check.
 	if (fromaction || P_CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
 	{
@@ -5837,11 +5848,44 @@ int P_GetRadiusDamage(AActor *self, AActor *thing, int damage, int distance, int
 //
 //==========================================================================
 
+static int RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bombdistance, FName bombmod,
+	int flags, int fulldamagedistance);
+
 int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bombdistance, FName bombmod,
 	int flags, int fulldamagedistance)
 {
 	if (bombdistance <= 0)
 		return 0;
+
+	// Explosions can set off other explosions, so only the outermost one is timed.
+	if (RadiusAttackDepth++ == 0) RadiusCycles.Clock();
+	RadiusAttacks++;
+	int count = RadiusAttack(bombspot, bombsource, bombdamage, bombdistance, bombmod, flags, fulldamagedistance);
+	if (--RadiusAttackDepth == 0) RadiusCycles.Unclock();
+	return count;
+}
+
+void P_ResetRadiusAttackStats()
+{
+	if (RadiusCycles.Time() > MaxRadiusCycles.Time())
+	{
+		MaxRadiusCycles = RadiusCycles;
+	}
+	RadiusCycles.Reset();
+	RadiusAttacks = RadiusCandidates = RadiusSightChecks = RadiusDamaged = 0;
+}
+
+ADD_STAT(radiusattack)
+{
+	FString out;
+	out.Format("%04.1f ms (%04.1f max), %d attacks, %d candidates, %d sight checks, %d damaged",
+		RadiusCycles.TimeMS(), MaxRadiusCycles.TimeMS(), RadiusAttacks, RadiusCandidates, RadiusSightChecks, RadiusDamaged);
+	return out;
+}
+
+static int RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bombdistance, FName bombmod,
+	int flags, int fulldamagedistance)
+{
 	fulldamagedistance = clamp<int>(fulldamagedistance, 0, bombdistance - 1);
 
 	FPortalGroupArray grouplist(FPortalGroupArray::PGA_Full3d);
@@ -5859,6 +5903,7 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 	while ((it.Next(&cres)))
 	{
 		AActor *thing = cres.thing;
+		RadiusCandidates++;
 		// Vulnerable actors can be damaged by radius attacks even if not shootable
 		// Used to emulate MBF's vulnerability of non-missile bouncers to explosions.
 		if (!((thing->flags & MF_SHOOTABLE) || (thing->flags6 & MF6_VULNERABLE)))
@@ -5895,7 +5940,9 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 			double points = GetRadiusDamage(false, bombspot, thing, bombdamage, bombdistance, fulldamagedistance, bombsource == thing);
 			double check = int(points) * bombdamage;
 			// points and bombdamage should be the same sign (the double cast of 'points' is needed to prevent overflows and incorrect values slipping through.)
-			if ((check > 0 || (check == 0 && bombspot->flags7 & MF7_FORCEZERORADIUSDMG)) && P_CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
+			bool inrange = check > 0 || (check == 0 && bombspot->flags7 & MF7_FORCEZERORADIUSDMG);
+			if (inrange) RadiusSightChecks++;
+			if (inrange && P_CheckSight(thing, bombspot, SF_IGNOREVISIBILITY | SF_IGNOREWATERBOUNDARY))
 			{ // OK to damage; target is in direct path
 				double vz;
 				double thrust;
@@ -5907,6 +5954,7 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 					//[MC] Don't count actors saved by buddha if already at 1 health.
 					int prehealth = thing->health;
 					newdam = P_DamageMobj(thing, bombspot, bombsource, damage, bombmod, DMG_EXPLOSION);
+					RadiusDamaged++;
 					if (thing->health < prehealth)	count++;
 				}
 				else if (thing->player == NULL && (!(flags & RADF_NOIMPACTDAMAGE) && !(thing->flags7 & MF7_DONTTHRUST)))
@@ -5962,6 +6010,7 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 				//[MC] Don't count actors saved by buddha if already at 1 health.
 				int prehealth = thing->health;
 				int newdam = P_DamageMobj(thing, bombspot, bombsource, damage, bombmod, DMG_EXPLOSION);
+				RadiusDamaged++;
 				P_TraceBleed(newdam > 0 ? newdam : damage, thing, bombspot);
 				if (thing->health < prehealth)	count++;
 			}
@@ -6628,22 +6677,29 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 			if (sec->heightsec == sector) continue;
 
 			for (n = sec->touching_thinglist; n; n = n->m_snext) n->visited = false;
-			do
+			secnodechanges++;
+			unsigned changes = secnodechanges;
+			for (n = sec->touching_thinglist; n; )
 			{
-				for (n = sec->touching_thinglist; n; n = n->m_snext)
+				if (n->visited)
 				{
-					if (!n->visited)
-					{
-						n->visited = true;
-						if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-							(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-						{
-							iterator(n->m_thing, &cpos);
-						}
-						break;
-					}
+					n = n->m_snext;
+					continue;
+				}
+				n->visited = true;
+				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
+				{
+					n->m_thing->Unpark();
+					iterator(n->m_thing, &cpos);
 				}
-			} while (n);
+				if (secnodechanges != changes)
+				{ // The list was changed so start over
+					changes = secnodechanges;
+					n = sec->touching_thinglist;
+				}
+				else n = n->m_snext;
+			}
 			sec->CheckPortalPlane(!floorOrCeil);
 		}
 	}
@@ -6687,26 +6743,40 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 
 	// Mark all things invalid
 
+	//
+	// Restarting after every thing makes this quadratic in the number of things,
+	// so only start over if a thing list actually changed. Otherwise all things
+	// before the current one have been processed already and the next
+	// unprocessed one can only come after it. Clearing the flags counts as a
+	// change so that a nested call for the same sector restarts this loop.
+
 	for (n = sector->touching_thinglist; n; n = n->m_snext)
 		n->visited = false;
+	secnodechanges++;
 
-	do
+	unsigned changes = secnodechanges;
+	for (n = sector->touching_thinglist; n; )
 	{
-		for (n = sector->touching_thinglist; n; n = n->m_snext)	// go through list
+		if (n->visited)
 		{
-			if (!n->visited)								// unprocessed thing found
-			{
-				n->visited = true; 							// mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-				{
-					iterator(n->m_thing, &cpos);		 			// process it
-					if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
-				}
-				break;										// exit and start over
-			}
+			n = n->m_snext;
+			continue;
+		}
+		n->visited = true; 							// mark thing as processed
+		if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+			(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
+		{
+			n->m_thing->Unpark();
+			iterator(n->m_thing, &cpos);		 			// process it
+			if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
 		}
-	} while (n);	// repeat from scratch until all things left are marked valid
+		if (secnodechanges != changes)
+		{ // exit and start over
+			changes = secnodechanges;
+			n = sector->touching_thinglist;
+		}
+		else n = n->m_snext;
+	}
 
 	if (floorOrCeil != 2) sector->CheckPortalPlane(floorOrCeil);	// check for portal obstructions after everything is done.
 
@@ -75,6 +75,12 @@
 #include "r_utility.h"
 #include "actor.h"
 #include "actorinlines.h"
+#include "c_dispatch.h"
+#include "d_player.h"
+#include "g_game.h"
+#include "stats.h"
+#include "m_random.h"
+#include "v_text.h"
 
 // State.
 #include "po_man.h"
@@ -286,6 +292,8 @@ void P_LineOpening (FLineOpening &open, AActor *actor, const line_t *linedef, co
 void AActor::UnlinkFromWorld (FLinkContext *ctx)
 {
 	if (ctx != nullptr) ctx->sector_list = nullptr;
+	// Moved actors need to recheck whether they can stay parked.
+	Unpark();
 	if (!(flags & MF_NOSECTOR))
 	{
 		// invisible things don't need to be in sector list
@@ -335,11 +343,7 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 
 		while (block != NULL)
 		{
-			if (block->NextActor != NULL)
-			{
-				block->NextActor->PrevActor = block->PrevActor;
-			}
-			*(block->PrevActor) = block->NextActor;
+			Level->blockmap.UnlinkNode(block);
 			FBlockNode *next = block->NextBlock;
 			block->Release ();
 			block = next;
@@ -494,8 +498,8 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 		// When a node is deleted, its sector links (the links starting
 		// at sector_t->touching_thinglist) are broken. When a node is
 		// added, new sector links are created.
-		touching_sectorlist = P_CreateSecNodeList(this, radius, ctx != nullptr? ctx->sector_list : nullptr, &sector_t::touching_thinglist);	// Attach to thing
-		if (renderradius >= 0) touching_rendersectors = P_CreateSecNodeList(this, RenderRadius(), ctx != nullptr ? ctx->render_list : nullptr, &sector_t::touching_renderthings);
+		touching_sectorlist = P_CreateSecNodeList(this, radius, ctx != nullptr? ctx->sector_list : nullptr, &sector_t::touching_thinglist, &SectorListCache);	// Attach to thing
+		if (renderradius >= 0) touching_rendersectors = P_CreateSecNodeList(this, RenderRadius(), ctx != nullptr ? ctx->render_list : nullptr, &sector_t::touching_renderthings, &RenderListCache);
 		else
 		{
 			touching_rendersectors = nullptr;
@@ -535,16 +539,10 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 				{
 					for (int x = x1; x <= x2; ++x)
 					{
-						FBlockNode **link = &Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
 						FBlockNode *node = FBlockNode::Create(this, x, y, this->Sector->PortalGroup);
 
 						// Link in to block
-						if ((node->NextActor = *link) != NULL)
-						{
-							(*link)->PrevActor = &node->NextActor;
-						}
-						node->PrevActor = link;
-						*link = node;
+						Level->blockmap.LinkNode(node);
 
 						// Link in to actor
 						node->PrevBlock = alink;
@@ -882,6 +880,123 @@ void FMultiBlockLinesIterator::Reset()
 	startIteratorForGroup(basegroup);
 }
 
+//===========================================================================
+//
+// FBlockmap :: CompactCells
+//
+// Removes the holes unlinking actors left in the blocks. This must only be
+// called between tics when no block iterator can be active.
+//
+//===========================================================================
+
+void FBlockmap::CompactCells()
+{
+	for (int index : dirtycells)
+	{
+		FBlockCell &cell = blockcells[index];
+		if (cell.Holes == 0) continue;
+
+		unsigned count = 0;
+		for (unsigned i = 0; i < cell.Entries.Size(); i++)
+		{
+			if (cell.Entries[i].Me != nullptr)
+			{
+				cell.Entries[count] = cell.Entries[i];
+				cell.Entries[count].Node->CellIndex = count;
+				count++;
+			}
+		}
+		cell.Entries.Clamp(count);
+		cell.Holes = 0;
+	}
+	dirtycells.Clear();
+}
+
+//===========================================================================
+//
+// bench_blockmap [count] [passes]
+//
+// Packs <count> small solid actors next to each other around the player and
+// times relinking all of them and checking every one's position against its
+// neighbours. The actors are destroyed again afterwards.
+//
+//===========================================================================
+
+CCMD(bench_blockmap)
+{
+	if (gamestate != GS_LEVEL || players[consoleplayer].mo == nullptr)
+	{
+		Printf("bench_blockmap can only be used in a level\n");
+		return;
+	}
+	if (netgame || demorecording || demoplayback)
+	{
+		Printf("bench_blockmap cannot be used in netgames or demos\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 20000;
+	int passes = argv.argc() > 2 ? MAX(atoi(argv[2]), 1) : 5;
+
+	AActor *pmo = players[consoleplayer].mo;
+	auto Level = pmo->Level;
+	const double radius = 4;
+	const double spacing = radius * 2 + 1;
+	int side = (int)ceil(sqrt((double)count));
+
+	TArray<AActor *> actors;
+	actors.Reserve(count);
+	for (int i = 0; i < count; i++)
+	{
+		DVector3 pos(pmo->X() + (i % side - side / 2) * spacing, pmo->Y() + (i / side - side / 2) * spacing, pmo->Z());
+		AActor *mo = Spawn(Level, RUNTIME_CLASS(AActor), pos, NO_REPLACE);
+		mo->UnlinkFromWorld(nullptr);
+		mo->flags |= MF_SOLID | MF_NOGRAVITY;
+		mo->radius = radius;
+		mo->Height = 16;
+		mo->LinkToWorld(nullptr);
+		actors[i] = mo;
+	}
+	Level->blockmap.CompactCells();
+
+	unsigned occupied = 0, largest = 0;
+	for (int i = 0; i < Level->blockmap.bmapwidth * Level->blockmap.bmapheight; i++)
+	{
+		unsigned size = Level->blockmap.blockcells[i].Entries.Size();
+		if (size > 0) occupied++;
+		largest = MAX(largest, size);
+	}
+
+	cycle_t relink, check;
+	relink.Reset();
+	check.Reset();
+	int blocked = 0;
+	for (int p = 0; p < passes; p++)
+	{
+		relink.Clock();
+		for (auto mo : actors)
+		{
+			mo->UnlinkFromWorld(nullptr);
+			mo->LinkToWorld(nullptr);
+		}
+		Level->blockmap.CompactCells();
+		relink.Unclock();
+
+		check.Clock();
+		for (auto mo : actors)
+		{
+			if (!P_CheckPosition(mo, mo->Pos(), true)) blocked++;
+		}
+		check.Unclock();
+	}
+
+	for (auto mo : actors) mo->Destroy();
+	Level->blockmap.CompactCells();
+
+	Printf("%d actors in %u blocks, up to %u per block, %d passes\n", count, occupied, largest, passes);
+	Printf("relink:          %.3f ms per pass\n", relink.TimeMS() / passes);
+	Printf("P_CheckPosition: %.3f ms per pass, %d blocked\n", check.TimeMS() / passes, blocked / passes);
+}
+
 //===========================================================================
 //
 // FBlockThingsIterator :: FBlockThingsIterator
@@ -895,7 +1010,8 @@ FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l)
 	minx = maxx = 0;
 	miny = maxy = 0;
 	ClearHash();
-	block = NULL;
+	cell = NULL;
+	cellpos = 0;
 }
 
 FBlockThingsIterator::FBlockThingsIterator(FLevelLocals *l, int _minx, int _miny, int _maxx, int _maxy)
@@ -929,10 +1045,38 @@ void FBlockThingsIterator::init(const FBoundingBox &box)
 void FBlockThingsIterator::ClearHash()
 {
 	memset(Buckets, -1, sizeof(Buckets));
+	BigBuckets.Clear();
 	NumFixedHash = 0;
 	DynHash.Clear();
 }
 
+//===========================================================================
+//
+// FBlockThingsIterator :: GrowHash
+//
+// Large area checks among many monsters return thousands of actors that
+// span more than one block, which makes the chains of the fixed buckets
+// long. This only changes how already returned actors are found again,
+// not which actors are returned or in what order.
+//
+//===========================================================================
+
+void FBlockThingsIterator::GrowHash()
+{
+	int count = NumFixedHash + DynHash.Size();
+	unsigned size = MAX(BigBuckets.Size(), (unsigned)countof(Buckets)) * 8;
+
+	BigBuckets.Resize(size);
+	memset(BigBuckets.Data(), -1, size * sizeof(int));
+	for (int i = 0; i < count; i++)
+	{
+		HashEntry *entry = GetHashEntry(i);
+		int &bucket = GetBucket((size_t)entry->Actor >> 3);
+		entry->Next = bucket;
+		bucket = i;
+	}
+}
+
 //===========================================================================
 //
 // FBlockThingsIterator :: StartBlock
@@ -945,12 +1089,14 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 	cury = y;
 	if (Level->blockmap.isValidBlock(x, y))
 	{
-		block = Level->blockmap.blocklinks[y*Level->blockmap.bmapwidth + x];
+		cell = &Level->blockmap.blockcells[y*Level->blockmap.bmapwidth + x];
+		cellpos = cell->Entries.Size();
 	}
 	else
 	{
 		// invalid block
-		block = NULL;
+		cell = NULL;
+		cellpos = 0;
 	}
 }
 
@@ -977,14 +1123,15 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 {
 	for (;;)
 	{
-		while (block != NULL)
+		while (cellpos > 0)
 		{
-			AActor *me = block->Me;
-			FBlockNode *mynode = block;
+			FBlockEntry &cellentry = cell->Entries[--cellpos];
+			AActor *me = cellentry.Me;
+			FBlockNode *mynode = cellentry.Node;
 			HashEntry *entry;
 			int i;
 
-			block = block->NextActor;
+			if (me == NULL) continue;	// unlinked since the last compaction
 			// Don't recheck things that were already checked
 			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
@@ -1007,8 +1154,8 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 			}
 			else
 			{
-				size_t hash = ((size_t)me >> 3) % countof(Buckets);
-				for (i = Buckets[hash]; i >= 0; )
+				size_t hash = (size_t)me >> 3;
+				for (i = GetBucket(hash); i >= 0; )
 				{
 					entry = GetHashEntry(i);
 					if (entry->Actor == me)
@@ -1019,11 +1166,12 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 				}
 				if (i < 0)
 				{ // Add me to the hash table and return me.
+					int &bucket = GetBucket(hash);
 					if (NumFixedHash < (int)countof(FixedHash))
 					{
 						entry = &FixedHash[NumFixedHash];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = NumFixedHash++;
+						entry->Next = bucket;
+						bucket = NumFixedHash++;
 					}
 					else
 					{
@@ -1033,10 +1181,14 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 						}
 						i = DynHash.Reserve(1);
 						entry = &DynHash[i];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = i + countof(FixedHash);
+						entry->Next = bucket;
+						bucket = i + countof(FixedHash);
 					}
 					entry->Actor = me;
+					if (DynHash.Size() > 4 * MAX(BigBuckets.Size(), (unsigned)countof(Buckets)))
+					{
+						GrowHash();
+					}
 					return me;
 				}
 			}
@@ -1178,6 +1330,12 @@ TArray<intercept_t> FPathTraverse::intercepts(128);
 
 void FPathTraverse::AddLineIntercepts(int bx, int by)
 {
+	if (sharedorigin)
+	{
+		AddSharedLineIntercepts(bx, by);
+		return;
+	}
+
 	FBlockLinesIterator it(Level, bx, by, bx, by, true);
 	line_t *ld;
 
@@ -1210,6 +1368,145 @@ void FPathTraverse::AddLineIntercepts(int bx, int by)
 }
 
 
+//===========================================================================
+//
+// Shared line collection
+//
+// Multi-pellet attacks start many traces from the same spot. For those the
+// lines of each block are collected only once, in the same order the block
+// iterator returns them, with their vertices already made relative to the
+// origin. This is the first half of P_PointOnDivlineSide, so the side checks
+// and everything that follows come out exactly like in a regular traversal.
+// The cache is dropped when the origin changes or a polyobject relinks.
+//
+//===========================================================================
+
+struct FSharedTraceLine
+{
+	line_t *line;
+	FPolyObj *poly;
+	double y1, x1, y2, x2;
+};
+
+struct FSharedTraceBlock
+{
+	unsigned first;
+	unsigned count;
+	int stamp;
+};
+
+static struct
+{
+	FLevelLocals *Level = nullptr;
+	double x, y;
+	int epoch;
+	int stamp;
+	TArray<FSharedTraceBlock> Blocks;
+	TArray<FSharedTraceLine> Lines;
+	unsigned hits, misses;
+} SharedLines;
+
+void FPathTraverse::ClearSharedLines()
+{
+	SharedLines.Level = nullptr;
+	SharedLines.Blocks.Clear();
+	SharedLines.Lines.Clear();
+}
+
+void FPathTraverse::AddSharedLineIntercepts(int bx, int by)
+{
+	if (!Level->blockmap.isValidBlock(bx, by)) return;
+
+	if (SharedLines.Level != Level || SharedLines.x != trace.x || SharedLines.y != trace.y || SharedLines.epoch != seclistepoch)
+	{
+		unsigned numblocks = Level->blockmap.bmapwidth * Level->blockmap.bmapheight;
+		if (SharedLines.Level != Level || SharedLines.Blocks.Size() != numblocks)
+		{
+			SharedLines.Blocks.Resize(numblocks);
+			memset(SharedLines.Blocks.Data(), 0, numblocks * sizeof(FSharedTraceBlock));
+			SharedLines.stamp = 0;
+		}
+		SharedLines.Lines.Clear();
+		SharedLines.Level = Level;
+		SharedLines.x = trace.x;
+		SharedLines.y = trace.y;
+		SharedLines.epoch = seclistepoch;
+		SharedLines.stamp++;
+	}
+
+	int index = by * Level->blockmap.bmapwidth + bx;
+	FSharedTraceBlock *block = &SharedLines.Blocks[index];
+	if (block->stamp != SharedLines.stamp)
+	{
+		SharedLines.misses++;
+		block->stamp = SharedLines.stamp;
+		block->first = SharedLines.Lines.Size();
+
+		auto addline = [&](line_t *ld, FPolyObj *poly)
+		{
+			auto &entry = SharedLines.Lines[SharedLines.Lines.Reserve(1)];
+			entry.line = ld;
+			entry.poly = poly;
+			entry.y1 = ld->v1->fY() - trace.y;
+			entry.x1 = trace.x - ld->v1->fX();
+			entry.y2 = ld->v2->fY() - trace.y;
+			entry.x2 = trace.x - ld->v2->fX();
+		};
+
+		polyblock_t *polyLink = (unsigned)index < Level->PolyBlockMap.Size() ? Level->PolyBlockMap[index] : nullptr;
+		for (; polyLink != nullptr; polyLink = polyLink->next)
+		{
+			if (polyLink->polyobj == nullptr) continue;
+			for (auto ld : polyLink->polyobj->Linedefs) addline(ld, polyLink->polyobj);
+		}
+		for (int *list = Level->blockmap.GetLines(bx, by); *list != -1; list++)
+		{
+			addline(&Level->lines[*list], nullptr);
+		}
+		block->count = SharedLines.Lines.Size() - block->first;
+	}
+	else
+	{
+		SharedLines.hits++;
+	}
+
+	// Polyobject lines can also be reached through other blocks, so the validcount check covers them the same way the block iterator's does.
+	for (unsigned i = block->first; i < block->first + block->count; i++)
+	{
+		FSharedTraceLine &entry = SharedLines.Lines[i];
+		line_t *ld = entry.line;
+
+		if (entry.poly != nullptr) entry.poly->validcount = validcount;
+		if (ld->validcount == validcount) continue;
+		ld->validcount = validcount;
+
+		int s1 = entry.y1 * trace.dx + entry.x1 * trace.dy > EQUAL_EPSILON;
+		int s2 = entry.y2 * trace.dx + entry.x2 * trace.dy > EQUAL_EPSILON;
+		if (s1 == s2) continue;	// line isn't crossed
+
+		divline_t dl;
+		P_MakeDivline(ld, &dl);
+		double frac = P_InterceptVector(&trace, &dl);
+
+		if (frac < Startfrac || frac > 1.) continue;	// behind source or beyond end point
+
+		intercept_t newintercept;
+
+		newintercept.frac = frac;
+		newintercept.isaline = true;
+		newintercept.done = false;
+		newintercept.d.line = ld;
+		intercepts.Push(newintercept);
+	}
+}
+
+ADD_STAT(sharedtraces)
+{
+	FString out;
+	out.Format("Shared trace blocks: %u reused, %u collected, %u lines cached", SharedLines.hits, SharedLines.misses, SharedLines.Lines.Size());
+	return out;
+}
+
 //===========================================================================
 //
 // FPathTraverse :: AddThingIntercepts
@@ -1461,6 +1758,7 @@ void FPathTraverse::init(double x1, double y1, double x2, double y2, int flags,
 	validcount++;
 	intercept_index = intercepts.Size();
 	Startfrac = startfrac;
+	sharedorigin = (flags & PT_SHAREORIGIN) && startfrac == 0;
 
 	if (flags & PT_DELTA)
 	{
@@ -1796,23 +2094,24 @@ static AActor *RoughBlockCheck (AActor *mo, int index, void *param)
 {
 	BlockCheckInfo *info = (BlockCheckInfo *)param;
 
-	FBlockNode *link;
+	auto &entries = mo->Level->blockmap.blockcells[index].Entries;
 
-	for (link = mo->Level->blockmap.blocklinks[index]; link != NULL; link = link->NextActor)
+	for (int i = (int)entries.Size() - 1; i >= 0; i--)
 	{
-		if (link->Me != mo)
+		AActor *link = entries[i].Me;
+		if (link != NULL && link != mo)
 		{
-			if (info->onlyseekable && !mo->CanSeek(link->Me))
+			if (info->onlyseekable && !mo->CanSeek(link))
 			{
 				continue;
 			}
-			if (info->frontonly && P_PointOnDivlineSide(link->Me->X(), link->Me->Y(), &info->frontline) != 0)
+			if (info->frontonly && P_PointOnDivlineSide(link->X(), link->Y(), &info->frontline) != 0)
 			{
 				continue;
 			}
-			if (mo->IsOkayToAttack (link->Me))
+			if (mo->IsOkayToAttack (link))
 			{
-				return link->Me;
+				return link;
 			}
 		}
 	}
@@ -1945,20 +2244,18 @@ int P_VanillaPointOnLineSide(double x, double y, const line_t* line)
 
 subsector_t *FLevelLocals::PointInSubsector(double x, double y)
 {
-	int side;
-
-	auto node = HeadGamenode();
-	if (node == nullptr) return &subsectors[0];
+	if (HeadGamenode() == nullptr) return &subsectors[0];
+	return subsectorgrid.Find(FloatToFixed(x), FloatToFixed(y));
+}
 
-	fixed_t xx = FloatToFixed(x);
-	fixed_t yy = FloatToFixed(y);
-	do
+void FLevelLocals::PointInSubsector(unsigned count, const double *x, const double *y, subsector_t **result)
+{
+	if (HeadGamenode() == nullptr)
 	{
-		side = R_PointOnSide(xx, yy, node);
-		node = (node_t *)node->children[side];
-	} while (!((size_t)node & 1));
-
-	return (subsector_t *)((uint8_t *)node - 1);
+		for (unsigned i = 0; i < count; i++) result[i] = &subsectors[0];
+		return;
+	}
+	subsectorgrid.Find(count, x, y, result);
 }
 
 //==========================================================================
@@ -1998,22 +2295,282 @@ sector_t *FLevelLocals::PointInSectorBuggy(double x, double y)
 
 subsector_t *FLevelLocals::PointInRenderSubsector (fixed_t x, fixed_t y)
 {
-	node_t *node;
-	int side;
-	
 	// single subsector is a special case
 	if (nodes.Size() == 0)
 		return &subsectors[0];
-	
-	node = HeadNode();
-	
-	do
+
+	return rendersubsectorgrid.Find(x, y);
+}
+
+void FLevelLocals::PointInRenderSubsector (unsigned count, const double *x, const double *y, subsector_t **result)
+{
+	if (nodes.Size() == 0)
 	{
-		side = R_PointOnSide (x, y, node);
-		node = (node_t *)node->children[side];
+		for (unsigned i = 0; i < count; i++) result[i] = &subsectors[0];
+		return;
+	}
+	rendersubsectorgrid.Find(count, x, y, result);
+}
+
+//==========================================================================
+//
+// FSubsectorGrid :: Build
+//
+// The side check is linear in the point's coordinates, so if all four
+// corners of a block of cells are on the same side of a node, the
+// entire block is, and the descent for it can continue with that child
+// without changing the result for any point inside.
+//
+//==========================================================================
+
+static int BlockOnNodeSide(const node_t *node, int64_t x0, int64_t y0, int64_t x1, int64_t y1)
+{
+	int sides = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		int64_t x = (i & 1) ? x1 : x0;
+		int64_t y = (i & 2) ? y1 : y0;
+		int64_t dx = node->x - x;
+		int64_t dy = y - node->y;
+		// If any of these overflow in R_PointOnSide, the check is no longer linear.
+		if (x != int32_t(x) || y != int32_t(y) || dx != int32_t(dx) || dy != int32_t(dy))
+			return -1;
+		sides |= 1 << R_PointOnSide(fixed_t(x), fixed_t(y), node);
+	}
+	return sides == 1 ? 0 : sides == 2 ? 1 : -1;
+}
+
+void FSubsectorGrid::BuildBlock(void *node, int cx0, int cy0, int cx1, int cy1)
+{
+	while (!((size_t)node & 1))
+	{
+		node_t *bsp = (node_t *)node;
+		int side = BlockOnNodeSide(bsp, OriginX + (int64_t(cx0) << Shift), OriginY + (int64_t(cy0) << Shift),
+			OriginX + (int64_t(cx1) << Shift) - 1, OriginY + (int64_t(cy1) << Shift) - 1);
+		if (side < 0) break;
+		node = bsp->children[side];
+	}
+
+	if (((size_t)node & 1) || (cx1 - cx0 == 1 && cy1 - cy0 == 1))
+	{
+		for (int cy = cy0; cy < cy1; cy++)
+		{
+			for (int cx = cx0; cx < cx1; cx++)
+			{
+				Cells[cx + cy * Width] = node;
+			}
+		}
+	}
+	else if (cx1 - cx0 >= cy1 - cy0)
+	{
+		int mid = (cx0 + cx1) / 2;
+		BuildBlock(node, cx0, cy0, mid, cy1);
+		BuildBlock(node, mid, cy0, cx1, cy1);
+	}
+	else
+	{
+		int mid = (cy0 + cy1) / 2;
+		BuildBlock(node, cx0, cy0, cx1, mid);
+		BuildBlock(node, cx0, mid, cx1, cy1);
+	}
+}
+
+void FSubsectorGrid::Build(node_t *head, const TArray<vertex_t> &vertexes)
+{
+	enum
+	{
+		MinShift = 6 + FRACBITS,	// 64 map units
+		MaxCells = 1 << 20
+	};
+
+	Clear();
+	if (head == nullptr || vertexes.Size() == 0) return;
+	Head = head;
+
+	int64_t minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
+	for (auto &v : vertexes)
+	{
+		int64_t x = FloatToFixed(v.fX()), y = FloatToFixed(v.fY());
+		minx = MIN(minx, x);
+		miny = MIN(miny, y);
+		maxx = MAX(maxx, x);
+		maxy = MAX(maxy, y);
+	}
+
+	OriginX = minx;
+	OriginY = miny;
+	Shift = MinShift;
+	for (;;)
+	{
+		Width = int(((maxx - minx) >> Shift) + 1);
+		Height = int(((maxy - miny) >> Shift) + 1);
+		if (int64_t(Width) * Height <= MaxCells) break;
+		Shift++;
+	}
+	Cells.Resize(Width * Height);
+	BuildBlock(head, 0, 0, Width, Height);
+}
+
+//==========================================================================
+//
+// FSubsectorGrid :: Find
+//
+//==========================================================================
+
+static inline void *GridStart(const FSubsectorGrid &grid, fixed_t x, fixed_t y)
+{
+	uint64_t cx = uint64_t(x - grid.OriginX) >> grid.Shift;
+	uint64_t cy = uint64_t(y - grid.OriginY) >> grid.Shift;
+	// Negative offsets turn into huge values here so this also catches points below the origin.
+	if (cx >= uint64_t(grid.Width) || cy >= uint64_t(grid.Height)) return grid.Head;
+	return grid.Cells[unsigned(cx + cy * grid.Width)];
+}
+
+subsector_t *FSubsectorGrid::Find(fixed_t x, fixed_t y) const
+{
+	void *node = GridStart(*this, x, y);
+	while (!((size_t)node & 1))
+	{
+		node = ((node_t *)node)->children[R_PointOnSide(x, y, (node_t *)node)];
 	}
-	while (!((size_t)node & 1));
-	
 	return (subsector_t *)((uint8_t *)node - 1);
 }
 
+//==========================================================================
+//
+// Batched lookup
+//
+// Points in cells that don't resolve directly continue down the tree
+// several at a time so that the node loads of one point can overlap with
+// the side checks of the others.
+//
+//==========================================================================
+
+void FSubsectorGrid::Find(unsigned count, const double *x, const double *y, subsector_t **result) const
+{
+	enum { Lanes = 8 };
+	fixed_t fx[Lanes], fy[Lanes];
+	void *lane[Lanes];
+	unsigned index[Lanes];
+	unsigned n = 0;
+
+	auto descend = [&]()
+	{
+		unsigned active;
+		do
+		{
+			active = 0;
+			for (unsigned i = 0; i < n; i++)
+			{
+				if (!((size_t)lane[i] & 1))
+				{
+					node_t *node = (node_t *)lane[i];
+					lane[i] = node->children[R_PointOnSide(fx[i], fy[i], node)];
+					active += !((size_t)lane[i] & 1);
+				}
+			}
+		} while (active > 0);
+
+		for (unsigned i = 0; i < n; i++)
+		{
+			result[index[i]] = (subsector_t *)((uint8_t *)lane[i] - 1);
+		}
+		n = 0;
+	};
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		fixed_t px = FloatToFixed(x[i]);
+		fixed_t py = FloatToFixed(y[i]);
+		void *start = GridStart(*this, px, py);
+		if ((size_t)start & 1)
+		{
+			result[i] = (subsector_t *)((uint8_t *)start - 1);
+			continue;
+		}
+		fx[n] = px;
+		fy[n] = py;
+		lane[n] = start;
+		index[n] = i;
+		if (++n == Lanes) descend();
+	}
+	if (n > 0) descend();
+}
+
+//==========================================================================
+//
+// bench_pointinsubsector [count] [passes]
+//
+// Compares plain BSP descents with the grid lookups for random points on
+// the current map.
+//
+//==========================================================================
+
+static subsector_t *DescendBSP(node_t *node, fixed_t x, fixed_t y)
+{
+	void *p = node;
+	while (!((size_t)p & 1))
+	{
+		p = ((node_t *)p)->children[R_PointOnSide(x, y, (node_t *)p)];
+	}
+	return (subsector_t *)((uint8_t *)p - 1);
+}
+
+CCMD(bench_pointinsubsector)
+{
+	if (gamestate != GS_LEVEL || primaryLevel->HeadNode() == nullptr)
+	{
+		Printf("bench_pointinsubsector can only be used in a level\n");
+		return;
+	}
+	auto Level = primaryLevel;
+	auto &grid = Level->rendersubsectorgrid;
+	unsigned count = argv.argc() > 1 ? clamp(atoi(argv[1]), 1, 10000000) : 1000000;
+	int passes = argv.argc() > 2 ? MAX(atoi(argv[2]), 1) : 5;
+
+	TArray<double> x(count, true), y(count, true);
+	TArray<subsector_t *> bsp(count, true), single(count, true), batch(count, true);
+	double width = double(int64_t(grid.Width) << grid.Shift) / FRACUNIT;
+	double height = double(int64_t(grid.Height) << grid.Shift) / FRACUNIT;
+	for (unsigned i = 0; i < count; i++)
+	{
+		x[i] = FixedToFloat(fixed_t(grid.OriginX)) + width * M_Random() * M_Random() / 65536.;
+		y[i] = FixedToFloat(fixed_t(grid.OriginY)) + height * M_Random() * M_Random() / 65536.;
+	}
+
+	cycle_t bsptime, singletime, batchtime;
+	bsptime.Reset();
+	singletime.Reset();
+	batchtime.Reset();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		bsptime.Clock();
+		for (unsigned i = 0; i < count; i++) bsp[i] = DescendBSP(Level->HeadNode(), FloatToFixed(x[i]), FloatToFixed(y[i]));
+		bsptime.Unclock();
+
+		singletime.Clock();
+		for (unsigned i = 0; i < count; i++) single[i] = Level->PointInRenderSubsector(DVector2(x[i], y[i]));
+		singletime.Unclock();
+
+		batchtime.Clock();
+		Level->PointInRenderSubsector(count, x.Data(), y.Data(), batch.Data());
+		batchtime.Unclock();
+	}
+
+	unsigned direct = 0, mismatches = 0;
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (single[i] != bsp[i] || batch[i] != bsp[i]) mismatches++;
+	}
+	for (auto cell : grid.Cells)
+	{
+		if ((size_t)cell & 1) direct++;
+	}
+
+	double total = double(count) * passes / 1000.;
+	Printf("%d x %d grid, %d%% of the cells resolve directly\n", grid.Width, grid.Height, int(direct * 100. / MAX(grid.Cells.Size(), 1u)));
+	Printf("BSP: %.2f M lookups/s, grid: %.2f M lookups/s, batched: %.2f M lookups/s\n",
+		total / bsptime.TimeMS(), total / singletime.TimeMS(), total / batchtime.TimeMS());
+	if (mismatches > 0) Printf(TEXTCOLOR_RED "%u lookups returned a different subsector than the BSP!\n", mismatches);
+}
+
@@ -9,6 +9,7 @@
 
 extern int validcount;
 struct FBlockNode;
+struct FBlockCell;
 
 struct divline_t
 {
@@ -285,9 +286,11 @@ class FBlockThingsIterator
 
 	int curx, cury;
 
-	FBlockNode *block;
+	FBlockCell *cell;
+	int cellpos;
 
 	int Buckets[32];
+	TArray<int> BigBuckets;		// replaces Buckets once lots of actors spanning several blocks have been returned
 
 	struct HashEntry
 	{
@@ -299,6 +302,8 @@ class FBlockThingsIterator
 	TArray<HashEntry> DynHash;
 
 	HashEntry *GetHashEntry(int i) { return i < (int)countof(FixedHash) ? &FixedHash[i] : &DynHash[i - countof(FixedHash)]; }
+	int &GetBucket(size_t hash) { return BigBuckets.Size() > 0 ? BigBuckets[hash & (BigBuckets.Size() - 1)] : Buckets[hash % countof(Buckets)]; }
+	void GrowHash();
 
 	void StartBlock(int x, int y);
 	void SwitchBlock(int x, int y);
@@ -369,8 +374,10 @@ protected:
 	unsigned int intercept_index;
 	unsigned int intercept_count;
 	unsigned int count;
+	bool sharedorigin;
 
 	virtual void AddLineIntercepts(int bx, int by);
+	void AddSharedLineIntercepts(int bx, int by);
 	virtual void AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible);
 	FPathTraverse(FLevelLocals *l) 
 	{
@@ -390,6 +397,7 @@ public:
 	void PortalRelocate(const DVector2 &disp, int flags, double hitfrac);
 	virtual ~FPathTraverse();
 	const divline_t &Trace() const { return trace; }
+	static void ClearSharedLines();
 
 	inline DVector2 InterceptPoint(const intercept_t *in)
 	{
@@ -415,5 +423,6 @@ double P_InterceptVector(const divline_t *v2, const divline_t *v1);
 #define PT_ADDTHINGS	2
 #define PT_COMPATIBLE	4
 #define PT_DELTA		8		// x2,y2 is passed as a delta, not as an endpoint
+#define PT_SHAREORIGIN	16		// reuse the lines collected by the previous traversal if it started at the same spot
 
 #endif
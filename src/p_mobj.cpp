@@ -151,6 +151,7 @@ CUSTOM_CVAR (Float, sv_gravity, 800.f, CVAR_SERVERINFO|CVAR_NOSAVE|CVAR_NOINITCA
 	}
 }
 
+CVAR (Bool, sv_parkidleactors, false, CVAR_SERVERINFO)
 CVAR (Bool, cl_missiledecals, true, CVAR_ARCHIVE)
 CVAR (Bool, addrocketexplosion, false, CVAR_ARCHIVE)
 CVAR (Int, cl_pufftype, 0, CVAR_ARCHIVE);
@@ -490,6 +491,7 @@ bool AActor::SetState (FState *newstate, bool nofunction)
 {
 	if (debugfile && player && (player->cheats & CF_PREDICTING))
 		fprintf (debugfile, "for pl %d: SetState while predicting!\n", Level->PlayerNum(player));
+	Unpark();
 	do
 	{
 		if (newstate == NULL)
@@ -4037,6 +4039,11 @@ void AActor::Tick ()
 		}
 	}
 
+	if (sv_parkidleactors)
+	{
+		CheckPark();
+	}
+
 	if (tics == -1 || state->GetCanRaise())
 	{
 		int respawn_monsters = G_SkillProperty(SKILLP_Respawn);
@@ -4066,6 +4073,102 @@ void AActor::Tick ()
 	}
 }
 
+//==========================================================================
+//
+// AActor :: IsResting
+//
+// Checks if ticking this actor would do nothing but count down its tics.
+// This is rechecked every tic an actor stays parked so that velocity
+// changes from places that do not wake it up explicitly are still noticed.
+//
+//==========================================================================
+
+bool AActor::IsResting()
+{
+	if (!Vel.isZero() || (flags7 & MF7_HANDLENODELAY))
+	{
+		return false;
+	}
+	if (flags5 & MF5_NOINTERACTION)
+	{
+		return !!(flags & MF_NOBLOCKMAP);
+	}
+	return Z() == floorz && Inventory == nullptr && PoisonDurationReceived == 0 &&
+		!((flags8 & MF8_INSCROLLSEC) && Level->Scrolls.Size() > 0) && Level->BotInfo.botnum == 0;
+}
+
+//==========================================================================
+//
+// AActor :: CheckPark
+//
+// Called at the end of Tick. Parks the actor if its next ticks would
+// only count down its tics.
+//
+//==========================================================================
+
+void AActor::CheckPark()
+{
+	if (player != nullptr || (tics != -1 && tics <= 1) || !IsResting())
+	{
+		return;
+	}
+	if (effects || (flags & (MF_STEALTH | MF_MISSILE | MF_SKULLFLY | MF_UNMORPHED)) || (flags2 & MF2_WINDTHRUST) || (flags4 & MF4_VFRICTION))
+	{
+		return;
+	}
+	// Keep nightmare respawn working
+	if (state->GetCanRaise() || (tics == -1 && ((flags5 & MF5_ALWAYSRESPAWN) || ((flags3 & MF3_ISMONSTER) && G_SkillProperty(SKILLP_Respawn)))))
+	{
+		return;
+	}
+	if (!(flags5 & MF5_NOINTERACTION))
+	{
+		// Corpses still need to enter their crash state.
+		if (((flags & MF_CORPSE) || (flags6 & MF6_KILLED)) && !(flags3 & MF3_CRASHED) && !(flags6 & MF6_DONTCORPSE) && !(flags & MF_ICECORPSE))
+		{
+			return;
+		}
+		// Steep slopes push things off them and height transfers and 3D floors change the water level.
+		if (floorsector->floorplane.isSlope() || Sector->GetHeightSec() != nullptr || Sector->e->XFloor.ffloors.Size() > 0)
+		{
+			return;
+		}
+	}
+	// A script side Tick override can do anything.
+	static unsigned VIndex = ~0u;
+	if (VIndex == ~0u)
+	{
+		VIndex = GetVirtualIndex(RUNTIME_CLASS(AActor), "Tick");
+		assert(VIndex != ~0u);
+	}
+	auto &virtuals = GetClass()->Virtuals;
+	if (virtuals.Size() <= VIndex || virtuals[VIndex] != RUNTIME_CLASS(AActor)->Virtuals[VIndex])
+	{
+		return;
+	}
+	ObjectFlags |= OF_Parked;
+}
+
+//==========================================================================
+//
+// AActor :: TickParked
+//
+// Used by the thinker loop in place of Tick for parked actors. Returns
+// false if the actor got woken up and needs a regular Tick.
+//
+//==========================================================================
+
+bool AActor::TickParked()
+{
+	if ((tics == -1 || tics > 1) && !Level->isFrozen() && IsResting())
+	{
+		if (tics != -1) tics--;
+		return true;
+	}
+	Unpark();
+	return false;
+}
+
 //==========================================================================
 //
 // AActor :: CheckNoDelay
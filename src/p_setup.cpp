@@ -58,6 +58,7 @@
 #include "po_man.h"
 #include "r_renderer.h"
 #include "p_blockmap.h"
+#include "p_maputl.h"
 #include "r_utility.h"
 #include "p_spec.h"
 #include "g_levellocals.h"
@@ -317,6 +318,9 @@ void FLevelLocals::ClearLevelData()
 	rejectmatrix.Clear();
 	Zones.Clear();
 	blockmap.Clear();
+	subsectorgrid.Clear();
+	rendersubsectorgrid.Clear();
+	FPathTraverse::ClearSharedLines();
 	Polyobjects.Clear();
 
 	for (auto &pb : PolyBlockMap)
@@ -0,0 +1,372 @@
+//-----------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION:
+//		Per-tic playsim checksums for catching desyncs.
+//
+//		-recordtichash <file> writes a hash of every actor and of the
+//		RNG state after each tic, e.g. alongside -record or in a netgame.
+//		-checktichash <file> compares against such a file, normally while
+//		playing back the same demo with -playdemo, and reports the first
+//		tic that differs. Every tichash_interval tics the file also holds
+//		a hash per actor, which is used to name the actors that diverged.
+//		Record with an interval of 1 to get them for the exact tic.
+//
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <memory>
+#include "doomdef.h"
+#include "p_local.h"
+#include "doomstat.h"
+#include "g_levellocals.h"
+#include "actor.h"
+#include "info.h"
+#include "m_argv.h"
+#include "m_crc32.h"
+#include "m_random.h"
+#include "files.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "v_text.h"
+
+CVAR(Int, tichash_interval, 35, CVAR_ARCHIVE)
+
+enum
+{
+	TICHASH_ID = MAKE_ID('T','I','C','H'),
+	TICHASH_VERSION = 1,
+	MAX_REPORTED_ACTORS = 10
+};
+
+// All values are stored in the machine's native byte order.
+struct FTicHashHeader
+{
+	uint32_t Tic;
+	uint32_t NumActors;
+	uint64_t RNGHash;
+	uint64_t ActorHash;
+	uint32_t HasActors;		// if set, NumActors FTicHashActor entries follow
+	uint32_t Pad;
+};
+
+struct FTicHashActor
+{
+	uint32_t SpawnOrder;
+	uint32_t ClassCRC;
+	uint64_t Hash;
+};
+
+static std::unique_ptr<FileWriter> RecordFile;	// closed at exit so that everything gets written
+static FileReader CheckFile;
+static bool CheckActive;
+static bool TicHashInited;
+
+static int TicsChecked;
+static int FirstDivergence = -1;
+static bool ActorsReported;
+
+static TMap<const PClass *, uint32_t> ClassCRCs;
+static TMap<const FState *, uint32_t> StateIDs;
+static TArray<FTicHashActor> CurrentActors;
+static TArray<FTicHashActor> ExpectedActors;
+
+//==========================================================================
+//
+// Hashing
+//
+// Pointers differ between runs, so classes and states are identified by
+// their names instead.
+//
+//==========================================================================
+
+static inline uint64_t HashBytes(uint64_t hash, const void *data, size_t len)
+{
+	auto bytes = (const uint8_t *)data;
+	for (size_t i = 0; i < len; i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+template<class T> static inline uint64_t HashValue(uint64_t hash, const T &value)
+{
+	return HashBytes(hash, &value, sizeof(value));
+}
+
+static uint32_t GetClassCRC(const PClass *cls)
+{
+	uint32_t *crc = ClassCRCs.CheckKey(cls);
+	if (crc != nullptr) return *crc;
+
+	const char *name = cls->TypeName.GetChars();
+	return ClassCRCs[cls] = CalcCRC32((const uint8_t *)name, (unsigned)strlen(name));
+}
+
+static uint32_t GetStateID(AActor *actor)
+{
+	const FState *state = actor->state;
+	if (state == nullptr) return 0;
+
+	uint32_t *id = StateIDs.CheckKey(state);
+	if (id != nullptr) return *id;
+
+	PClassActor *owner = FState::StaticFindStateOwner(state, actor->GetClass());
+	if (owner == nullptr) owner = FState::StaticFindStateOwner(state);
+	uint32_t value = owner == nullptr ? 0xffffffff : GetClassCRC(owner) ^ (uint32_t(state - owner->GetStates()) * 0x9e3779b1u);
+	return StateIDs[state] = value;
+}
+
+static uint64_t HashActor(AActor *actor)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = HashValue(hash, actor->Pos());
+	hash = HashValue(hash, actor->Vel);
+	hash = HashValue(hash, actor->Angles.Yaw.Degrees);
+	hash = HashValue(hash, actor->Angles.Pitch.Degrees);
+	hash = HashValue(hash, actor->health);
+	hash = HashValue(hash, actor->tics);
+	hash = HashValue(hash, GetStateID(actor));
+	return hash;
+}
+
+//==========================================================================
+//
+// P_TicHashInit
+//
+//==========================================================================
+
+static void P_TicHashInit()
+{
+	TicHashInited = true;
+
+	const char *name = Args->CheckValue("-recordtichash");
+	if (name != nullptr)
+	{
+		RecordFile.reset(FileWriter::Open(name));
+		if (RecordFile == nullptr)
+		{
+			Printf(TEXTCOLOR_RED "Could not open %s for writing tic hashes\n", name);
+		}
+		else
+		{
+			uint32_t header[3] = { (uint32_t)TICHASH_ID, TICHASH_VERSION, (uint32_t)MAX(*tichash_interval, 1) };
+			RecordFile->Write(header, sizeof(header));
+		}
+	}
+
+	name = Args->CheckValue("-checktichash");
+	if (name != nullptr)
+	{
+		uint32_t header[3];
+		if (!CheckFile.OpenFile(name) || CheckFile.Read(header, sizeof(header)) != sizeof(header) ||
+			header[0] != (uint32_t)TICHASH_ID || header[1] != TICHASH_VERSION)
+		{
+			Printf(TEXTCOLOR_RED "%s is not a tic hash file\n", name);
+		}
+		else
+		{
+			CheckActive = true;
+		}
+	}
+}
+
+//==========================================================================
+//
+// Reports actors that differ from the recording
+//
+//==========================================================================
+
+static AActor *FindActor(uint32_t spawnorder)
+{
+	for (auto Level : AllLevels())
+	{
+		auto it = Level->GetThinkerIterator<AActor>();
+		AActor *ac;
+		while ((ac = it.Next()))
+		{
+			if (ac->SpawnOrder == spawnorder) return ac;
+		}
+	}
+	return nullptr;
+}
+
+static void ReportActors(int tic)
+{
+	auto order = [](const FTicHashActor &a, const FTicHashActor &b) { return a.SpawnOrder < b.SpawnOrder; };
+	std::sort(CurrentActors.begin(), CurrentActors.end(), order);
+	std::sort(ExpectedActors.begin(), ExpectedActors.end(), order);
+
+	int reported = 0;
+	unsigned i = 0, j = 0;
+	while ((i < CurrentActors.Size() || j < ExpectedActors.Size()) && reported < MAX_REPORTED_ACTORS)
+	{
+		if (j == ExpectedActors.Size() || (i < CurrentActors.Size() && CurrentActors[i].SpawnOrder < ExpectedActors[j].SpawnOrder))
+		{
+			AActor *ac = FindActor(CurrentActors[i].SpawnOrder);
+			Printf("  actor %u (%s) does not exist in the recording\n", CurrentActors[i].SpawnOrder, ac ? ac->GetClass()->TypeName.GetChars() : "?");
+			reported++;
+			i++;
+		}
+		else if (i == CurrentActors.Size() || ExpectedActors[j].SpawnOrder < CurrentActors[i].SpawnOrder)
+		{
+			Printf("  actor %u is missing\n", ExpectedActors[j].SpawnOrder);
+			reported++;
+			j++;
+		}
+		else
+		{
+			if (CurrentActors[i].Hash != ExpectedActors[j].Hash || CurrentActors[i].ClassCRC != ExpectedActors[j].ClassCRC)
+			{
+				AActor *ac = FindActor(CurrentActors[i].SpawnOrder);
+				if (ac != nullptr)
+				{
+					Printf("  actor %u (%s) differs: pos %.3f,%.3f,%.3f vel %.3f,%.3f,%.3f health %d state %s\n", ac->SpawnOrder, ac->GetClass()->TypeName.GetChars(),
+						ac->X(), ac->Y(), ac->Z(), ac->Vel.X, ac->Vel.Y, ac->Vel.Z, ac->health,
+						ac->state ? FState::StaticGetStateName(ac->state).GetChars() : "null");
+				}
+				reported++;
+			}
+			i++;
+			j++;
+		}
+	}
+	if (reported == 0)
+	{
+		Printf("  all actors match, the difference is in the RNG state\n");
+	}
+	else if (tic != FirstDivergence)
+	{
+		Printf("  (actor hashes are from tic %d, record with a lower tichash_interval to get them for tic %d)\n", tic, FirstDivergence);
+	}
+}
+
+//==========================================================================
+//
+// Compares the current tic against the recording
+//
+//==========================================================================
+
+static void CheckTic(const FTicHashHeader &current)
+{
+	FTicHashHeader expected;
+
+	// Skip ahead to the current tic. Tics that were never recorded are ignored.
+	for (;;)
+	{
+		if (CheckFile.Read(&expected, sizeof(expected)) != sizeof(expected))
+		{
+			Printf("End of tic hash recording reached at tic %d, %d tics checked%s\n", current.Tic, TicsChecked,
+				FirstDivergence < 0 ? ", no differences" : "");
+			CheckActive = false;
+			return;
+		}
+		ExpectedActors.Resize(expected.HasActors ? expected.NumActors : 0);
+		if (ExpectedActors.Size() > 0 &&
+			CheckFile.Read(ExpectedActors.Data(), ExpectedActors.Size() * sizeof(FTicHashActor)) != long(ExpectedActors.Size() * sizeof(FTicHashActor)))
+		{
+			CheckActive = false;
+			return;
+		}
+		if (expected.Tic >= current.Tic) break;
+	}
+	if (expected.Tic > current.Tic)
+	{
+		CheckFile.Seek(-long(sizeof(expected) + ExpectedActors.Size() * sizeof(FTicHashActor)), FileReader::SeekCur);
+		return;
+	}
+
+	TicsChecked++;
+	if (FirstDivergence < 0 && (expected.RNGHash != current.RNGHash || expected.ActorHash != current.ActorHash || expected.NumActors != current.NumActors))
+	{
+		FirstDivergence = current.Tic;
+		Printf(TEXTCOLOR_RED "Playsim diverged at tic %d:%s%s%s\n", current.Tic,
+			expected.RNGHash != current.RNGHash ? " RNG state differs" : "",
+			expected.ActorHash != current.ActorHash ? " actor state differs" : "",
+			expected.NumActors != current.NumActors ? " actor count differs" : "");
+	}
+	if (FirstDivergence >= 0 && !ActorsReported && expected.HasActors)
+	{
+		ActorsReported = true;
+		ReportActors(current.Tic);
+	}
+}
+
+//==========================================================================
+//
+// P_TicHash
+//
+// Called after every playsim tic.
+//
+//==========================================================================
+
+void P_TicHash()
+{
+	if (!TicHashInited) P_TicHashInit();
+	if (RecordFile == nullptr && !CheckActive) return;
+
+	FTicHashHeader header = {};
+	header.Tic = gametic;
+	header.RNGHash = FRandom::StaticHashState(0xcbf29ce484222325ull);
+
+	// The sum does not depend on the thinker order, so changes that only
+	// reorder thinking without changing the outcome won't be flagged.
+	CurrentActors.Clear();
+	for (auto Level : AllLevels())
+	{
+		auto it = Level->GetThinkerIterator<AActor>();
+		AActor *ac;
+		while ((ac = it.Next()))
+		{
+			FTicHashActor entry = { ac->SpawnOrder, GetClassCRC(ac->GetClass()), HashActor(ac) };
+			header.ActorHash += entry.Hash ^ (uint64_t(entry.SpawnOrder) << 32 | entry.ClassCRC);
+			CurrentActors.Push(entry);
+		}
+	}
+	header.NumActors = CurrentActors.Size();
+
+	if (RecordFile != nullptr)
+	{
+		header.HasActors = gametic % MAX(*tichash_interval, 1) == 0;
+		RecordFile->Write(&header, sizeof(header));
+		if (header.HasActors)
+		{
+			RecordFile->Write(CurrentActors.Data(), CurrentActors.Size() * sizeof(FTicHashActor));
+		}
+	}
+	if (CheckActive)
+	{
+		CheckTic(header);
+	}
+}
+
+CCMD(tichash)
+{
+	if (!TicHashInited) P_TicHashInit();
+	if (RecordFile == nullptr && !CheckActive && TicsChecked == 0)
+	{
+		Printf("Not recording or checking tic hashes. Use -recordtichash or -checktichash on the command line.\n");
+		return;
+	}
+	if (RecordFile != nullptr) Printf("Recording tic hashes\n");
+	if (TicsChecked > 0)
+	{
+		if (FirstDivergence < 0) Printf("%d tics checked, no differences\n", TicsChecked);
+		else Printf("%d tics checked, first difference at tic %d\n", TicsChecked, FirstDivergence);
+	}
+}
@@ -125,6 +125,9 @@ void P_Ticker (void)
 		S_ResumeSound (false);
 
 	P_ResetSightCounters (false);
+	P_ResetLightLinkCounters ();
+	P_ResetSecnodeStats();
+	P_ResetRadiusAttackStats();
 	R_ClearInterpolationPath();
 
 	// Since things will be moving, it's okay to interpolate them in the renderer.
@@ -142,6 +145,7 @@ void P_Ticker (void)
 		{
 			ac->ClearInterpolation();
 		}
+		Level->blockmap.CompactCells();
 		P_ThinkParticles(Level);	// [RH] make the particles think
 
 		for (i = 0; i < MAXPLAYERS; i++)
@@ -166,4 +170,5 @@ void P_Ticker (void)
 		Level->totaltime++;
 	}
 	StatusBar->CallTick();		// Status bar should tick AFTER the thinkers to properly reflect the level's state at this time.
+	P_TicHash();
 }
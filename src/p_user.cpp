@@ -1431,11 +1431,7 @@ void P_PredictPlayer (player_t *player)
 
 	while (block != NULL)
 	{
-		if (block->NextActor != NULL)
-		{
-			block->NextActor->PrevActor = block->PrevActor;
-		}
-		*(block->PrevActor) = block->NextActor;
+		act->Level->blockmap.UnlinkNode(block);
 		block = block->NextBlock;
 	}
 	act->BlockNode = NULL;
@@ -1569,19 +1565,21 @@ void P_UnPredictPlayer ()
 			act->touching_lineportallist = RestoreNodeList(act, lineportal_list, &FLinePortal::lineportal_thinglist, PredictionPortalLines_sprev_Backup, PredictionPortalLinesBackup);
 		}
 
-		// Now fix the pointers in the blocknode chain
+		// Now put the block nodes back into their old places. The cells cannot
+		// have been compacted because no tic was run while predicting.
 		FBlockNode *block = act->BlockNode;
 
 		while (block != NULL)
 		{
-			*(block->PrevActor) = block;
-			if (block->NextActor != NULL)
-			{
-				block->NextActor->PrevActor = &block->NextActor;
-			}
+			act->Level->blockmap.RestoreNode(block);
 			block = block->NextBlock;
 		}
 
+		// Every predicted move appended entries to the cells and left holes behind.
+		// Remove them now, because while a netgame waits for the other players
+		// no tic gets run that would do it, and prediction happens every frame.
+		act->Level->blockmap.CompactCells();
+
 		actInvSel = InvSel;
 		player->inventorytics = inventorytics;
 	}
@@ -56,6 +56,20 @@ extern TDeletingArray<FVoxelDef *> VoxelDefs;
 TDeletingArray<FModel*> Models;
 
 void FModelRenderer::RenderModel(float x, float y, float z, FSpriteModelFrame *smf, AActor *actor, double ticFrac)
+{
+	FModelDrawInfo info;
+	PrepareModel(info, x, y, z, smf, actor, ticFrac);
+	RenderModel(info, smf, actor);
+}
+
+void FModelRenderer::RenderModel(const FModelDrawInfo &info, FSpriteModelFrame *smf, AActor *actor)
+{
+	BeginDrawModel(actor, smf, info.objectToWorldMatrix, info.mirrored);
+	RenderFrameModels(smf, info.anim, info.translation);
+	EndDrawModel(actor, smf);
+}
+
+void FModelRenderer::PrepareModel(FModelDrawInfo &info, float x, float y, float z, FSpriteModelFrame *smf, AActor *actor, double ticFrac, FModelAnimationCache *cache)
 {
 	// Setup transformation.
 
@@ -122,7 +136,7 @@ void FModelRenderer::RenderModel(float x, float y, float z, FSpriteModelFrame *s
 	}
 	if (smf->flags & MDL_USEACTORROLL) roll += angles.Roll.Degrees;
 
-	VSMatrix objectToWorldMatrix;
+	VSMatrix &objectToWorldMatrix = info.objectToWorldMatrix;
 	objectToWorldMatrix.loadIdentity();
 
 	// Model space => World space
@@ -172,9 +186,10 @@ void FModelRenderer::RenderModel(float x, float y, float z, FSpriteModelFrame *s
 
 	float orientation = scaleFactorX * scaleFactorY * scaleFactorZ;
 
-	BeginDrawModel(actor, smf, objectToWorldMatrix, orientation < 0);
-	RenderFrameModels(actor->Level, smf, actor->state, actor->tics, actor->GetClass(), translation);
-	EndDrawModel(actor, smf);
+	info.mirrored = orientation < 0;
+	info.translation = translation;
+	if (cache) info.anim = cache->Get(actor->Level, smf, actor->state, actor->tics, actor->GetClass());
+	else info.anim = GetAnimation(actor->Level, smf, actor->state, actor->tics, actor->GetClass());
 }
 
 void FModelRenderer::RenderHUDModel(DPSprite *psp, float ofsX, float ofsY)
@@ -211,15 +226,15 @@ void FModelRenderer::RenderHUDModel(DPSprite *psp, float ofsX, float ofsY)
 	float orientation = smf->xscale * smf->yscale * smf->zscale;
 
 	BeginDrawHUDModel(playermo, objectToWorldMatrix, orientation < 0);
-	RenderFrameModels(playermo->Level, smf, psp->GetState(), psp->GetTics(), playermo->player->ReadyWeapon->GetClass(), 0);
+	RenderFrameModels(smf, GetAnimation(playermo->Level, smf, psp->GetState(), psp->GetTics(), playermo->player->ReadyWeapon->GetClass()), 0);
 	EndDrawHUDModel(playermo);
 }
 
-void FModelRenderer::RenderFrameModels(FLevelLocals *Level, const FSpriteModelFrame *smf, const FState *curState, const int curTics, const PClass *ti, int translation)
+FModelAnimation FModelRenderer::GetAnimation(FLevelLocals *Level, const FSpriteModelFrame *smf, const FState *curState, int curTics, const PClass *ti)
 {
 	// [BB] Frame interpolation: Find the FSpriteModelFrame smfNext which follows after smf in the animation
 	// and the scalar value inter ( element of [0,1) ), both necessary to determine the interpolated frame.
-	FSpriteModelFrame * smfNext = nullptr;
+	const FSpriteModelFrame * smfNext = nullptr;
 	double inter = 0.;
 	if (gl_interpolate_model_frames && !(smf->flags & MDL_NOINTERPOLATION))
 	{
@@ -262,6 +277,31 @@ void FModelRenderer::RenderFrameModels(FLevelLocals *Level, const FSpriteModelFr
 			}
 		}
 	}
+	return { smfNext, inter };
+}
+
+FModelAnimation FModelAnimationCache::Get(FLevelLocals *Level, const FSpriteModelFrame *smf, const FState *curState, int curTics, const PClass *ti)
+{
+	size_t hash = (size_t)smf ^ ((size_t)curState >> 4) ^ (size_t)curTics * 0x9E3779B1u;
+	Entry &entry = Entries[(hash ^ (hash >> 8)) % NumEntries];
+	if (entry.smf == smf && entry.state == curState && entry.tics == curTics && entry.type == ti)
+	{
+		Hits++;
+		return entry.anim;
+	}
+	Misses++;
+	entry.smf = smf;
+	entry.state = curState;
+	entry.tics = curTics;
+	entry.type = ti;
+	entry.anim = FModelRenderer::GetAnimation(Level, smf, curState, curTics, ti);
+	return entry.anim;
+}
+
+void FModelRenderer::RenderFrameModels(const FSpriteModelFrame *smf, const FModelAnimation &anim, int translation)
+{
+	const FSpriteModelFrame *smfNext = anim.smfNext;
+	double inter = anim.inter;
 
 	for (int i = 0; i<MAX_MODELS_PER_FRAME; i++)
 	{
@@ -56,12 +56,57 @@ enum ModelRendererType
 	NumModelRendererTypes
 };
 
+// Second frame and interpolation factor of a model frame definition in one animation state
+struct FModelAnimation
+{
+	const FSpriteModelFrame *smfNext;
+	double inter;
+};
+
+// Remembers the animation of recently seen states so that actors sharing
+// an animation state only need to look it up once. Only valid for one frame.
+class FModelAnimationCache
+{
+public:
+	FModelAnimation Get(FLevelLocals *Level, const FSpriteModelFrame *smf, const FState *curState, int curTics, const PClass *ti);
+
+	unsigned Hits = 0;
+	unsigned Misses = 0;
+
+private:
+	enum { NumEntries = 256 };
+
+	struct Entry
+	{
+		const FSpriteModelFrame *smf;
+		const FState *state;
+		const PClass *type;
+		int tics;
+		FModelAnimation anim;
+	};
+	Entry Entries[NumEntries] = {};
+};
+
+// Everything RenderModel computes on the CPU before submitting a model.
+// This only reads the actor, so it can be prepared on a worker thread.
+struct FModelDrawInfo
+{
+	VSMatrix objectToWorldMatrix;
+	FModelAnimation anim;
+	int translation;
+	bool mirrored;
+};
+
 class FModelRenderer
 {
 public:
 	virtual ~FModelRenderer() { }
 
+	static void PrepareModel(FModelDrawInfo &info, float x, float y, float z, FSpriteModelFrame *modelframe, AActor *actor, double ticFrac, FModelAnimationCache *cache = nullptr);
+	static FModelAnimation GetAnimation(FLevelLocals *Level, const FSpriteModelFrame *smf, const FState *curState, int curTics, const PClass *ti);
+
 	void RenderModel(float x, float y, float z, FSpriteModelFrame *modelframe, AActor *actor, double ticFrac);
+	void RenderModel(const FModelDrawInfo &info, FSpriteModelFrame *modelframe, AActor *actor);
 	void RenderHUDModel(DPSprite *psp, float ofsx, float ofsy);
 
 	virtual ModelRendererType GetType() const = 0;
@@ -82,7 +127,7 @@ public:
 	virtual void DrawElements(int numIndices, size_t offset) = 0;
 
 private:
-	void RenderFrameModels(FLevelLocals *Level, const FSpriteModelFrame *smf, const FState *curState, const int curTics, const PClass *ti, int translation);
+	void RenderFrameModels(const FSpriteModelFrame *smf, const FModelAnimation &anim, int translation);
 };
 
 struct FModelVertex
@@ -64,6 +64,7 @@ public:
 	DSectorPlaneInterpolation(sector_t *sector, bool plane, bool attach);
 	void UnlinkFromMap() override;
 	void UpdateInterpolation();
+	bool HasMoved();
 	void Restore();
 	void Interpolate(double smoothratio);
 	
@@ -92,6 +93,7 @@ public:
 	DSectorScrollInterpolation(sector_t *sector, bool plane);
 	void UnlinkFromMap() override;
 	void UpdateInterpolation();
+	bool HasMoved();
 	void Restore();
 	void Interpolate(double smoothratio);
 	
@@ -120,6 +122,7 @@ public:
 	DWallScrollInterpolation(side_t *side, int part);
 	void UnlinkFromMap() override;
 	void UpdateInterpolation();
+	bool HasMoved();
 	void Restore();
 	void Interpolate(double smoothratio);
 	
@@ -147,6 +150,7 @@ public:
 	DPolyobjInterpolation(FPolyObj *poly);
 	void UnlinkFromMap() override;
 	void UpdateInterpolation();
+	bool HasMoved();
 	void Restore();
 	void Interpolate(double smoothratio);
 	
@@ -196,10 +200,49 @@ int FInterpolator::CountInterpolations ()
 
 void FInterpolator::UpdateInterpolations()
 {
+	if (activeValid)
+	{
+		// Nothing has moved since the active list was collected, so the others are still current.
+		for (auto probe : Active)
+		{
+			if (probe != nullptr) probe->UpdateInterpolation ();
+		}
+	}
+	else
+	{
+		for (DInterpolation *probe = Head; probe != nullptr; probe = probe->Next)
+		{
+			probe->UpdateInterpolation ();
+		}
+	}
+	activeValid = false;
+}
+
+//==========================================================================
+//
+// Collects the interpolations that have something to do until the next
+// tic. Unreferenced ones are included so that they can remove themselves
+// once their source has stopped.
+//
+//==========================================================================
+
+void FInterpolator::CollectActive()
+{
+	for (auto probe : Active)
+	{
+		if (probe != nullptr) probe->active = false;
+	}
+	Active.Clear();
 	for (DInterpolation *probe = Head; probe != nullptr; probe = probe->Next)
 	{
-		probe->UpdateInterpolation ();
+		if (probe->refcount == 0 || probe->HasMoved())
+		{
+			probe->active = true;
+			Active.Push(probe);
+		}
 	}
+	activeCount = Active.Size();
+	activeValid = true;
 }
 
 //==========================================================================
@@ -214,6 +257,7 @@ void FInterpolator::AddInterpolation(DInterpolation *interp)
 	if (Head != nullptr) Head->Prev = interp;
 	interp->Prev = nullptr;
 	Head = interp;
+	activeValid = false;
 }
 
 //==========================================================================
@@ -236,6 +280,15 @@ void FInterpolator::RemoveInterpolation(DInterpolation *interp)
 	}
 	interp->Next = nullptr;
 	interp->Prev = nullptr;
+
+	if (interp->active)
+	{
+		// May be called from within DoInterpolations, so only clear the slot.
+		auto index = Active.Find(interp);
+		if (index < Active.Size()) Active[index] = nullptr;
+		interp->active = false;
+		activeCount--;
+	}
 }
 
 //==========================================================================
@@ -254,12 +307,13 @@ void FInterpolator::DoInterpolations(double smoothratio)
 
 	didInterp = true;
 
-	DInterpolation *probe = Head;
-	while (probe != nullptr)
+	if (!activeValid)
 	{
-		DInterpolation *next = probe->Next;
-		probe->Interpolate(smoothratio);
-		probe = next;
+		CollectActive();
+	}
+	for (unsigned i = 0; i < Active.Size(); i++)
+	{
+		if (Active[i] != nullptr) Active[i]->Interpolate(smoothratio);
 	}
 }
 
@@ -274,9 +328,9 @@ void FInterpolator::RestoreInterpolations()
 	if (didInterp)
 	{
 		didInterp = false;
-		for (DInterpolation *probe = Head; probe != nullptr; probe = probe->Next)
+		for (auto probe : Active)
 		{
-			probe->Restore();
+			if (probe != nullptr) probe->Restore();
 		}
 	}
 }
@@ -292,6 +346,14 @@ void FInterpolator::ClearInterpolations()
 	DInterpolation *probe = Head;
 	Head = nullptr;
 
+	for (auto interp : Active)
+	{
+		if (interp != nullptr) interp->active = false;
+	}
+	Active.Clear();
+	activeCount = 0;
+	activeValid = false;
+
 	while (probe != nullptr)
 	{
 		DInterpolation *next = probe->Next;
@@ -309,6 +371,7 @@ FSerializer &Serialize(FSerializer &arc, const char *key, FInterpolator &rs, FIn
 	{
 		arc("head", rs.Head)
 			.EndObject();
+		rs.activeValid = false;
 	}
 	return arc;
 }
@@ -455,6 +518,24 @@ void DSectorPlaneInterpolation::UpdateInterpolation()
 //
 //==========================================================================
 
+bool DSectorPlaneInterpolation::HasMoved()
+{
+	if (!ceiling)
+	{
+		return oldheight != sector->floorplane.fD() || oldtexz != sector->GetPlaneTexZ(sector_t::floor);
+	}
+	else
+	{
+		return oldheight != sector->ceilingplane.fD() || oldtexz != sector->GetPlaneTexZ(sector_t::ceiling);
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void DSectorPlaneInterpolation::Restore()
 {
 	if (!ceiling)
@@ -604,6 +685,17 @@ void DSectorScrollInterpolation::UpdateInterpolation()
 //
 //==========================================================================
 
+bool DSectorScrollInterpolation::HasMoved()
+{
+	return oldx != sector->GetXOffset(ceiling) || oldy != sector->GetYOffset(ceiling, false);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void DSectorScrollInterpolation::Restore()
 {
 	sector->SetXOffset(ceiling, bakx);
@@ -704,6 +796,17 @@ void DWallScrollInterpolation::UpdateInterpolation()
 //
 //==========================================================================
 
+bool DWallScrollInterpolation::HasMoved()
+{
+	return oldx != side->GetTextureXOffset(part) || oldy != side->GetTextureYOffset(part);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void DWallScrollInterpolation::Restore()
 {
 	side->SetTextureXOffset(part, bakx);
@@ -808,6 +911,21 @@ void DPolyobjInterpolation::UpdateInterpolation()
 //
 //==========================================================================
 
+bool DPolyobjInterpolation::HasMoved()
+{
+	for(unsigned int i = 0; i < poly->Vertices.Size(); i++)
+	{
+		if (oldverts[i*2] != poly->Vertices[i]->fX() || oldverts[i*2+1] != poly->Vertices[i]->fY()) return true;
+	}
+	return oldcx != poly->CenterSpot.pos.X || oldcy != poly->CenterSpot.pos.Y;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void DPolyobjInterpolation::Restore()
 {
 	for(unsigned int i = 0; i < poly->Vertices.Size(); i++)
@@ -23,6 +23,7 @@ class DInterpolation : public DObject
 protected:
 	FLevelLocals *Level;
 	int refcount = 0;
+	bool active = false;	// in the interpolator's active list
 
 	DInterpolation(FLevelLocals *l = nullptr) : Level(l) {}
 
@@ -32,6 +33,7 @@ public:
 
 	virtual void UnlinkFromMap();
 	virtual void UpdateInterpolation() = 0;
+	virtual bool HasMoved() = 0;	// true if the source differs from the last tic's position
 	virtual void Restore() = 0;
 	virtual void Interpolate(double smoothratio) = 0;
 	
@@ -50,7 +52,18 @@ struct FInterpolator
 	bool didInterp = false;
 	int count = 0;
 
+	// Interpolations whose source moved during the last tic. Everything else
+	// already sits at its old position, so there is nothing to interpolate
+	// and nothing to update at the start of the next tic.
+	TArray<DInterpolation *> Active;
+	bool activeValid = false;
+	int activeCount = 0;
+
+	void CollectActive();
+
+public:
 	int CountInterpolations ();
+	int CountActiveInterpolations () { return activeValid ? activeCount : -1; }
 
 public:
 	void UpdateInterpolations();
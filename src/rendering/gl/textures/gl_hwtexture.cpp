@@ -340,7 +340,7 @@ bool FHardwareTexture::BindOrCreate(FTexture *tex, int texunit, int clampmode, i
 
 		if (!tex->isHardwareCanvas())
 		{
-			texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
+			texbuffer = hw_CreateTexBuffer(tex, translation, flags | CTF_ProcessData);
 			w = texbuffer.mWidth;
 			h = texbuffer.mHeight;
 		}
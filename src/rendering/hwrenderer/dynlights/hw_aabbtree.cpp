@@ -20,6 +20,7 @@
 //--------------------------------------------------------------------------
 //
 
+#include <algorithm>
 #include "r_state.h"
 #include "g_levellocals.h"
 #include "hw_aabbtree.h"
@@ -46,7 +47,7 @@ LevelAABBTree::LevelAABBTree(FLevelLocals *lev)
 	int staticroot = nodes.Size() - 1;
 
 	dynamicStartNode = nodes.Size();
-	dynamicStartLine = treelines.Size();
+	dynamicStartLine = mapLines.Size(); // treelines is only filled in below
 
 	// Create the dynamic subtree
 	if (GenerateTree(&centroids[0], true))
@@ -76,6 +77,25 @@ LevelAABBTree::LevelAABBTree(FLevelLocals *lev)
 		treeline.dx = (float)line.v2->fX() - treeline.x;
 		treeline.dy = (float)line.v2->fY() - treeline.y;
 	}
+
+	// Link the nodes back to their parents for refitting
+	nodeParents.Resize(nodes.Size());
+	lineLeafs.Resize(mapLines.Size());
+	for (unsigned int i = 0; i < nodes.Size(); i++)
+		nodeParents[i] = -1;
+	for (unsigned int i = 0; i < nodes.Size(); i++)
+	{
+		const auto &node = nodes[i];
+		if (node.line_index != -1)
+		{
+			lineLeafs[node.line_index] = i;
+		}
+		else
+		{
+			nodeParents[node.left_node] = i;
+			nodeParents[node.right_node] = i;
+		}
+	}
 }
 
 bool LevelAABBTree::GenerateTree(const FVector2 *centroids, bool dynamicsubtree)
@@ -115,7 +135,11 @@ bool LevelAABBTree::GenerateTree(const FVector2 *centroids, bool dynamicsubtree)
 
 bool LevelAABBTree::Update()
 {
-	bool modified = false;
+	dirtyNodes.Clear();
+	dirtyNodeRanges.Clear();
+	dirtyLineRanges.Clear();
+	refitLines = 0;
+
 	for (unsigned int i = dynamicStartLine; i < mapLines.Size(); i++)
 	{
 		const auto &line = Level->lines[mapLines[i]];
@@ -128,64 +152,76 @@ bool LevelAABBTree::Update()
 
 		if (memcmp(&treelines[i], &treeline, sizeof(AABBTreeLine)))
 		{
-			TArray<int> path = FindNodePath(i, nodes.Size() - 1);
-			if (path.Size())
+			treelines[i] = treeline;
+			AddDirtyRange(dirtyLineRanges, i, 0);
+			refitLines++;
+
+			float x1 = (float)line.v1->fX();
+			float y1 = (float)line.v1->fY();
+			float x2 = (float)line.v2->fX();
+			float y2 = (float)line.v2->fY();
+
+			int nodeIndex = lineLeafs[i];
+			auto &leaf = nodes[nodeIndex];
+			leaf.aabb_left = MIN(x1, x2);
+			leaf.aabb_right = MAX(x1, x2);
+			leaf.aabb_top = MIN(y1, y2);
+			leaf.aabb_bottom = MAX(y1, y2);
+			dirtyNodes.Push(nodeIndex);
+
+			// The parents only depend on their children, so we can stop as soon as one of them stays the same
+			for (int parent = nodeParents[nodeIndex]; parent != -1 && RefitNode(parent); parent = nodeParents[parent])
 			{
-				float x1 = (float)line.v1->fX();
-				float y1 = (float)line.v1->fY();
-				float x2 = (float)line.v2->fX();
-				float y2 = (float)line.v2->fY();
-
-				int nodeIndex = path[0];
-				nodes[nodeIndex].aabb_left = MIN(x1, x2);
-				nodes[nodeIndex].aabb_right = MAX(x1, x2);
-				nodes[nodeIndex].aabb_top = MIN(y1, y2);
-				nodes[nodeIndex].aabb_bottom = MAX(y1, y2);
-
-				for (unsigned int j = 1; j < path.Size(); j++)
-				{
-					auto &cur = nodes[path[j]];
-					const auto &left = nodes[cur.left_node];
-					const auto &right = nodes[cur.right_node];
-					cur.aabb_left = MIN(left.aabb_left, right.aabb_left);
-					cur.aabb_top = MIN(left.aabb_top, right.aabb_top);
-					cur.aabb_right = MAX(left.aabb_right, right.aabb_right);
-					cur.aabb_bottom = MAX(left.aabb_bottom, right.aabb_bottom);
-				}
-
-				treelines[i] = treeline;
-				modified = true;
+				dirtyNodes.Push(parent);
 			}
 		}
 	}
-	return modified;
-}
 
-TArray<int> LevelAABBTree::FindNodePath(unsigned int line, unsigned int node)
-{
-	const AABBTreeNode &n = nodes[node];
+	if (refitLines == 0)
+		return false;
 
-	if (n.aabb_left > treelines[line].x || n.aabb_right < treelines[line].x ||
-		n.aabb_top > treelines[line].y || n.aabb_bottom < treelines[line].y)
+	// Parents shared by several moved lines show up more than once
+	std::sort(dirtyNodes.begin(), dirtyNodes.end());
+	for (unsigned int i = 0; i < dirtyNodes.Size(); i++)
 	{
-		return {};
+		if (i == 0 || dirtyNodes[i] != dirtyNodes[i - 1])
+			AddDirtyRange(dirtyNodeRanges, dirtyNodes[i], 4);
 	}
+	return true;
+}
 
-	TArray<int> path;
-	if (n.line_index == -1)
-	{
-		path = FindNodePath(line, n.left_node);
-		if (path.Size() == 0)
-			path = FindNodePath(line, n.right_node);
+bool LevelAABBTree::RefitNode(int node)
+{
+	auto &cur = nodes[node];
+	const auto &left = nodes[cur.left_node];
+	const auto &right = nodes[cur.right_node];
+	float aabb_left = MIN(left.aabb_left, right.aabb_left);
+	float aabb_top = MIN(left.aabb_top, right.aabb_top);
+	float aabb_right = MAX(left.aabb_right, right.aabb_right);
+	float aabb_bottom = MAX(left.aabb_bottom, right.aabb_bottom);
+	if (cur.aabb_left == aabb_left && cur.aabb_top == aabb_top && cur.aabb_right == aabb_right && cur.aabb_bottom == aabb_bottom)
+		return false;
 
-		if (path.Size())
-			path.Push(node);
-	}
-	else if (n.line_index == (int)line)
+	cur.aabb_left = aabb_left;
+	cur.aabb_top = aabb_top;
+	cur.aabb_right = aabb_right;
+	cur.aabb_bottom = aabb_bottom;
+	return true;
+}
+
+void LevelAABBTree::AddDirtyRange(TArray<AABBTreeRange> &ranges, int index, int mergeGap)
+{
+	// Uploading a few unchanged elements is cheaper than an extra upload call
+	if (ranges.Size() > 0)
 	{
-		path.Push(node);
+		auto &last = ranges.Last();
+		if (index <= last.start + last.count + mergeGap)
+		{
+			last.count = index + 1 - last.start;
+			return;
+		}
 	}
-	return path;
+	ranges.Push({ index, 1 });
 }
 
 double LevelAABBTree::RayTest(const DVector3 &ray_start, const DVector3 &ray_end)
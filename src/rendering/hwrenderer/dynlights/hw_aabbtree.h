@@ -37,6 +37,13 @@ struct AABBTreeLine
 	float dx, dy;
 };
 
+// Range of nodes or lines changed by an update
+struct AABBTreeRange
+{
+	int start;
+	int count;
+};
+
 // Axis aligned bounding box tree used for ray testing treelines.
 class LevelAABBTree
 {
@@ -47,8 +54,16 @@ public:
 	// Shoot a ray from ray_start to ray_end and return the closest hit as a fractional value between 0 and 1. Returns 1 if no line was hit.
 	double RayTest(const DVector3 &ray_start, const DVector3 &ray_end);
 
+	// Refits the dynamic subtree to the current polyobject positions. Returns true if anything changed.
 	bool Update();
 
+	// Nodes and lines changed by the last Update, merged into ranges sorted by index
+	const TArray<AABBTreeRange> &DirtyNodes() const { return dirtyNodeRanges; }
+	const TArray<AABBTreeRange> &DirtyLines() const { return dirtyLineRanges; }
+
+	// Number of lines moved by the last Update
+	int RefitLines() const { return refitLines; }
+
 	const void *Nodes() const { return nodes.Data(); }
 	const void *Lines() const { return treelines.Data(); }
 	size_t NodesSize() const { return nodes.Size() * sizeof(AABBTreeNode); }
@@ -61,6 +76,13 @@ public:
 	size_t DynamicNodesOffset() const { return dynamicStartNode * sizeof(AABBTreeNode); }
 	size_t DynamicLinesOffset() const { return dynamicStartLine * sizeof(AABBTreeLine); }
 
+	const void *Nodes(const AABBTreeRange &range) const { return nodes.Data() + range.start; }
+	const void *Lines(const AABBTreeRange &range) const { return treelines.Data() + range.start; }
+	size_t NodesOffset(const AABBTreeRange &range) const { return range.start * sizeof(AABBTreeNode); }
+	size_t LinesOffset(const AABBTreeRange &range) const { return range.start * sizeof(AABBTreeLine); }
+	size_t NodesSize(const AABBTreeRange &range) const { return range.count * sizeof(AABBTreeNode); }
+	size_t LinesSize(const AABBTreeRange &range) const { return range.count * sizeof(AABBTreeLine); }
+
 private:
 	bool GenerateTree(const FVector2 *centroids, bool dynamicsubtree);
 
@@ -73,7 +95,11 @@ private:
 	// Generate a tree node and its children recursively
 	int GenerateTreeNode(int *treelines, int num_lines, const FVector2 *centroids, int *work_buffer);
 
-	TArray<int> FindNodePath(unsigned int line, unsigned int node);
+	// Recalculates the AABB of a node from its children. Returns false if it did not change.
+	bool RefitNode(int node);
+
+	// Adds an index to a sorted list of ranges, merging it with its neighbours if they are close enough
+	static void AddDirtyRange(TArray<AABBTreeRange> &ranges, int index, int mergeGap);
 
 	// Nodes in the AABB tree. Last node is the root node.
 	TArray<AABBTreeNode> nodes;
@@ -84,6 +110,15 @@ private:
 	int dynamicStartNode = 0;
 	int dynamicStartLine = 0;
 
+	// Parent of each node (-1 for the root) and leaf node of each line, so that moved lines can be refit without searching
+	TArray<int> nodeParents;
+	TArray<int> lineLeafs;
+
+	TArray<int> dirtyNodes;
+	TArray<AABBTreeRange> dirtyNodeRanges;
+	TArray<AABBTreeRange> dirtyLineRanges;
+	int refitLines = 0;
+
 	TArray<int> mapLines;
 	FLevelLocals *Level;
 };
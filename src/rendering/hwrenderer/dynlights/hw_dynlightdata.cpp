@@ -26,8 +26,14 @@
 **/
 
 #include "actorinlines.h"
+#include "c_dispatch.h"
+#include "g_game.h"
+#include "g_levellocals.h"
+#include "stats.h"
 
 #include "hw_dynlightdata.h"
+#include <memory>
+#include <random>
 
 // If we want to share the array to avoid constant allocations it needs to be thread local unless it'd be littered with expensive synchronization.
 thread_local FDynLightData lightdata;
@@ -41,6 +47,7 @@ thread_local FDynLightData lightdata;
 // These shouldn't be called 'gl...' anymore...
 CVAR (Bool, gl_light_sprites, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR (Bool, gl_light_particles, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Bool, gl_lightrecords, true, 0);
 
 
 //==========================================================================
@@ -68,14 +75,14 @@ bool FDynLightData::GetLight(int group, Plane & p, FDynamicLight * light, bool c
 
 //==========================================================================
 //
-// Add one dynamic light to the light data list
+// Fills in the shader data of one light and returns the list it goes into
 //
 //==========================================================================
-void FDynLightData::AddLightToList(int group, FDynamicLight * light, bool forceAttenuate)
+
+static int MakeLightData(FDynamicLight *light, const DVector3 &pos, bool forceAttenuate, float *data)
 {
 	int i = 0;
 
-	DVector3 pos = light->PosRelative(group);
 	float radius = light->GetRadius();
 
 	float cs;
@@ -129,7 +136,6 @@ void FDynLightData::AddLightToList(int group, FDynamicLight * light, bool forceA
 		spotDirZ = float(-Angle.Sin() * xzLen);
 	}
 
-	float *data = &arrays[i][arrays[i].Reserve(16)];
 	data[0] = float(pos.X);
 	data[1] = float(pos.Z);
 	data[2] = float(pos.Y);
@@ -146,5 +152,213 @@ void FDynLightData::AddLightToList(int group, FDynamicLight * light, bool forceA
 	data[13] = spotOuterAngle;
 	data[14] = 0.0f; // unused
 	data[15] = 0.0f; // unused
+	return i;
+}
+
+//==========================================================================
+//
+// Light records
+//
+// A light's shader data doesn't depend on the surface it is applied to,
+// so it gets built once per scene for every active light. Light lists
+// for the individual surfaces are then assembled by copying these
+// instead of recomputing colors and spot directions for each surface.
+//
+//==========================================================================
+
+struct FLightRecord
+{
+	FDynamicLight *light;
+	int list;
+	float data[16];
+};
+
+static TArray<FLightRecord> LightRecords;
+
+static void AddLightRecord(FDynamicLight *light)
+{
+	if (!light->IsActive())
+	{
+		light->mRecordIndex = -1;
+		return;
+	}
+	light->mRecordIndex = LightRecords.Reserve(1);
+	auto &rec = LightRecords[light->mRecordIndex];
+	rec.light = light;
+	rec.list = MakeLightData(light, light->Pos, false, rec.data);
+}
+
+void hw_BuildLightRecords(FLevelLocals *Level)
+{
+	// Always clear, so that no record of an earlier scene can be picked up by a light that changed since.
+	LightRecords.Clear();
+	if (!gl_lightrecords || !Level->HasDynamicLights) return;
+
+	for (auto light = Level->lights; light; light = light->next)
+	{
+		AddLightRecord(light);
+	}
+}
+
+//==========================================================================
+//
+// Add one dynamic light to the light data list
+//
+//==========================================================================
+void FDynLightData::AddLightToList(int group, FDynamicLight * light, bool forceAttenuate)
+{
+	unsigned index = light->mRecordIndex;
+	if (index < LightRecords.Size() && LightRecords[index].light == light)
+	{
+		auto &rec = LightRecords[index];
+		float *data = &arrays[rec.list][arrays[rec.list].Reserve(16)];
+		memcpy(data, rec.data, sizeof(rec.data));
+		if (group != light->Sector->PortalGroup)
+		{
+			DVector3 pos = light->PosRelative(group);
+			data[0] = float(pos.X);
+			data[1] = float(pos.Z);
+			data[2] = float(pos.Y);
+		}
+		if (forceAttenuate && data[7] > 0) data[7] = -data[7];
+		return;
+	}
+
+	float buffer[16];
+	int i = MakeLightData(light, light->PosRelative(group), forceAttenuate, buffer);
+	memcpy(&arrays[i][arrays[i].Reserve(16)], buffer, sizeof(buffer));
 }
 
+//==========================================================================
+//
+// Times building light lists for a synthetic scene of the given number of
+// lights, once computing every entry and once copying them from the light
+// records. The lights are spread over the current level with a mix of
+// types, so that every branch of the light data setup gets exercised.
+//
+//==========================================================================
+
+CCMD(bench_lightlists)
+{
+	if (gamestate != GS_LEVEL || primaryLevel->vertexes.Size() == 0)
+	{
+		Printf("bench_lightlists requires a level\n");
+		return;
+	}
+
+	auto Level = primaryLevel;
+	int count = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 1000;
+	const int passes = 100;
+
+	DVector2 mins = Level->vertexes[0].fPos(), maxs = mins;
+	for (auto &v : Level->vertexes)
+	{
+		mins.X = MIN(mins.X, v.fX());
+		mins.Y = MIN(mins.Y, v.fY());
+		maxs.X = MAX(maxs.X, v.fX());
+		maxs.Y = MAX(maxs.Y, v.fY());
+	}
+
+	// Spot lights take their direction from an actor.
+	AActor *spottarget = playeringame[consoleplayer] ? Level->Players[consoleplayer]->mo : nullptr;
+	static const DAngle spotInner = 10., spotOuter = 25., spotPitch = 30.;
+
+	struct FBenchLightParams
+	{
+		int args[5];
+		LightFlags flags;
+	};
+	std::unique_ptr<FBenchLightParams[]> params(new FBenchLightParams[count]);
+	std::unique_ptr<FDynamicLight[]> lights(new FDynamicLight[count]());
+
+	std::mt19937 rng(1234);
+	auto frand = [&](double lo, double hi) { return std::uniform_real_distribution<double>(lo, hi)(rng); };
+	for (int i = 0; i < count; i++)
+	{
+		auto &param = params[i];
+		auto &light = lights[i];
+		param.args[LIGHT_RED] = (int)frand(0, 256);
+		param.args[LIGHT_GREEN] = (int)frand(0, 256);
+		param.args[LIGHT_BLUE] = (int)frand(0, 256);
+		param.args[LIGHT_INTENSITY] = (int)frand(32, 256);
+		param.args[LIGHT_SECONDARY_INTENSITY] = 0;
+		param.flags = 0;
+		switch (i % 8)
+		{
+		case 1: param.flags |= LF_ADDITIVE; break;
+		case 2: param.flags |= LF_SUBTRACTIVE; break;
+		case 3: case 4: param.flags |= LF_ATTENUATE; break;
+		case 5: if (spottarget != nullptr) param.flags |= LF_SPOT | LF_ATTENUATE; break;
+		default: break;
+		}
+
+		light.Level = Level;
+		light.Pos.X = frand(mins.X, maxs.X);
+		light.Pos.Y = frand(mins.Y, maxs.Y);
+		light.Sector = Level->PointInSector(light.Pos.XY());
+		light.Pos.Z = light.Sector->floorplane.ZatPoint(light.Pos) + frand(8, 128);
+		light.pArgs = param.args;
+		light.pLightFlags = &param.flags;
+		light.pSpotInnerAngle = &spotInner;
+		light.pSpotOuterAngle = &spotOuter;
+		light.pPitch = &spotPitch;
+		light.target = spottarget;
+		light.m_currentRadius = light.radius = (float)param.args[LIGHT_INTENSITY];
+		light.mShadowmapIndex = 1024;
+		light.mRecordIndex = -1;
+		light.m_active = true;
+	}
+
+	FDynLightData computed, recorded;
+	cycle_t computetime, recordtime, buildtime;
+	computetime.Reset();
+	recordtime.Reset();
+	buildtime.Reset();
+
+	LightRecords.Clear();
+	computetime.Clock();
+	for (int p = 0; p < passes; p++)
+	{
+		computed.Clear();
+		for (int i = 0; i < count; i++)
+		{
+			computed.AddLightToList(lights[i].Sector->PortalGroup, &lights[i], false);
+		}
+	}
+	computetime.Unclock();
+
+	buildtime.Clock();
+	for (int i = 0; i < count; i++)
+	{
+		AddLightRecord(&lights[i]);
+	}
+	buildtime.Unclock();
+
+	recordtime.Clock();
+	for (int p = 0; p < passes; p++)
+	{
+		recorded.Clear();
+		for (int i = 0; i < count; i++)
+		{
+			recorded.AddLightToList(lights[i].Sector->PortalGroup, &lights[i], false);
+		}
+	}
+	recordtime.Unclock();
+
+	// The records point to the synthetic lights, so they must not survive this.
+	LightRecords.Clear();
+
+	bool match = true;
+	for (int i = 0; i < 3; i++)
+	{
+		if (computed.arrays[i].Size() != recorded.arrays[i].Size() ||
+			memcmp(computed.arrays[i].Data(), recorded.arrays[i].Data(), computed.arrays[i].Size() * sizeof(float)))
+		{
+			match = false;
+		}
+	}
+
+	Printf("%d lights: computed %.3f ms, from records %.3f ms (records built in %.3f ms)%s\n",
+		count, computetime.TimeMS() / passes, recordtime.TimeMS() / passes, buildtime.TimeMS(),
+		match ? "" : ", results differ!");
+}
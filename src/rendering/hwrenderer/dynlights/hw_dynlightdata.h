@@ -60,5 +60,7 @@ struct FDynLightData
 
 extern thread_local FDynLightData lightdata;
 
+void hw_BuildLightRecords(FLevelLocals *Level);
+
 
 #endif
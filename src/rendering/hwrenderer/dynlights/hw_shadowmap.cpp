@@ -28,6 +28,7 @@
 #include "stats.h"
 #include "g_levellocals.h"
 #include "v_video.h"
+#include "ctpl.h"
 
 /*
 	The 1D shadow maps are stored in a 1024x1024 texture as float depth values (R32F).
@@ -60,11 +61,21 @@
 cycle_t IShadowMap::UpdateCycles;
 int IShadowMap::LightsProcessed;
 int IShadowMap::LightsShadowmapped;
+int IShadowMap::TreeRebuilds;
+int IShadowMap::TreeRefits;
+int IShadowMap::LinesRefit;
+int IShadowMap::BytesUploaded;
+
+EXTERN_CVAR(Bool, gl_multithread)
+extern ctpl::thread_pool renderPool;
 
 ADD_STAT(shadowmap)
 {
 	FString out;
-	out.Format("upload=%04.2f ms  lights=%d  shadowmapped=%d", IShadowMap::UpdateCycles.TimeMS(), IShadowMap::LightsProcessed, IShadowMap::LightsShadowmapped);
+	out.Format("upload=%04.2f ms  lights=%d  shadowmapped=%d\n"
+		"AABB tree: %d rebuilds, %d refits, %d lines refit, %d bytes uploaded this frame",
+		IShadowMap::UpdateCycles.TimeMS(), IShadowMap::LightsProcessed, IShadowMap::LightsShadowmapped,
+		IShadowMap::TreeRebuilds, IShadowMap::TreeRefits, IShadowMap::LinesRefit, IShadowMap::BytesUploaded);
 	return out;
 }
 
@@ -109,26 +120,55 @@ bool IShadowMap::IsEnabled() const
 	return gl_light_shadowmap && (screen->hwcaps & RFL_SHADER_STORAGE_BUFFER);
 }
 
+//==========================================================================
+//
+// Builds the list of shadowmapped lights and remembers which part of it
+// differs from the last frame so that only that part gets uploaded.
+// Only touches the lights, so it can run next to the AABB tree update.
+//
+//==========================================================================
+
 void IShadowMap::CollectLights()
 {
-	if (mLights.Size() != 1024 * 4) mLights.Resize(1024 * 4);
+	int dirtyStart = 1024 * 4;
+	int dirtyEnd = 0;
+	if (mLights.Size() != 1024 * 4)
+	{
+		mLights.Resize(1024 * 4);
+		for (auto &value : mLights) value = 0;
+		dirtyStart = 0;
+		dirtyEnd = 1024 * 4;
+	}
+
+	auto setLight = [&](int index, float x, float y, float z, float radius)
+	{
+		float *data = &mLights[index];
+		if (data[0] != x || data[1] != y || data[2] != z || data[3] != radius)
+		{
+			data[0] = x;
+			data[1] = y;
+			data[2] = z;
+			data[3] = radius;
+			dirtyStart = MIN(dirtyStart, index);
+			dirtyEnd = MAX(dirtyEnd, index + 4);
+		}
+	};
+
 	int lightindex = 0;
+	int lightcount = 0;
 	auto Level = &level;
 
 	// Todo: this should go through the blockmap in a spiral pattern around the player so that closer lights are preferred.
 	for (auto light = Level->lights; light; light = light->next)
 	{
-		LightsProcessed++;
+		lightcount++;
 		if (light->shadowmapped && light->IsActive() && lightindex < 1024 * 4)
 		{
 			LightsShadowmapped++;
 
 			light->mShadowmapIndex = lightindex >> 2;
 
-			mLights[lightindex] = (float)light->X();
-			mLights[lightindex+1] = (float)light->Y();
-			mLights[lightindex+2] = (float)light->Z();
-			mLights[lightindex+3] = light->GetRadius();
+			setLight(lightindex, (float)light->X(), (float)light->Y(), (float)light->Z(), light->GetRadius());
 			lightindex += 4;
 		}
         else
@@ -138,10 +178,15 @@ void IShadowMap::CollectLights()
 
 	}
 
-	for (; lightindex < 1024 * 4; lightindex++)
+	for (; lightindex < 1024 * 4; lightindex += 4)
 	{
-		mLights[lightindex] = 0;
+		setLight(lightindex, 0, 0, 0, 0);
 	}
+
+	LightsProcessed += lightcount;
+	mLastLightCount = lightcount;
+	mLightsDirtyStart = dirtyStart;
+	mLightsDirtyEnd = dirtyEnd;
 }
 
 bool IShadowMap::ValidateAABBTree(FLevelLocals *Level)
@@ -161,6 +206,7 @@ bool IShadowMap::ValidateAABBTree(FLevelLocals *Level)
 		return true;
 
 	mAABBTree.reset(new hwrenderer::LevelAABBTree(Level));
+	TreeRebuilds++;
 	return false;
 }
 
@@ -170,12 +216,27 @@ bool IShadowMap::PerformUpdate()
 
 	LightsProcessed = 0;
 	LightsShadowmapped = 0;
+	LinesRefit = 0;
+	BytesUploaded = 0;
 
 	if (IsEnabled())
 	{
 		UpdateCycles.Clock();
-		UploadAABBTree();
+
+		// Collecting the lights only needs the CPU, so with many lights it can overlap the tree refit and upload.
+		if (gl_multithread && renderPool.size() > 0 && mLastLightCount >= 256)
+		{
+			auto future = renderPool.push([=](int id) { CollectLights(); });
+			UploadAABBTree();
+			future.wait();
+		}
+		else
+		{
+			UploadAABBTree();
+			CollectLights();
+		}
 		UploadLights();
+
 		mLightList->BindBase();
 		mNodesBuffer->BindBase();
 		mLinesBuffer->BindBase();
@@ -186,12 +247,18 @@ bool IShadowMap::PerformUpdate()
 
 void IShadowMap::UploadLights()
 {
-	CollectLights();
-
 	if (mLightList == nullptr)
+	{
 		mLightList = screen->CreateDataBuffer(LIGHTLIST_BINDINGPOINT, true, false);
-
-	mLightList->SetData(sizeof(float) * mLights.Size(), &mLights[0]);
+		mLightList->SetData(sizeof(float) * mLights.Size(), &mLights[0]);
+		BytesUploaded += sizeof(float) * mLights.Size();
+	}
+	else if (mLightsDirtyStart < mLightsDirtyEnd)
+	{
+		size_t size = sizeof(float) * (mLightsDirtyEnd - mLightsDirtyStart);
+		mLightList->SetSubData(sizeof(float) * mLightsDirtyStart, size, &mLights[mLightsDirtyStart]);
+		BytesUploaded += size;
+	}
 }
 
 
@@ -206,11 +273,24 @@ void IShadowMap::UploadAABBTree()
 		if (!mLinesBuffer)
 			mLinesBuffer = screen->CreateDataBuffer(LIGHTLINES_BINDINGPOINT, true, false);
 		mLinesBuffer->SetData(mAABBTree->LinesSize(), mAABBTree->Lines());
+
+		BytesUploaded += mAABBTree->NodesSize() + mAABBTree->LinesSize();
 	}
 	else if (mAABBTree->Update())
 	{
-		mNodesBuffer->SetSubData(mAABBTree->DynamicNodesOffset(), mAABBTree->DynamicNodesSize(), mAABBTree->DynamicNodes());
-		mLinesBuffer->SetSubData(mAABBTree->DynamicLinesOffset(), mAABBTree->DynamicLinesSize(), mAABBTree->DynamicLines());
+		// Only send what the refit touched instead of the whole dynamic subtree
+		for (auto &range : mAABBTree->DirtyNodes())
+		{
+			mNodesBuffer->SetSubData(mAABBTree->NodesOffset(range), mAABBTree->NodesSize(range), mAABBTree->Nodes(range));
+			BytesUploaded += mAABBTree->NodesSize(range);
+		}
+		for (auto &range : mAABBTree->DirtyLines())
+		{
+			mLinesBuffer->SetSubData(mAABBTree->LinesOffset(range), mAABBTree->LinesSize(range), mAABBTree->Lines(range));
+			BytesUploaded += mAABBTree->LinesSize(range);
+		}
+		TreeRefits++;
+		LinesRefit += mAABBTree->RefitLines();
 	}
 }
 
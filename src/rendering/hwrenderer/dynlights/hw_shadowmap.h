@@ -27,6 +27,10 @@ public:
 	static cycle_t UpdateCycles;
 	static int LightsProcessed;
 	static int LightsShadowmapped;
+	static int TreeRebuilds;
+	static int TreeRefits;
+	static int LinesRefit;
+	static int BytesUploaded;
 
 	bool PerformUpdate();
 	void FinishUpdate()
@@ -47,6 +51,13 @@ protected:
 	// Working buffer for creating the list of lights. Stored here to avoid allocating memory each frame
 	TArray<float> mLights;
 
+	// Range of mLights that changed since the last upload
+	int mLightsDirtyStart = 0;
+	int mLightsDirtyEnd = 0;
+
+	// Number of lights seen by the last CollectLights, used to decide if it is worth collecting on a worker thread
+	int mLastLightCount = 0;
+
 	// Used to detect when a level change requires the AABB tree to be regenerated
 	level_info_t *mLastLevel = nullptr;
 	unsigned mLastNumNodes = 0;
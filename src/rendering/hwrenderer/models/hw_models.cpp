@@ -35,6 +35,9 @@
 #include "g_levellocals.h"
 #include "i_time.h"
 #include "cmdlib.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "ctpl.h"
 #include "hwrenderer/textures/hw_material.h"
 #include "hwrenderer/data/buffers.h"
 #include "hwrenderer/data/flatvertices.h"
@@ -44,6 +47,10 @@
 #include "hw_models.h"
 
 CVAR(Bool, gl_light_models, true, CVAR_ARCHIVE)
+CVAR(Bool, gl_prepare_models, true, 0)
+EXTERN_CVAR(Bool, gl_multithread)
+
+extern ctpl::thread_pool renderPool;
 
 VSMatrix FHWModelRenderer::GetViewToWorldMatrix()
 {
@@ -220,3 +227,199 @@ void FModelVertexBuffer::SetupFrame(FModelRenderer *renderer, unsigned int frame
 	state.SetVertexBuffer(mVertexBuffer, frame1, frame2);
 	if (mIndexBuffer) state.SetIndexBuffer(mIndexBuffer);
 }
+
+//===========================================================================
+//
+// Computes the transform and animation of all models in a scene before
+// anything gets drawn. The work is sorted by model and animation state and
+// split into jobs along model boundaries so that each job's animation cache
+// can serve all actors in the same state.
+//
+//===========================================================================
+
+struct FModelPrepareItem
+{
+	FSpriteModelFrame *smf;
+	AActor *actor;
+	float x, y, z;
+	FModelDrawInfo *info;
+};
+
+static TArray<FModelPrepareItem> ModelItems;
+static cycle_t ModelPrepareTime;
+static unsigned ModelsPrepared, ModelJobs, ModelAnimsReused;
+
+static unsigned PrepareModelRange(unsigned start, unsigned end, double ticFrac)
+{
+	FModelAnimationCache cache;
+	for (unsigned i = start; i < end; i++)
+	{
+		auto &item = ModelItems[i];
+		FModelRenderer::PrepareModel(*item.info, item.x, item.y, item.z, item.smf, item.actor, ticFrac, &cache);
+	}
+	return cache.Hits;
+}
+
+// Prepares everything in ModelItems and returns the number of jobs used.
+static unsigned PrepareModelItems(double ticFrac, bool multithread, unsigned &reused)
+{
+	std::sort(ModelItems.begin(), ModelItems.end(), [](const FModelPrepareItem &a, const FModelPrepareItem &b)
+	{
+		if (a.smf->modelIDs[0] != b.smf->modelIDs[0]) return a.smf->modelIDs[0] < b.smf->modelIDs[0];
+		return std::less<FState *>()(a.actor->state, b.actor->state);
+	});
+
+	unsigned count = ModelItems.Size();
+	unsigned numWorkers = multithread ? MIN((unsigned)renderPool.size() + 1, 16u) : 1;
+	if (count < 64 || numWorkers < 2)
+	{
+		reused += PrepareModelRange(0, count, ticFrac);
+		return 1;
+	}
+
+	std::future<unsigned> futures[16];
+	unsigned numFutures = 0;
+	unsigned share = (count + numWorkers - 1) / numWorkers;
+	unsigned start = 0;
+	while (start < count)
+	{
+		if (numFutures == numWorkers - 1)
+		{
+			reused += PrepareModelRange(start, count, ticFrac);
+			break;
+		}
+
+		// Move the end of the job to the next model if that is close by. Big groups still get split.
+		unsigned end = MIN(start + share, count);
+		unsigned limit = MIN(end + share / 2, count);
+		unsigned next = end;
+		while (next < limit && ModelItems[next].smf->modelIDs[0] == ModelItems[next - 1].smf->modelIDs[0]) next++;
+		if (next < limit || limit == count) end = next;
+
+		if (end == count)
+		{
+			reused += PrepareModelRange(start, count, ticFrac);
+			break;
+		}
+		futures[numFutures++] = renderPool.push([=](int id) { return PrepareModelRange(start, end, ticFrac); });
+		start = end;
+	}
+	for (unsigned i = 0; i < numFutures; i++) reused += futures[i].get();
+	return numFutures + 1;
+}
+
+void HWDrawInfo::PrepareModels()
+{
+	if (outer == nullptr)
+	{
+		ModelPrepareTime.Reset();
+		ModelsPrepared = ModelJobs = ModelAnimsReused = 0;
+	}
+	if (!gl_prepare_models) return;
+
+	ModelPrepareTime.Clock();
+	ModelItems.Clear();
+	for (auto &list : drawlists)
+	{
+		for (auto sprite : list.sprites)
+		{
+			if (sprite->modelframe != nullptr && sprite->actor != nullptr)
+			{
+				ModelItems.Push({ sprite->modelframe, sprite->actor, sprite->x, sprite->y, sprite->z, nullptr });
+			}
+		}
+	}
+	if (ModelItems.Size() > 0)
+	{
+		// The draw infos only need to live as long as the scene.
+		auto infos = (FModelDrawInfo *)RenderDataAllocator.Alloc(ModelItems.Size() * sizeof(FModelDrawInfo));
+		unsigned i = 0;
+		for (auto &list : drawlists)
+		{
+			for (auto sprite : list.sprites)
+			{
+				if (sprite->modelframe != nullptr && sprite->actor != nullptr)
+				{
+					sprite->modeldraw = ModelItems[i].info = &infos[i];
+					i++;
+				}
+			}
+		}
+		ModelJobs += PrepareModelItems(Viewpoint.TicFrac, gl_multithread, ModelAnimsReused);
+		ModelsPrepared += ModelItems.Size();
+	}
+	ModelPrepareTime.Unclock();
+}
+
+ADD_STAT(models)
+{
+	FString out;
+	out.Format("Models prepared: %u in %u jobs, %u animations reused, %.3f ms", ModelsPrepared, ModelJobs, ModelAnimsReused, ModelPrepareTime.TimeMS());
+	return out;
+}
+
+//===========================================================================
+//
+// bench_models [count] [passes]
+//
+// Prepares the models in the current level, repeated until there are
+// <count> of them, once one by one and once batched, and times both.
+//
+//===========================================================================
+
+CCMD(bench_models)
+{
+	if (primaryLevel == nullptr || gamestate != GS_LEVEL)
+	{
+		Printf("bench_models can only be used in a level\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 500;
+	int passes = argv.argc() > 2 ? MAX(atoi(argv[2]), 1) : 100;
+
+	TArray<FModelPrepareItem> actors;
+	auto it = primaryLevel->GetThinkerIterator<AActor>();
+	AActor *mo;
+	while ((mo = it.Next()) != nullptr)
+	{
+		if (mo->sprite < 0 || (mo->renderflags & RF_INVISIBLE)) continue;
+		auto smf = FindModelFrame(mo->GetClass(), mo->sprite, mo->frame, !!(mo->flags & MF_DROPPED));
+		if (smf != nullptr) actors.Push({ smf, mo, (float)mo->X(), (float)mo->Y(), (float)mo->Z(), nullptr });
+	}
+	if (actors.Size() == 0)
+	{
+		Printf("No actors with models in this level\n");
+		return;
+	}
+
+	TArray<FModelDrawInfo> infos(count, true);
+	ModelItems.Resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		ModelItems[i] = actors[i % actors.Size()];
+		ModelItems[i].info = &infos[i];
+	}
+	double ticFrac = I_GetTimeFrac();
+
+	cycle_t serial, batched;
+	serial.Reset();
+	batched.Reset();
+	serial.Clock();
+	for (int p = 0; p < passes; p++)
+	{
+		for (auto &item : ModelItems)
+			FModelRenderer::PrepareModel(*item.info, item.x, item.y, item.z, item.smf, item.actor, ticFrac);
+	}
+	serial.Unclock();
+
+	unsigned jobs = 0, reused = 0;
+	batched.Clock();
+	for (int p = 0; p < passes; p++)
+		jobs = PrepareModelItems(ticFrac, gl_multithread, reused);
+	batched.Unclock();
+
+	Printf("%d models (%u distinct actors), %d passes\n", count, actors.Size(), passes);
+	Printf("one by one: %.3f ms per pass\n", serial.TimeMS() / passes);
+	Printf("batched:    %.3f ms per pass, %u jobs, %u of %d animations reused\n", batched.TimeMS() / passes, jobs, reused / passes, count);
+	ModelItems.Clear();
+}
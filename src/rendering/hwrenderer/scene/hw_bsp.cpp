@@ -33,13 +33,20 @@
 #include "po_man.h"
 #include "m_fixed.h"
 #include "ctpl.h"
+#include "c_dispatch.h"
+#include "d_player.h"
+#include "g_game.h"
+#include "r_utility.h"
+#include "v_video.h"
 #include "hwrenderer/scene/hw_fakeflat.h"
 #include "hwrenderer/scene/hw_clipper.h"
 #include "hwrenderer/scene/hw_drawstructs.h"
 #include "hwrenderer/scene/hw_drawinfo.h"
+#include "hwrenderer/scene/hw_geometrycache.h"
 #include "hwrenderer/scene/hw_portal.h"
 #include "hwrenderer/utility/hw_clock.h"
 #include "hwrenderer/data/flatvertices.h"
+#include "hwrenderer/dynlights/hw_lightbuffer.h"
 
 #ifdef ARCH_IA32
 #include <immintrin.h>
@@ -47,6 +54,18 @@
 
 CVAR(Bool, gl_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
+enum
+{
+	MAX_BSP_WORKERS = 8
+};
+
+// Number of threads processing the BSP jobs. 0 picks one per available core.
+CUSTOM_CVAR(Int, gl_bsp_workers, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > MAX_BSP_WORKERS) self = MAX_BSP_WORKERS;
+}
+
 thread_local bool isWorkerThread;
 ctpl::thread_pool renderPool(1);
 bool inited = false;
@@ -66,13 +85,19 @@ struct RenderJob
 	int type;
 	subsector_t *sub;
 	seg_t *seg;
+
+	// Sprites and portal jobs move actors around temporarily and use the validcount of things, so they all have to run on the first worker.
+	// This includes walls on line portals because those process the actors seen through the portal.
+	bool IsSerial() const
+	{
+		return type == SpriteJob || type == ParticleJob || type == PortalJob || (type == WallJob && seg->linedef->isVisualPortal());
+	}
 };
 
 
 class RenderJobQueue
 {
 	RenderJob pool[300000];	// Way more than ever needed. The largest ever seen on a single viewpoint is around 40000.
-	std::atomic<int> readindex{};
 	std::atomic<int> writeindex{};
 public:
 	void AddJob(int type, subsector_t *sub, seg_t *seg = nullptr)
@@ -83,7 +108,8 @@ public:
 		writeindex++;	// update index only after the value has been written.
 	}
 
-	RenderJob *GetJob()
+	// Every worker reads the entire queue with its own read index and picks the jobs assigned to it.
+	RenderJob *GetJob(int &readindex)
 	{
 		if (readindex < writeindex) return &pool[readindex++];
 		return nullptr;
@@ -91,22 +117,46 @@ public:
 	
 	void ReleaseAll()
 	{
-		readindex = 0;
 		writeindex = 0;
 	}
 };
 
 static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
 
-void HWDrawInfo::WorkerThread()
+// Draw lists for each worker when there's more than one. They get merged in worker order once all workers are done,
+// so the result only depends on the job order.
+static HWDrawList workerDrawLists[MAX_BSP_WORKERS][GLDL_TYPES];
+
+static int GetBSPWorkerCount()
+{
+	int count = gl_bsp_workers;
+	if (count == 0)
+	{
+		// Leave one core for the main thread doing the BSP traversal.
+		count = clamp((int)std::thread::hardware_concurrency() - 1, 1, (int)MAX_BSP_WORKERS);
+	}
+	return count;
+}
+
+void HWDrawInfo::WorkerThread(int index, int numWorkers)
 {
 	sector_t *front, *back;
+	int readindex = 0;
 
-	WTTotal.Clock();
+	// The timers are not thread safe so only the first worker records them.
+	bool timing = index == 0;
+
+	if (timing) WTTotal.Clock();
 	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
+	if (numWorkers > 1)
+	{
+		WorkerDrawLists = workerDrawLists[index];
+		WorkerRenderDataAllocator = GetWorkerRenderDataAllocator(index);
+	}
 	while (true)
 	{
-		auto job = jobQueue.GetJob();
+		int jobindex = readindex;
+		auto job = jobQueue.GetJob(readindex);
 		if (job == nullptr)
 		{
 #ifdef ARCH_IA32
@@ -124,18 +174,24 @@ void HWDrawInfo::WorkerThread()
 			_mm_pause();
 #endif // ARCH_IA32
 		}
+		else if (job->type != RenderJob::TerminateJob && (job->IsSerial() ? index != 0 : jobindex % numWorkers != index))
+		{
+			// Job belongs to another worker.
+		}
 		// Note that the main thread MUST have prepared the fake sectors that get used below!
 		// This worker thread cannot prepare them itself without costly synchronization.
 		else switch (job->type)
 		{
 		case RenderJob::TerminateJob:
-			WTTotal.Unclock();
+			WorkerDrawLists = nullptr;
+			WorkerRenderDataAllocator = nullptr;
+			if (timing) WTTotal.Unclock();
 			return;
 
 		case RenderJob::WallJob:
 		{
 			HWWall wall;
-			SetupWall.Clock();
+			if (timing) SetupWall.Clock();
 			wall.sub = job->sub;
 
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
@@ -155,18 +211,18 @@ void HWDrawInfo::WorkerThread()
 
 			wall.Process(this, job->seg, front, back);
 			rendered_lines++;
-			SetupWall.Unclock();
+			if (timing) SetupWall.Unclock();
 			break;
 		}
 
 		case RenderJob::FlatJob:
 		{
 			HWFlat flat;
-			SetupFlat.Clock();
+			if (timing) SetupFlat.Clock();
 			flat.section = job->sub->section;
 			front = hw_FakeFlat(job->sub->render_sector, in_area, false);
 			flat.ProcessSector(this, front);
-			SetupFlat.Unclock();
+			if (timing) SetupFlat.Unclock();
 			break;
 		}
 
@@ -322,6 +378,7 @@ void HWDrawInfo::AddLine (seg_t *seg, bool portalclip)
 	if (ispoly || seg->linedef->validcount!=validcount) 
 	{
 		if (!ispoly) seg->linedef->validcount=validcount;
+		if (seg->backsector) hw_CheckGeometrySector(seg->backsector);
 
 		if (gl_render_walls)
 		{
@@ -559,7 +616,7 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 {
 	SetupSprite.Clock();
-	for (int i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
+	for (uint32_t i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
 	{
 		if (mClipPortal)
 		{
@@ -628,6 +685,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 	if (sector->validcount != validcount)
 	{
 		screen->mVertexData->CheckUpdate(sector);
+		hw_CheckGeometrySector(sector);
 	}
 
 	// [RH] Add particles
@@ -689,6 +747,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 					// the planes of this subsector are faked to belong to another sector
 					// This means we need the heightsec parts and light info of the render sector, not the actual one.
 					fakesector = hw_FakeFlat(sector, in_area, false);
+					hw_CheckGeometrySector(sector);
 				}
 
 				uint8_t &srf = section_renderflags[Level->sections.SectionIndex(sub->section)];
@@ -805,20 +864,42 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	viewy = FLOAT2FIXED(Viewpoint.Pos.Y);
 
 	validcount++;	// used for processing sidedefs only once by the renderer.
+	hw_BeginGeometryCache(this);
 
 	multithread = gl_multithread;
 	if (multithread)
 	{
+		int numWorkers = GetBSPWorkerCount();
+		if (renderPool.size() != numWorkers) renderPool.resize(numWorkers);
+		if (numWorkers > 1) GetWorkerRenderDataAllocator(numWorkers - 1);
+
 		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
-			WorkerThread();
-		});
+		std::future<void> futures[MAX_BSP_WORKERS];
+		for (int i = 0; i < numWorkers; i++)
+		{
+			futures[i] = renderPool.push([=](int id) {
+				WorkerThread(i, numWorkers);
+			});
+		}
 		RenderBSPNode(node);
 
 		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		for (int i = 0; i < numWorkers; i++)
+		{
+			futures[i].wait();
+		}
+		if (numWorkers > 1)
+		{
+			for (int i = 0; i < numWorkers; i++)
+			{
+				for (int j = 0; j < GLDL_TYPES; j++)
+				{
+					drawlists[j].Append(workerDrawLists[i][j]);
+				}
+			}
+		}
 		MTWait.Unclock();
 	}
 	else
@@ -832,3 +913,52 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	if (drawpsprites)
 		PreparePlayerSprites(Viewpoint.sector, in_area);
 }
+
+//==========================================================================
+//
+// Runs the BSP traversal and the wall/flat/sprite processing for the
+// current view without drawing anything, to measure the CPU side of the
+// scene setup. Compare different gl_bsp_workers settings with it.
+//
+//==========================================================================
+
+CCMD(bench_bsp)
+{
+	if (gamestate != GS_LEVEL || players[consoleplayer].camera == nullptr || !V_IsHardwareRenderer())
+	{
+		Printf("bench_bsp requires a level and the hardware renderer\n");
+		return;
+	}
+
+	int count = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 100;
+
+	FRenderViewpoint vp;
+	R_SetupFrame(vp, r_viewwindow, players[consoleplayer].camera);
+
+	cycle_t timer;
+	timer.Reset();
+	unsigned items = 0;
+	for (int i = 0; i < count; i++)
+	{
+		// Nothing gets drawn so the buffers can be reused by every pass.
+		screen->mVertexData->Reset();
+		screen->mLights->Clear();
+
+		timer.Clock();
+		auto di = HWDrawInfo::StartDrawInfo(vp.ViewLevel, nullptr, vp, nullptr);
+		di->SetViewArea();
+		di->Viewpoint.SetViewAngle(r_viewwindow);
+		di->CreateScene(false);
+		timer.Unclock();
+
+		for (int j = 0; j < GLDL_TYPES; j++) items += di->drawlists[j].Size();
+
+		HWPortal *p;
+		while (di->Portals.Pop(p)) delete p;
+		di->EndDrawInfo();
+	}
+	screen->mVertexData->Reset();
+	screen->mLights->Clear();
+
+	Printf("%d passes with %d workers: %.3f ms per pass, %u draw items\n", count, gl_multithread ? GetBSPWorkerCount() : 0, timer.TimeMS() / count, items / count);
+}
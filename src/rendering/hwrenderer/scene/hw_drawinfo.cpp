@@ -41,6 +41,7 @@
 #include "hwrenderer/data/hw_viewpointbuffer.h"
 #include "hwrenderer/data/flatvertices.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
+#include "hwrenderer/textures/hw_material.h"
 #include "hwrenderer/utility/hw_vrmodes.h"
 #include "hw_clipper.h"
 
@@ -106,6 +107,12 @@ HWDrawInfo *HWDrawInfo::StartDrawInfo(FLevelLocals *lev, HWDrawInfo *parent, FRe
 {
 	HWDrawInfo *di = di_list.GetNew();
 	if (parent) di->DrawScene = parent->DrawScene;
+	else
+	{
+		hw_BuildLightRecords(lev);
+		hw_UploadStreamedTextures();
+		hw_SetTextureStreamWindow(true);
+	}
 	di->Level = lev;
 	di->StartScene(parentvp, uniforms);
 	return di;
@@ -166,7 +173,10 @@ HWDrawInfo *HWDrawInfo::EndDrawInfo()
 	gl_drawinfo = outer;
 	di_list.Release(this);
 	if (gl_drawinfo == nullptr)
+	{
 		ResetRenderDataAllocator();
+		hw_SetTextureStreamWindow(false);
+	}
 	return gl_drawinfo;
 }
 
@@ -408,7 +418,8 @@ void HWViewpointUniforms::SetDefaults()
 
 HWDecal *HWDrawInfo::AddDecal(bool onmirror)
 {
-	auto decal = (HWDecal*)RenderDataAllocator.Alloc(sizeof(HWDecal));
+	auto decal = (HWDecal*)AllocRenderData(sizeof(HWDecal));
+	std::lock_guard<std::mutex> lock(listMutex);
 	Decals[onmirror ? 1 : 0].Push(decal);
 	return decal;
 }
@@ -446,6 +457,7 @@ void HWDrawInfo::CreateScene(bool drawpsprites)
 	HandleHackedSubsectors();	// open sector hacks for deep water
 	PrepareUnhandledMissingTextures();
 	DispatchRenderHacks();
+	PrepareModels();
 	screen->mLights->Unmap();
 	screen->mVertexData->Unmap();
 
@@ -667,6 +679,7 @@ void HWDrawInfo::ProcessScene(bool toscreen, const std::function<void(HWDrawInfo
 
 void HWDrawInfo::AddSubsectorToPortal(FSectorPortalGroup *ptg, subsector_t *sub)
 {
+	std::lock_guard<std::mutex> lock(listMutex);
 	auto portal = FindPortal(ptg);
 	if (!portal)
 	{
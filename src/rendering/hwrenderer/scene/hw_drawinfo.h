@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>
 #include <functional>
 #include "vectors.h"
 #include "r_defs.h"
@@ -95,6 +96,9 @@ enum DrawListType
 };
 
 
+// Set on BSP workers that collect their output in their own draw lists
+extern thread_local HWDrawList *WorkerDrawLists;
+
 struct HWDrawInfo
 {
 	struct wallseg
@@ -178,6 +182,7 @@ struct HWDrawInfo
 	area_t	in_area;
 	fixed_t viewx, viewy;	// since the nodes are still fixed point, keeping the view position  also fixed point for node traversal is faster.
 	bool multithread;
+	std::mutex listMutex;	// Protects the portal, decal and missing texture lists when several BSP workers are running.
 
 	std::function<void(HWDrawInfo *, int)> DrawScene = nullptr;
 
@@ -190,7 +195,7 @@ private:
 	subsector_t *currentsubsector;	// used by the line processing code.
 	sector_t *currentsector;
 
-	void WorkerThread();
+	void WorkerThread(int index, int numWorkers);
 
 	void UnclipSubsector(subsector_t *sub);
 	
@@ -247,6 +252,7 @@ public:
 	int SetFullbrightFlags(player_t *player);
 
 	void CreateScene(bool drawpsprites);
+	void PrepareModels();
 	void RenderScene(FRenderState &state);
 	void RenderTranslucent(FRenderState &state);
 	void RenderPortal(HWPortal *p, FRenderState &state, bool usestencil);
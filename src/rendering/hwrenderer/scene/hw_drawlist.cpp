@@ -37,12 +37,42 @@
 #include "hw_renderstate.h"
 #include "hw_drawinfo.h"
 #include "hw_fakeflat.h"
+#include "ctpl.h"
+
+CVAR(Bool, gl_fastsort, true, 0)
+
+extern ctpl::thread_pool renderPool;
 
 FMemArena RenderDataAllocator(1024*1024);	// Use large blocks to reduce allocation time.
+thread_local FMemArena *WorkerRenderDataAllocator;	// Set on BSP workers that fill their own draw lists.
+static TDeletingArray<FMemArena *> WorkerAllocators;
 
 void ResetRenderDataAllocator()
 {
 	RenderDataAllocator.FreeAll();
+	for (auto allocator : WorkerAllocators) allocator->FreeAll();
+}
+
+//==========================================================================
+//
+// Each BSP worker gets its own arena so that they do not need to synchronize.
+// Must be called before the workers are started.
+//
+//==========================================================================
+
+FMemArena *GetWorkerRenderDataAllocator(int index)
+{
+	while ((int)WorkerAllocators.Size() <= index)
+	{
+		WorkerAllocators.Push(new FMemArena(1024*1024));
+	}
+	return WorkerAllocators[index];
+}
+
+void *AllocRenderData(size_t size)
+{
+	auto allocator = WorkerRenderDataAllocator ? WorkerRenderDataAllocator : &RenderDataAllocator;
+	return allocator->Alloc(size);
 }
 
 //==========================================================================
@@ -622,6 +652,128 @@ SortNode * HWDrawList::SortSpriteList(SortNode * head)
 	return sortspritelist[0];
 }
 
+//==========================================================================
+//
+// Sorts a chain of sprites that has no walls or flats left to split it
+// into the same order as SortSpriteList, but in place: the nodes keep
+// their position and get the sorted items assigned. This way a leaf does
+// not need to know who references its head and independent leaves can be
+// sorted at the same time.
+//
+// Large chains use a radix sort on the depth and index keys instead of
+// comparing through the item lists for every step.
+//
+//==========================================================================
+
+struct SortSpriteKey
+{
+	uint64_t key;
+	int itemindex;
+};
+
+void HWDrawList::SortSpriteLeaf(SortNode * head)
+{
+	thread_local TArray<SortSpriteKey> keys, temp;
+
+	keys.Clear();
+	for (SortNode *n = head; n; n = n->next)
+	{
+		HWSprite *ss = sprites[drawitems[n->itemindex].index];
+		// Larger depth comes first, ties go by index like in CompareSprites.
+		uint32_t depthkey = ~(uint32_t(ss->depth) ^ 0x80000000u);
+		uint32_t indexkey = uint32_t(ss->index) ^ 0x80000000u;
+		if (reverseSort) indexkey = ~indexkey;
+		keys.Push({ (uint64_t(depthkey) << 32) | indexkey, n->itemindex });
+	}
+
+	unsigned count = keys.Size();
+	if (count < 64)
+	{
+		std::stable_sort(keys.begin(), keys.end(), [](const SortSpriteKey &a, const SortSpriteKey &b) { return a.key < b.key; });
+	}
+	else
+	{
+		temp.Resize(count);
+		SortSpriteKey *src = keys.Data(), *dst = temp.Data();
+		for (int shift = 0; shift < 64; shift += 8)
+		{
+			unsigned offsets[256] = {};
+			for (unsigned i = 0; i < count; i++) offsets[(src[i].key >> shift) & 255]++;
+			if (offsets[(src[0].key >> shift) & 255] == count) continue;	// all the same in this byte
+
+			unsigned sum = 0;
+			for (auto &o : offsets)
+			{
+				unsigned c = o;
+				o = sum;
+				sum += c;
+			}
+			for (unsigned i = 0; i < count; i++) dst[offsets[(src[i].key >> shift) & 255]++] = src[i];
+			std::swap(src, dst);
+		}
+		if (src != keys.Data()) memcpy(keys.Data(), src, count * sizeof(SortSpriteKey));
+	}
+
+	SortNode *n = head;
+	for (unsigned i = 0; i < count; i++)
+	{
+		SortNode *nextnode = n->next;
+		n->itemindex = keys[i].itemindex;
+		n->next = NULL;
+		n->equal = nextnode;
+		n = nextnode;
+	}
+}
+
+//==========================================================================
+//
+// Sorts all sprite leaves the last DoSort left behind, spread over the
+// render worker threads if there is enough work.
+//
+//==========================================================================
+
+static TArray<SortNode *> SpriteLeaves;
+static unsigned SpriteLeafItems;
+
+void HWDrawList::SortSpriteLeaves()
+{
+	unsigned numWorkers = renderPool.size() + 1;
+	if (SpriteLeaves.Size() < 2 || SpriteLeafItems < 2048 || numWorkers < 2)
+	{
+		for (auto head : SpriteLeaves) SortSpriteLeaf(head);
+	}
+	else
+	{
+		// Leaves are independent and don't allocate anything so they only need to be split up evenly.
+		std::future<void> futures[16];
+		numWorkers = MIN(numWorkers, 16u);
+		unsigned share = (SpriteLeafItems + numWorkers - 1) / numWorkers;
+		unsigned start = 0, numFutures = 0;
+		while (start < SpriteLeaves.Size())
+		{
+			unsigned end = start, items = 0;
+			while (end < SpriteLeaves.Size() && items < share)
+			{
+				for (SortNode *n = SpriteLeaves[end]; n; n = n->next) items++;
+				end++;
+			}
+			if (end == SpriteLeaves.Size() || numFutures == numWorkers - 1)
+			{
+				for (unsigned i = start; i < SpriteLeaves.Size(); i++) SortSpriteLeaf(SpriteLeaves[i]);
+				break;
+			}
+			futures[numFutures++] = renderPool.push([=](int id)
+			{
+				for (unsigned i = start; i < end; i++) SortSpriteLeaf(SpriteLeaves[i]);
+			});
+			start = end;
+		}
+		for (unsigned i = 0; i < numFutures; i++) futures[i].wait();
+	}
+	SpriteLeaves.Clear();
+	SpriteLeafItems = 0;
+}
+
 //==========================================================================
 //
 //
@@ -685,6 +837,12 @@ SortNode * HWDrawList::DoSort(HWDrawInfo *di, SortNode * head)
 				node=next;
 			}
 		}
+		else if (gl_fastsort)
+		{
+			SpriteLeaves.Push(head);
+			for (SortNode *n = head; n; n = n->next) SpriteLeafItems++;
+			return head;
+		}
 		else 
 		{
 			return SortSpriteList(head);
@@ -706,6 +864,7 @@ void HWDrawList::Sort(HWDrawInfo *di)
     SortZ = di->Viewpoint.Pos.Z;
 	MakeSortList();
 	sorted = DoSort(di, SortNodes[SortNodeStart]);
+	SortSpriteLeaves();
 }
 
 //==========================================================================
@@ -744,6 +903,35 @@ void HWDrawList::SortFlats()
 }
 
 
+//==========================================================================
+//
+// Moves the items of another list to the end of this one, keeping their order
+//
+//==========================================================================
+
+void HWDrawList::Append(HWDrawList &other)
+{
+	for (unsigned i = 0; i < other.drawitems.Size(); i++)
+	{
+		auto &item = other.drawitems[i];
+		switch (item.rendertype)
+		{
+		case DrawType_WALL:
+			drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(other.walls[item.index])));
+			break;
+
+		case DrawType_FLAT:
+			drawitems.Push(HWDrawItem(DrawType_FLAT, flats.Push(other.flats[item.index])));
+			break;
+
+		case DrawType_SPRITE:
+			drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(other.sprites[item.index])));
+			break;
+		}
+	}
+	other.Reset();
+}
+
 //==========================================================================
 //
 //
@@ -752,7 +940,7 @@ void HWDrawList::SortFlats()
 
 HWWall *HWDrawList::NewWall()
 {
-	auto wall = (HWWall*)RenderDataAllocator.Alloc(sizeof(HWWall));
+	auto wall = (HWWall*)AllocRenderData(sizeof(HWWall));
 	drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(wall)));
 	return wall;
 }
@@ -764,7 +952,7 @@ HWWall *HWDrawList::NewWall()
 //==========================================================================
 HWFlat *HWDrawList::NewFlat()
 {
-	auto flat = (HWFlat*)RenderDataAllocator.Alloc(sizeof(HWFlat));
+	auto flat = (HWFlat*)AllocRenderData(sizeof(HWFlat));
 	drawitems.Push(HWDrawItem(DrawType_FLAT,flats.Push(flat)));
 	return flat;
 }
@@ -776,7 +964,7 @@ HWFlat *HWDrawList::NewFlat()
 //==========================================================================
 HWSprite *HWDrawList::NewSprite()
 {	
-	auto sprite = (HWSprite*)RenderDataAllocator.Alloc(sizeof(HWSprite));
+	auto sprite = (HWSprite*)AllocRenderData(sizeof(HWSprite));
 	drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(sprite)));
 	return sprite;
 }
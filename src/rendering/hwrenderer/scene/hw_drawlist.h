@@ -3,7 +3,10 @@
 #include "memarena.h"
 
 extern FMemArena RenderDataAllocator;
+extern thread_local FMemArena *WorkerRenderDataAllocator;
 void ResetRenderDataAllocator();
+FMemArena *GetWorkerRenderDataAllocator(int index);
+void *AllocRenderData(size_t size);
 struct HWDrawInfo;
 class HWWall;
 class HWFlat;
@@ -90,6 +93,7 @@ public:
 	HWWall *NewWall();
 	HWFlat *NewFlat();
 	HWSprite *NewSprite();
+	void Append(HWDrawList &other);
 	void Reset();
 	void SortWalls();
 	void SortFlats();
@@ -105,6 +109,8 @@ public:
 	void SortSpriteIntoWall(HWDrawInfo *di, SortNode * head,SortNode * sort);
 	int CompareSprites(SortNode * a,SortNode * b);
 	SortNode * SortSpriteList(SortNode * head);
+	void SortSpriteLeaf(SortNode * head);
+	void SortSpriteLeaves();
 	SortNode * DoSort(HWDrawInfo *di, SortNode * head);
 	void Sort(HWDrawInfo *di);
 
@@ -29,6 +29,8 @@
 
 EXTERN_CVAR(Bool, gl_seamless)
 
+thread_local HWDrawList *WorkerDrawLists;
+
 //==========================================================================
 //
 // 
@@ -37,9 +39,10 @@ EXTERN_CVAR(Bool, gl_seamless)
 
 void HWDrawInfo::AddWall(HWWall *wall)
 {
+	auto lists = WorkerDrawLists ? WorkerDrawLists : drawlists;
 	if (wall->flags & HWWall::HWF_TRANSLUCENT)
 	{
-		auto newwall = drawlists[GLDL_TRANSLUCENT].NewWall();
+		auto newwall = lists[GLDL_TRANSLUCENT].NewWall();
 		*newwall = *wall;
 	}
 	else
@@ -55,7 +58,7 @@ void HWDrawInfo::AddWall(HWWall *wall)
 		{
 			list = masked ? GLDL_MASKEDWALLS : GLDL_PLAINWALLS;
 		}
-		auto newwall = drawlists[list].NewWall();
+		auto newwall = lists[list].NewWall();
 		*newwall = *wall;
 	}
 }
@@ -68,8 +71,9 @@ void HWDrawInfo::AddWall(HWWall *wall)
 
 void HWDrawInfo::AddMirrorSurface(HWWall *w)
 {
+	auto lists = WorkerDrawLists ? WorkerDrawLists : drawlists;
 	w->type = RENDERWALL_MIRRORSURFACE;
-	auto newwall = drawlists[GLDL_TRANSLUCENTBORDER].NewWall();
+	auto newwall = lists[GLDL_TRANSLUCENTBORDER].NewWall();
 	*newwall = *w;
 
 	// Invalidate vertices to allow setting of texture coordinates
@@ -94,6 +98,7 @@ void HWDrawInfo::AddMirrorSurface(HWWall *w)
 
 void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 {
+	auto lists = WorkerDrawLists ? WorkerDrawLists : drawlists;
 	int list;
 
 	if (flat->renderstyle != STYLE_Translucent || flat->alpha < 1.f - FLT_EPSILON || fog || flat->gltexture == nullptr)
@@ -121,7 +126,7 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 		bool masked = flat->gltexture->isMasked() && ((flat->renderflags&SSRF_RENDER3DPLANES) || flat->stack);
 		list = masked ? GLDL_MASKEDFLATS : GLDL_PLAINFLATS;
 	}
-	auto newflat = drawlists[list].NewFlat();
+	auto newflat = lists[list].NewFlat();
 	*newflat = *flat;
 }
 
@@ -133,6 +138,7 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 //==========================================================================
 void HWDrawInfo::AddSprite(HWSprite *sprite, bool translucent)
 {
+	auto lists = WorkerDrawLists ? WorkerDrawLists : drawlists;
 	int list;
 	// [BB] Allow models to be drawn in the GLDL_TRANSLUCENT pass.
 	if (translucent || sprite->actor == nullptr || (!sprite->modelframe && (sprite->actor->renderflags & RF_SPRITETYPEMASK) != RF_WALLSPRITE))
@@ -144,7 +150,7 @@ void HWDrawInfo::AddSprite(HWSprite *sprite, bool translucent)
 		list = GLDL_MODELS;
 	}
 
-	auto newsprt = drawlists[list].NewSprite();
+	auto newsprt = lists[list].NewSprite();
 	*newsprt = *sprite;
 }
 
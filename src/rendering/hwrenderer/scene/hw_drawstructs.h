@@ -24,6 +24,7 @@ struct FLinePortalSpan;
 struct FDynLightData;
 class VSMatrix;
 struct FSpriteModelFrame;
+struct FModelDrawInfo;
 struct particle_t;
 class FRenderState;
 struct HWDecal;
@@ -273,6 +274,7 @@ public:
 
 public:
 	void Process(HWDrawInfo *di, seg_t *seg, sector_t *frontsector, sector_t *backsector);
+	void ProcessSeg(HWDrawInfo *di, seg_t *seg, sector_t *frontsector, sector_t *backsector);
 	void ProcessLowerMiniseg(HWDrawInfo *di, seg_t *seg, sector_t *frontsector, sector_t *backsector);
 
 	float PointOnSide(float x,float y)
@@ -348,6 +350,7 @@ public:
 	PalEntry ThingColor;	// thing's own color
 	FColormap Colormap;
 	FSpriteModelFrame * modelframe;
+	FModelDrawInfo * modeldraw;	// prepared by HWDrawInfo::PrepareModels
 	FRenderStyle RenderStyle;
 	int OverrideShader;
 
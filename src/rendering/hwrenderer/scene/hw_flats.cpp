@@ -41,6 +41,7 @@
 #include "hwrenderer/utility/hw_lighting.h"
 #include "hwrenderer/textures/hw_material.h"
 #include "hwrenderer/scene/hw_drawinfo.h"
+#include "hwrenderer/scene/hw_geometrycache.h"
 #include "hwrenderer/data/flatvertices.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
 #include "hw_drawstructs.h"
@@ -371,6 +372,11 @@ void HWFlat::DrawFlat(HWDrawInfo *di, FRenderState &state, bool translucent)
 
 inline void HWFlat::PutFlat(HWDrawInfo *di, bool fog)
 {
+	if (RecordingFlat != nullptr)
+	{
+		RecordingFlat->flat = *this;
+		RecordingFlat->put = true;
+	}
 	if (di->isFullbrightScene())
 	{
 		Colormap.Clear();
@@ -506,46 +512,62 @@ void HWFlat::ProcessSector(HWDrawInfo *di, sector_t * frontsector, int which)
 
 		srf |= SSRF_RENDERFLOOR;
 
-		lightlevel = hw_ClampLight(frontsector->GetFloorLight());
-		Colormap = frontsector->Colormap;
-		FlatColor = frontsector->SpecialColors[sector_t::floor];
-		AddColor = frontsector->AdditiveColors[sector_t::floor];
-		port = frontsector->ValidatePortal(sector_t::floor);
-		if ((stack = (port != NULL)))
+		auto cached = hacktype ? nullptr : hw_FindCachedFlat(di, section, frontsector, sector_t::floor);
+		if (cached != nullptr && cached->valid)
 		{
-            /* to be redone in a less invasive manner
-			if (port->mType == PORTS_STACKEDSECTORTHING)
+			if (cached->put)
 			{
-				di->AddFloorStack(sector);	// stacked sector things require visplane merging.
+				*this = cached->flat;
+				PutFlat(di, false);
+				rendered_flats++;
 			}
-             */
-			alpha = frontsector->GetAlpha(sector_t::floor);
 		}
 		else
 		{
-			alpha = 1.0f - frontsector->GetReflect(sector_t::floor);
-		}
+			RecordingFlat = cached;
+			lightlevel = hw_ClampLight(frontsector->GetFloorLight());
+			Colormap = frontsector->Colormap;
+			FlatColor = frontsector->SpecialColors[sector_t::floor];
+			AddColor = frontsector->AdditiveColors[sector_t::floor];
+			port = frontsector->ValidatePortal(sector_t::floor);
+			if ((stack = (port != NULL)))
+			{
+	            /* to be redone in a less invasive manner
+				if (port->mType == PORTS_STACKEDSECTORTHING)
+				{
+					di->AddFloorStack(sector);	// stacked sector things require visplane merging.
+				}
+	             */
+				alpha = frontsector->GetAlpha(sector_t::floor);
+			}
+			else
+			{
+				alpha = 1.0f - frontsector->GetReflect(sector_t::floor);
+			}
 
-		if (alpha != 0.f && frontsector->GetTexture(sector_t::floor) != skyflatnum)
-		{
-			iboindex = frontsector->iboindex[sector_t::floor];
+			if (alpha != 0.f && frontsector->GetTexture(sector_t::floor) != skyflatnum)
+			{
+				iboindex = frontsector->iboindex[sector_t::floor];
 
-			ceiling = false;
-			renderflags = SSRF_RENDERFLOOR;
+				ceiling = false;
+				renderflags = SSRF_RENDERFLOOR;
 
-			if (x.ffloors.Size())
-			{
-				light = P_GetPlaneLight(sector, &frontsector->floorplane, false);
-				if ((!(sector->GetFlags(sector_t::floor)&PLANEF_ABSLIGHTING) || light->lightsource == NULL)
-					&& (light->p_lightlevel != &frontsector->lightlevel))
+				if (x.ffloors.Size())
 				{
-					lightlevel = hw_ClampLight(*light->p_lightlevel);
-				}
+					light = P_GetPlaneLight(sector, &frontsector->floorplane, false);
+					if ((!(sector->GetFlags(sector_t::floor)&PLANEF_ABSLIGHTING) || light->lightsource == NULL)
+						&& (light->p_lightlevel != &frontsector->lightlevel))
+					{
+						lightlevel = hw_ClampLight(*light->p_lightlevel);
+					}
 
-				Colormap.CopyFrom3DLight(light);
+					Colormap.CopyFrom3DLight(light);
+				}
+				renderstyle = STYLE_Translucent;
+				Process(di, frontsector, sector_t::floor, false);
 			}
-			renderstyle = STYLE_Translucent;
-			Process(di, frontsector, sector_t::floor, false);
+			RecordingFlat = nullptr;
+			if (cached != nullptr) cached->valid = true;
 		}
 	}
 
@@ -562,45 +584,61 @@ void HWFlat::ProcessSector(HWDrawInfo *di, sector_t * frontsector, int which)
 
 		srf |= SSRF_RENDERCEILING;
 
-		lightlevel = hw_ClampLight(frontsector->GetCeilingLight());
-		Colormap = frontsector->Colormap;
-		FlatColor = frontsector->SpecialColors[sector_t::ceiling];
-		AddColor = frontsector->AdditiveColors[sector_t::ceiling];
-		port = frontsector->ValidatePortal(sector_t::ceiling);
-		if ((stack = (port != NULL)))
+		auto cached = hacktype ? nullptr : hw_FindCachedFlat(di, section, frontsector, sector_t::ceiling);
+		if (cached != nullptr && cached->valid)
 		{
-            /* as above for floors
-			if (port->mType == PORTS_STACKEDSECTORTHING)
+			if (cached->put)
 			{
-				di->AddCeilingStack(sector);
+				*this = cached->flat;
+				PutFlat(di, false);
+				rendered_flats++;
 			}
-             */
-			alpha = frontsector->GetAlpha(sector_t::ceiling);
 		}
 		else
 		{
-			alpha = 1.0f - frontsector->GetReflect(sector_t::ceiling);
-		}
-
-		if (alpha != 0.f && frontsector->GetTexture(sector_t::ceiling) != skyflatnum)
-		{
-			iboindex = frontsector->iboindex[sector_t::ceiling];
-			ceiling = true;
-			renderflags = SSRF_RENDERCEILING;
+			RecordingFlat = cached;
+			lightlevel = hw_ClampLight(frontsector->GetCeilingLight());
+			Colormap = frontsector->Colormap;
+			FlatColor = frontsector->SpecialColors[sector_t::ceiling];
+			AddColor = frontsector->AdditiveColors[sector_t::ceiling];
+			port = frontsector->ValidatePortal(sector_t::ceiling);
+			if ((stack = (port != NULL)))
+			{
+	            /* as above for floors
+				if (port->mType == PORTS_STACKEDSECTORTHING)
+				{
+					di->AddCeilingStack(sector);
+				}
+	             */
+				alpha = frontsector->GetAlpha(sector_t::ceiling);
+			}
+			else
+			{
+				alpha = 1.0f - frontsector->GetReflect(sector_t::ceiling);
+			}
 
-			if (x.ffloors.Size())
+			if (alpha != 0.f && frontsector->GetTexture(sector_t::ceiling) != skyflatnum)
 			{
-				light = P_GetPlaneLight(sector, &sector->ceilingplane, true);
+				iboindex = frontsector->iboindex[sector_t::ceiling];
+				ceiling = true;
+				renderflags = SSRF_RENDERCEILING;
 
-				if ((!(sector->GetFlags(sector_t::ceiling)&PLANEF_ABSLIGHTING))
-					&& (light->p_lightlevel != &frontsector->lightlevel))
+				if (x.ffloors.Size())
 				{
-					lightlevel = hw_ClampLight(*light->p_lightlevel);
+					light = P_GetPlaneLight(sector, &sector->ceilingplane, true);
+
+					if ((!(sector->GetFlags(sector_t::ceiling)&PLANEF_ABSLIGHTING))
+						&& (light->p_lightlevel != &frontsector->lightlevel))
+					{
+						lightlevel = hw_ClampLight(*light->p_lightlevel);
+					}
+					Colormap.CopyFrom3DLight(light);
 				}
-				Colormap.CopyFrom3DLight(light);
+				renderstyle = STYLE_Translucent;
+				Process(di, frontsector, sector_t::ceiling, false);
 			}
-			renderstyle = STYLE_Translucent;
-			Process(di, frontsector, sector_t::ceiling, false);
+			RecordingFlat = nullptr;
+			if (cached != nullptr) cached->valid = true;
 		}
 	}
 
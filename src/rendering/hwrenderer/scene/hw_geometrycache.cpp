@@ -0,0 +1,345 @@
+//
+//---------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+/*
+** hw_geometrycache.cpp
+** Keeps the processed walls and flats of unchanged sides and sectors
+** across frames.
+**
+** HWWall::Process and the floor and ceiling part of HWFlat::ProcessSector
+** don't depend on the view for anything but sky, horizon, mirror and
+** portal handling, which are never cached. Everything else they read is
+** captured in the sector and side states below, so a changed plane height,
+** scroller, animated texture or light simply makes the entry mismatch and
+** gets it recorded again.
+**
+** The sector states are only updated on the main thread while it traverses
+** the BSP, before any job using that sector gets queued. The workers treat
+** a sector they find unchecked as not cacheable.
+**
+**/
+
+#include <memory>
+#include "p_lnspec.h"
+#include "r_sky.h"
+#include "g_levellocals.h"
+#include "c_cvars.h"
+#include "hwrenderer/scene/hw_drawinfo.h"
+#include "hwrenderer/scene/hw_geometrycache.h"
+#include "hwrenderer/utility/hw_clock.h"
+
+CVAR(Bool, gl_geometrycache, true, 0)
+EXTERN_CVAR(Int, r_fakecontrast)
+
+thread_local HWWallCacheEntry *RecordingWall;
+thread_local HWFlatCacheEntry *RecordingFlat;
+
+struct HWSectorCacheInfo
+{
+	HWSectorState state;
+	int version;
+};
+
+// Everything outside the level geometry that changes the processed walls and flats.
+struct HWGlobalState
+{
+	FLevelLocals *Level;
+	uint32_t flags, flags2, flags3;
+	int compatflags;
+	int WallHorizLight, WallVertLight;
+	float fogdensity, outsidefogdensity;
+	int lightmode;
+	int fakecontrast;
+	bool fullbright;
+};
+
+static bool Enabled;
+static int Generation;
+static int SceneCount;
+static HWGlobalState GlobalState;
+static TArray<HWSectorCacheInfo> SectorInfo;
+static std::unique_ptr<std::atomic<int>[]> SectorChecked;	// the scene in which the sector was last checked
+static TArray<HWWallCacheEntry *> WallCache;
+static TArray<HWFlatCacheEntry> FlatCache;
+
+//==========================================================================
+//
+// Frees everything. Needs to be called when a new level gets loaded
+// because the level and its sectors may reuse the same memory.
+//
+//==========================================================================
+
+void hw_ClearGeometryCache()
+{
+	for (auto entry : WallCache) delete entry;
+	WallCache.Reset();
+	FlatCache.Reset();
+	SectorInfo.Reset();
+	SectorChecked.reset();
+	GlobalState.Level = nullptr;
+	Enabled = false;
+	Generation++;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void GetSectorState(sector_t *sec, HWSectorState &state)
+{
+	memset(&state, 0, sizeof(state));
+	for (int i = 0; i < 2; i++)
+	{
+		auto &plane = sec->planes[i];
+		state.xform[i] = plane.xform;
+		state.alpha[i] = plane.alpha;
+		state.texz[i] = plane.TexZ;
+		state.planeflags[i] = plane.Flags;
+		state.planelight[i] = plane.Light;
+		state.glowcolor[i] = plane.GlowColor;
+		state.glowheight[i] = plane.GlowHeight;
+		state.texture[i] = TexMan.GetTexture(plane.Texture, true);
+		state.reflect[i] = sec->reflect[i];
+		state.Portals[i] = sec->Portals[i];
+	}
+	state.floorplane = sec->floorplane;
+	state.ceilingplane = sec->ceilingplane;
+	for (int i = 0; i < 5; i++)
+	{
+		state.SpecialColors[i] = sec->SpecialColors[i];
+		state.AdditiveColors[i] = sec->AdditiveColors[i];
+	}
+	state.Colormap = sec->Colormap;
+	state.Flags = sec->Flags;
+	state.MoreFlags = sec->MoreFlags & ~SECMF_DRAWN;
+	state.special = sec->special;
+	state.lightlevel = sec->lightlevel;
+	state.transdoor = sec->transdoor;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void GetSideState(side_t *side, HWSideState &state)
+{
+	auto line = side->linedef;
+
+	memset(&state, 0, sizeof(state));
+	for (int i = 0; i < 3; i++)
+	{
+		auto &part = side->textures[i];
+		state.parts[i].xOffset = part.xOffset;
+		state.parts[i].yOffset = part.yOffset;
+		state.parts[i].xScale = part.xScale;
+		state.parts[i].yScale = part.yScale;
+		state.parts[i].texture = TexMan.GetTexture(part.texture, true);
+		state.parts[i].flags = part.flags;
+		state.parts[i].SpecialColors[0] = part.SpecialColors[0];
+		state.parts[i].SpecialColors[1] = part.SpecialColors[1];
+		state.parts[i].AdditiveColor = part.AdditiveColor;
+	}
+	state.v1 = line->v1->fPos();
+	state.v2 = line->v2->fPos();
+	state.linealpha = line->alpha;
+	state.lineflags = line->flags & ~ML_MAPPED;
+	state.linespecial = line->special;
+	state.TexelLength = side->TexelLength;
+	state.Light = side->Light;
+	state.Flags = side->Flags;
+}
+
+//==========================================================================
+//
+// Called by the main thread before the BSP workers get started.
+//
+//==========================================================================
+
+void hw_BeginGeometryCache(HWDrawInfo *di)
+{
+	auto Level = di->Level;
+
+	Enabled = gl_geometrycache;
+	if (!Enabled) return;
+
+	if (GlobalState.Level != Level || SectorInfo.Size() != Level->sectors.Size() || WallCache.Size() != Level->sides.Size() ||
+		FlatCache.Size() != Level->sections.allSections.Size() * 2)
+	{
+		hw_ClearGeometryCache();
+		SectorInfo.Resize(Level->sectors.Size());
+		memset(SectorInfo.Data(), 0, SectorInfo.Size() * sizeof(HWSectorCacheInfo));
+		SectorChecked.reset(new std::atomic<int>[Level->sectors.Size()]);
+		for (unsigned i = 0; i < Level->sectors.Size(); i++) SectorChecked[i] = 0;
+		WallCache.Resize(Level->sides.Size());
+		memset(WallCache.Data(), 0, WallCache.Size() * sizeof(HWWallCacheEntry *));
+		FlatCache.Resize(Level->sections.allSections.Size() * 2);
+		memset(FlatCache.Data(), 0, FlatCache.Size() * sizeof(HWFlatCacheEntry));
+	}
+
+	HWGlobalState state;
+	memset(&state, 0, sizeof(state));
+	state.Level = Level;
+	state.flags = Level->flags;
+	state.flags2 = Level->flags2;
+	state.flags3 = Level->flags3;
+	state.compatflags = Level->i_compatflags;
+	state.WallHorizLight = Level->WallHorizLight;
+	state.WallVertLight = Level->WallVertLight;
+	state.fogdensity = Level->fogdensity;
+	state.outsidefogdensity = Level->outsidefogdensity;
+	state.lightmode = (int)di->lightmode;
+	state.fakecontrast = r_fakecontrast;
+	state.fullbright = di->isFullbrightScene();
+	if (memcmp(&state, &GlobalState, sizeof(state)))
+	{
+		GlobalState = state;
+		Generation++;
+	}
+
+	// Sector checks from previous scenes are stale now.
+	SceneCount++;
+}
+
+//==========================================================================
+//
+// Main thread only. Bumps the sector's version if anything in it changed
+// since it was last looked at.
+//
+//==========================================================================
+
+void hw_CheckGeometrySector(sector_t *sec)
+{
+	if (!Enabled) return;
+
+	int index = sec->sectornum;
+	if (SectorChecked[index].load(std::memory_order_relaxed) == SceneCount) return;
+
+	auto &info = SectorInfo[index];
+	HWSectorState state;
+	GetSectorState(&sec->Level->sectors[index], state);
+	if (memcmp(&state, &info.state, sizeof(state)))
+	{
+		info.state = state;
+		info.version++;
+	}
+	SectorChecked[index].store(SceneCount, std::memory_order_release);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool IsCacheable(HWDrawInfo *di, sector_t *sec)
+{
+	if (sec != &di->Level->sectors[sec->sectornum]) return false;	// fake flat copy, depends on the view
+	if (SectorChecked[sec->sectornum].load(std::memory_order_acquire) != SceneCount) return false;
+	if (sec->e->XFloor.ffloors.Size() || sec->e->XFloor.lightlist.Size()) return false;
+	for (int i = 0; i < 2; i++)
+	{
+		if (sec->GetTexture(i) == skyflatnum || sec->Portals[i] != 0 || sec->reflect[i] != 0) return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Returns nullptr if this side's walls cannot be cached. Otherwise the
+// entry is either valid and can be replayed, or it is reset and its
+// walls need to be recorded.
+//
+//==========================================================================
+
+HWWallCacheEntry *hw_FindCachedWall(HWDrawInfo *di, seg_t *seg, sector_t *frontsector, sector_t *backsector)
+{
+	if (!Enabled) return nullptr;
+
+	auto side = seg->sidedef;
+	auto line = seg->linedef;
+	if (side->Flags & WALLF_POLYOBJ) return nullptr;
+	if (line->special == Line_Horizon || line->special == Line_Mirror) return nullptr;
+	if (line->isVisualPortal() || line->GetTransferredPortal()) return nullptr;
+	if (!IsCacheable(di, frontsector)) return nullptr;
+	if (backsector != nullptr && !IsCacheable(di, backsector)) return nullptr;
+
+	auto &entry = WallCache[side->Index()];
+	if (entry == nullptr) entry = new HWWallCacheEntry();
+
+	HWSideState state;
+	GetSideState(side, state);
+
+	int frontversion = SectorInfo[frontsector->sectornum].version;
+	int backversion = backsector ? SectorInfo[backsector->sectornum].version : 0;
+
+	if (entry->valid && entry->generation == Generation && entry->seg == seg &&
+		entry->frontsector == frontsector && entry->backsector == backsector &&
+		entry->frontversion == frontversion && entry->backversion == backversion &&
+		!memcmp(&state, &entry->state, sizeof(state)))
+	{
+		wallcache_hits++;
+		return entry;
+	}
+
+	wallcache_misses++;
+	entry->valid = false;
+	entry->replayable = true;
+	entry->generation = Generation;
+	entry->seg = seg;
+	entry->frontsector = frontsector;
+	entry->backsector = backsector;
+	entry->frontversion = frontversion;
+	entry->backversion = backversion;
+	entry->state = state;
+	entry->walls.Clear();
+	entry->missingtextures.Clear();
+	return entry;
+}
+
+//==========================================================================
+//
+// Same for one plane of a section.
+//
+//==========================================================================
+
+HWFlatCacheEntry *hw_FindCachedFlat(HWDrawInfo *di, FSection *section, sector_t *frontsector, int plane)
+{
+	if (!Enabled || section == nullptr) return nullptr;
+	if (frontsector->special == GLSector_Skybox || !IsCacheable(di, frontsector)) return nullptr;
+
+	auto &entry = FlatCache[di->Level->sections.SectionIndex(section) * 2 + plane];
+	int version = SectorInfo[frontsector->sectornum].version;
+
+	if (entry.valid && entry.generation == Generation && entry.sector == frontsector && entry.version == version)
+	{
+		flatcache_hits++;
+		return &entry;
+	}
+
+	flatcache_misses++;
+	entry.valid = false;
+	entry.put = false;
+	entry.generation = Generation;
+	entry.sector = frontsector;
+	entry.version = version;
+	return &entry;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "tarray.h"
+#include "hw_drawstructs.h"
+
+struct HWDrawInfo;
+
+//==========================================================================
+//
+// Everything the output of HWWall::Process and the plain floor and
+// ceiling of HWFlat::ProcessSector depends on, except for the view.
+// These get compared as a whole so they must be cleared before being filled.
+//
+//==========================================================================
+
+struct HWSectorState
+{
+	FTransform xform[2];
+	double alpha[2];
+	double texz[2];
+	int planeflags[2];
+	int planelight[2];
+	PalEntry glowcolor[2];
+	float glowheight[2];
+	FTexture *texture[2];
+	secplane_t floorplane, ceilingplane;
+	float reflect[2];
+	PalEntry SpecialColors[5];
+	PalEntry AdditiveColors[5];
+	FColormap Colormap;
+	unsigned Portals[2];
+	uint32_t Flags;
+	uint16_t MoreFlags;
+	short special;
+	short lightlevel;
+	bool transdoor;
+};
+
+struct HWSideState
+{
+	struct
+	{
+		double xOffset, yOffset;
+		double xScale, yScale;
+		FTexture *texture;
+		int flags;
+		PalEntry SpecialColors[2];
+		PalEntry AdditiveColor;
+	} parts[3];
+	DVector2 v1, v2;
+	double linealpha;
+	uint32_t lineflags;
+	int linespecial;
+	uint16_t TexelLength;
+	int16_t Light;
+	uint8_t Flags;
+};
+
+//==========================================================================
+//
+// The recorded output of one sidedef. Walls are stored as they were
+// passed to PutWall, so replaying them redoes all the per-frame work
+// (translucency sorting, decals, lights and vertices).
+//
+//==========================================================================
+
+struct HWCachedWall
+{
+	HWWall wall;
+	bool translucent;
+};
+
+struct HWCachedMissingTexture
+{
+	side_t *side;
+	float backheight;
+	bool upper;
+};
+
+struct HWWallCacheEntry
+{
+	int generation;
+	bool valid;
+	bool replayable;	// cleared if the side adds anything but plain walls, e.g. a portal
+	seg_t *seg;
+	sector_t *frontsector, *backsector;
+	int frontversion, backversion;
+	HWSideState state;
+	TArray<HWCachedWall> walls;
+	TArray<HWCachedMissingTexture> missingtextures;
+};
+
+struct HWFlatCacheEntry
+{
+	int generation;
+	bool valid;
+	bool put;
+	sector_t *sector;
+	int version;
+	HWFlat flat;
+};
+
+// Set while a worker records the output of a wall or flat.
+extern thread_local HWWallCacheEntry *RecordingWall;
+extern thread_local HWFlatCacheEntry *RecordingFlat;
+
+void hw_ClearGeometryCache();
+void hw_BeginGeometryCache(HWDrawInfo *di);
+void hw_CheckGeometrySector(sector_t *sec);
+HWWallCacheEntry *hw_FindCachedWall(HWDrawInfo *di, seg_t *seg, sector_t *frontsector, sector_t *backsector);
+HWFlatCacheEntry *hw_FindCachedFlat(HWDrawInfo *di, FSection *section, sector_t *frontsector, int plane);
@@ -194,6 +194,8 @@ void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float B
 {
 	if (!side->segs[0]->backsector) return;
 
+	std::lock_guard<std::mutex> lock(listMutex);
+
 	for (int i = 0; i < side->numsegs; i++)
 	{
 		seg_t *seg = side->segs[i];
@@ -253,6 +255,8 @@ void HWDrawInfo::AddLowerMissingTexture(side_t * side, subsector_t *sub, float B
 		if (backsec->transdoorheight == backsec->GetPlaneTexZ(sector_t::floor)) return;
 	}
 
+	std::lock_guard<std::mutex> lock(listMutex);
+
 	// we need to check all segs of this sidedef
 	for (int i = 0; i < side->numsegs; i++)
 	{
@@ -270,7 +270,8 @@ void HWSprite::DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent)
 		else
 		{
 			FHWModelRenderer renderer(di, state, dynlightindex);
-			renderer.RenderModel(x, y, z, modelframe, actor, di->Viewpoint.TicFrac);
+			if (modeldraw) renderer.RenderModel(*modeldraw, modelframe, actor);
+			else renderer.RenderModel(x, y, z, modelframe, actor, di->Viewpoint.TicFrac);
 			state.SetVertexBuffer(screen->mVertexData);
 		}
 	}
@@ -782,6 +783,7 @@ void HWSprite::Process(HWDrawInfo *di, AActor* thing, sector_t * sector, area_t
 	}
 
 	modelframe = isPicnumOverride ? nullptr : FindModelFrame(thing->GetClass(), spritenum, thing->frame, !!(thing->flags & MF_DROPPED));
+	modeldraw = nullptr;
 	if (!modelframe)
 	{
 		bool mirror;
@@ -1159,6 +1161,7 @@ void HWSprite::ProcessParticle (HWDrawInfo *di, particle_t *particle, sector_t *
 	ThingColor.a = 255;
 
 	modelframe=nullptr;
+	modeldraw=nullptr;
 	gltexture=nullptr;
 	topclip = LARGE_VALUE;
 	bottomclip = -LARGE_VALUE;
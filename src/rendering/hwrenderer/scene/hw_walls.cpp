@@ -37,6 +37,7 @@
 #include "hwrenderer/utility/hw_lighting.h"
 #include "hwrenderer/scene/hw_drawinfo.h"
 #include "hwrenderer/scene/hw_drawstructs.h"
+#include "hwrenderer/scene/hw_geometrycache.h"
 #include "hwrenderer/scene/hw_portal.h"
 #include "hwrenderer/dynlights/hw_lightbuffer.h"
 #include "hw_renderstate.h"
@@ -434,6 +435,11 @@ const char HWWall::passflag[] = {
 //==========================================================================
 void HWWall::PutWall(HWDrawInfo *di, bool translucent)
 {
+	if (RecordingWall != nullptr)
+	{
+		RecordingWall->walls.Push({ *this, translucent });
+	}
+
 	if (gltexture && gltexture->tex->GetTranslucency() && passflag[type] == 2)
 	{
 		translucent = true;
@@ -490,7 +496,11 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 	auto pstate = screen->mPortalState;
 	HWPortal * portal = nullptr;
 
+	// Portals depend on the view so a side that has one cannot be replayed.
+	if (RecordingWall != nullptr) RecordingWall->replayable = false;
+
 	MakeVertices(di, false);
+	std::unique_lock<std::mutex> lock(di->listMutex);
 	switch (ptype)
 	{
 		// portals don't go into the draw list.
@@ -556,7 +566,10 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 		if (gl_mirror_envmap)
 		{
 			// draw a reflective layer over the mirror
+			// This goes into the worker's own draw list, and its decals take the list lock themselves.
+			lock.unlock();
 			di->AddMirrorSurface(this);
+			lock.lock();
 		}
 		break;
 
@@ -569,7 +582,11 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 			line_t *otherside = lineportal->lines[0]->mDestination;
 			if (otherside != nullptr && otherside->portalindex < di->Level->linePortals.Size())
 			{
+				// Walls on line portals are all processed by the same worker, so nobody else can create this
+				// portal in the meantime, and the actors don't need the other workers to wait.
+				lock.unlock();
 				di->ProcessActorsInPortal(otherside->getPortal()->mGroup, di->in_area);
+				lock.lock();
 			}
 			portal = new HWLineToLinePortal(pstate, lineportal);
 			di->Portals.Push(portal);
@@ -1833,10 +1850,55 @@ void HWWall::DoFFloorBlocks(HWDrawInfo *di, seg_t * seg, sector_t * frontsector,
 	
 //==========================================================================
 //
-// 
+// Replays the walls of this side from the geometry cache if nothing
+// they depend on has changed, otherwise processes and records them.
 //
 //==========================================================================
+
 void HWWall::Process(HWDrawInfo *di, seg_t *seg, sector_t * frontsector, sector_t * backsector)
+{
+	auto cached = hw_FindCachedWall(di, seg, frontsector, backsector);
+	if (cached == nullptr)
+	{
+		ProcessSeg(di, seg, frontsector, backsector);
+	}
+	else if (cached->valid)
+	{
+		if (gl_seamless)
+		{
+			auto line = seg->linedef;
+			if (line->v1->dirty) line->v1->RecalcVertexHeights();
+			if (line->v2->dirty) line->v2->RecalcVertexHeights();
+		}
+
+		auto sub = this->sub;
+		for (auto &rec : cached->walls)
+		{
+			*this = rec.wall;
+			this->sub = sub;
+			PutWall(di, rec.translucent);
+		}
+		for (auto &rec : cached->missingtextures)
+		{
+			if (rec.upper) di->AddUpperMissingTexture(rec.side, sub, rec.backheight);
+			else di->AddLowerMissingTexture(rec.side, sub, rec.backheight);
+		}
+	}
+	else
+	{
+		RecordingWall = cached;
+		ProcessSeg(di, seg, frontsector, backsector);
+		RecordingWall = nullptr;
+		cached->valid = cached->replayable;
+	}
+}
+
+//==========================================================================
+//
+// 
+//
+//==========================================================================
+void HWWall::ProcessSeg(HWDrawInfo *di, seg_t *seg, sector_t * frontsector, sector_t * backsector)
 {
 	vertex_t * v1, *v2;
 	float fch1;
@@ -2053,6 +2115,7 @@ void HWWall::Process(HWDrawInfo *di, seg_t *seg, sector_t * frontsector, sector_
 						if (seg->PartnerSeg != NULL && !(seg->PartnerSeg->Subsector->hacked & 4))
 						{
 							di->AddUpperMissingTexture(seg->sidedef, sub, bch1a);
+							if (RecordingWall != nullptr) RecordingWall->missingtextures.Push({ seg->sidedef, bch1a, true });
 						}
 					}
 				}
@@ -2139,6 +2202,7 @@ void HWWall::Process(HWDrawInfo *di, seg_t *seg, sector_t * frontsector, sector_
 					if (seg->PartnerSeg != NULL && !(seg->PartnerSeg->Subsector->hacked & 4))
 					{
 						di->AddLowerMissingTexture(seg->sidedef, sub, bfh1);
+						if (RecordingWall != nullptr) RecordingWall->missingtextures.Push({ seg->sidedef, bfh1, false });
 					}
 				}
 			}
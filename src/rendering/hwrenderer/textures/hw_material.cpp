@@ -28,6 +28,7 @@
 #include "c_dispatch.h"
 #include "hw_ihwtexture.h"
 #include "hw_material.h"
+#include <mutex>
 
 EXTERN_CVAR(Bool, gl_texture_usehires)
 
@@ -225,7 +226,6 @@ FMaterial::FMaterial(FTexture * tx, bool expanded)
 	SetSpriteRect();
 
 	mTextureLayers.ShrinkToFit();
-	tx->Material[expanded] = this;
 	if (tx->isHardwareCanvas()) tx->bTranslucent = 0;
 }
 
@@ -461,16 +461,22 @@ FMaterial * FMaterial::ValidateTexture(FTexture * tex, bool expand, bool create)
 again:
 	if (tex	&& tex->isValid())
 	{
-		if (tex->bNoExpand) expand = false;
+		if (tex->bNoExpand.load(std::memory_order_acquire)) expand = false;
 
-		FMaterial *hwtex = tex->Material[expand];
+		FMaterial *hwtex = tex->Material[expand].load(std::memory_order_acquire);
 		if (hwtex == NULL && create)
 		{
+			// Several BSP workers may try to create the same material. Creating one can validate its layers, too.
+			static std::recursive_mutex createMutex;
+			std::lock_guard<std::recursive_mutex> lock(createMutex);
+			hwtex = tex->Material[expand].load(std::memory_order_relaxed);
+			if (hwtex != NULL) return hwtex;
+
 			if (expand)
 			{
 				if (tex->isWarped() || tex->isHardwareCanvas() || tex->shaderindex >= FIRST_USER_SHADER || (tex->shaderindex >= SHADER_Specular && tex->shaderindex <= SHADER_PBRBrightmap))
 				{
-					tex->bNoExpand = true;
+					tex->bNoExpand.store(true, std::memory_order_release);
 					goto again;
 				}
 				if (tex->Brightmap != NULL &&
@@ -479,11 +485,13 @@ again:
 					)
 				{
 					// do not expand if the brightmap's size differs.
-					tex->bNoExpand = true;
+					tex->bNoExpand.store(true, std::memory_order_release);
 					goto again;
 				}
 			}
 			hwtex = new FMaterial(tex, expand);
+			// Only publish the material once it is fully constructed.
+			tex->Material[expand].store(hwtex, std::memory_order_release);
 		}
 		return hwtex;
 	}
@@ -142,6 +142,11 @@ public:
 	}
 };
 
+// Texture streaming (see hw_precache.cpp)
+FTextureBuffer hw_CreateTexBuffer(FTexture *tex, int translation, int flags);
+void hw_UploadStreamedTextures();
+void hw_SetTextureStreamWindow(bool open);
+
 #endif
 
 
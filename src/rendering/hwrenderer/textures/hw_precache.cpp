@@ -36,6 +36,20 @@
 #include "image.h"
 #include "v_video.h"
 #include "v_font.h"
+#include "g_levellocals.h"
+#include "d_player.h"
+#include "stats.h"
+#include <float.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+EXTERN_CVAR(Bool, gl_texture_usehires)
+
+CVAR(Bool, gl_texstream, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Float, gl_texstream_budget, 2.f, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 
 //==========================================================================
@@ -65,6 +79,356 @@ static void PrecacheSprite(FTexture *tex, SpriteHits &hits)
 	if (gltex) gltex->PrecacheList(hits);
 }
 
+//==========================================================================
+//
+// Background texture streaming
+//
+// Instead of creating every texture of a level synchronously at load time,
+// the precache list is handed to a decode thread in order of distance from
+// the player. The thread creates the texture buffers, and each frame the
+// render thread turns as many of the finished ones into hardware textures
+// as the upload budget allows. Textures that get drawn before their turn
+// come around pick up the decoded buffer if it is already there.
+//
+// Reading lumps is not thread safe, so the decode thread only runs while
+// the main thread is rendering the 3D scene. The scene only touches the
+// file system through image sources, and every read of those is serialized
+// with FImageSource::DecodeMutex. The lock is held for the reads only, so
+// the conversion and upscaling here don't stall the BSP workers.
+//
+//==========================================================================
+
+struct FStreamedLayer
+{
+	FTexture *tex;
+	int flags;
+	FTextureBuffer buffer;
+	bool taken = false;
+};
+
+struct FStreamedTexture
+{
+	FTexture *tex;
+	int cache;
+	SpriteHits sprites;
+	double distance;
+	std::vector<FStreamedLayer> layers;
+	std::atomic<bool> ready;
+};
+
+class FTextureStreamer
+{
+public:
+	~FTextureStreamer() { Clear(); }
+
+	void Clear();
+	void Add(FTexture *tex, int cache, SpriteHits *sprites, double distance);
+	void Start();
+	void SetWindow(bool open);
+	void Upload();
+	bool Take(FTexture *tex, int flags, FTextureBuffer &buffer);
+
+	int Pending() const { return (int)(Entries.size() - NextUpload); }
+	int Decoded() const { return NextDecode; }
+
+	cycle_t DecodeCycles, UploadCycles;
+	int Uploaded = 0;
+	int Hits = 0;
+	int Discarded = 0;
+
+private:
+	void WorkerMain();
+	void AddLayer(FStreamedTexture *entry, FTexture *tex, int flags);
+
+	std::vector<std::unique_ptr<FStreamedTexture>> Entries;
+	TMap<FTexture *, unsigned> EntryIndex;
+	unsigned NextUpload = 0;
+	std::atomic<int> NextDecode{ 0 };
+
+	std::thread Worker;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	bool WindowOpen = false;
+	bool Busy = false;
+	bool StopWorker = false;
+};
+
+static FTextureStreamer TextureStreamer;
+
+ADD_STAT(texstream)
+{
+	FString out;
+	out.Format("Texture stream: %d pending, %d decoded, %d uploaded, %d drawn early, %d discarded\n"
+		"decode=%2.3f ms total, upload=%2.3f ms",
+		TextureStreamer.Pending(), TextureStreamer.Decoded(), TextureStreamer.Uploaded, TextureStreamer.Hits, TextureStreamer.Discarded,
+		TextureStreamer.DecodeCycles.TimeMS(), TextureStreamer.UploadCycles.TimeMS());
+	return out;
+}
+
+void FTextureStreamer::Clear()
+{
+	if (Worker.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			StopWorker = true;
+		}
+		Condition.notify_all();
+		Worker.join();
+	}
+	StopWorker = false;
+	WindowOpen = false;
+	Entries.clear();
+	EntryIndex.Clear();
+	NextUpload = 0;
+	NextDecode = 0;
+	Uploaded = Hits = Discarded = 0;
+	DecodeCycles.Reset();
+	UploadCycles.Reset();
+}
+
+void FTextureStreamer::AddLayer(FStreamedTexture *entry, FTexture *tex, int flags)
+{
+	for (auto &layer : entry->layers)
+	{
+		if (layer.tex == tex && layer.flags == flags) return;
+	}
+	entry->layers.emplace_back();
+	entry->layers.back().tex = tex;
+	entry->layers.back().flags = flags | CTF_ProcessData;
+	if (!EntryIndex.CheckKey(tex)) EntryIndex[tex] = (unsigned)Entries.size() - 1;
+}
+
+void FTextureStreamer::Add(FTexture *tex, int cache, SpriteHits *sprites, double distance)
+{
+	Entries.emplace_back(new FStreamedTexture);
+	auto entry = Entries.back().get();
+	entry->tex = tex;
+	entry->cache = cache;
+	if (sprites) entry->sprites = *sprites;
+	entry->distance = distance;
+	entry->ready = false;
+
+	// Same flags as PrecacheMaterial. Only untranslated images get decoded up front.
+	if (cache & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky))
+	{
+		FMaterial *mat = FMaterial::ValidateTexture(tex, false);
+		if (mat != nullptr && !tex->isSWCanvas())
+		{
+			AddLayer(entry, tex, (gl_texture_usehires && !tex->isScaled()) ? CTF_CheckHires : 0);
+			for (int i = 1; i < mat->GetLayers(); i++) AddLayer(entry, mat->GetLayerArray()[i - 1], 0);
+		}
+	}
+	if (sprites != nullptr && sprites->CheckKey(0))
+	{
+		FMaterial *mat = FMaterial::ValidateTexture(tex, true);
+		if (mat != nullptr && !tex->isSWCanvas())
+		{
+			AddLayer(entry, tex, CTF_Expand);
+			for (int i = 1; i < mat->GetLayers(); i++) AddLayer(entry, mat->GetLayerArray()[i - 1], CTF_Expand);
+		}
+	}
+}
+
+void FTextureStreamer::Start()
+{
+	// The index was filled in insertion order, so it needs to be rebuilt after sorting.
+	std::stable_sort(Entries.begin(), Entries.end(), [](const std::unique_ptr<FStreamedTexture> &a, const std::unique_ptr<FStreamedTexture> &b)
+	{
+		return a->distance < b->distance;
+	});
+	EntryIndex.Clear();
+	for (unsigned i = 0; i < Entries.size(); i++)
+	{
+		for (auto &layer : Entries[i]->layers)
+		{
+			if (!EntryIndex.CheckKey(layer.tex)) EntryIndex[layer.tex] = i;
+		}
+	}
+	if (Entries.size() > 0) Worker = std::thread([this]() { WorkerMain(); });
+}
+
+void FTextureStreamer::WorkerMain()
+{
+	while (true)
+	{
+		unsigned index = NextDecode;
+		if (index >= Entries.size()) return;
+		auto entry = Entries[index].get();
+
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			Condition.wait(lock, [this]() { return WindowOpen || StopWorker; });
+			if (StopWorker) return;
+			Busy = true;
+		}
+
+		DecodeCycles.Clock();
+		for (auto &layer : entry->layers)
+		{
+			layer.buffer = layer.tex->CreateTexBuffer(0, layer.flags);
+		}
+		DecodeCycles.Unclock();
+		entry->ready.store(true, std::memory_order_release);
+		NextDecode = index + 1;
+
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			Busy = false;
+		}
+		Condition.notify_all();
+	}
+}
+
+void FTextureStreamer::SetWindow(bool open)
+{
+	if (!Worker.joinable()) return;
+	std::unique_lock<std::mutex> lock(Mutex);
+	WindowOpen = open;
+	if (open)
+	{
+		lock.unlock();
+		Condition.notify_all();
+	}
+	else
+	{
+		// Let the texture that is being decoded finish before anything else may touch the file system again.
+		Condition.wait(lock, [this]() { return !Busy; });
+	}
+}
+
+bool FTextureStreamer::Take(FTexture *tex, int flags, FTextureBuffer &buffer)
+{
+	auto pIndex = EntryIndex.CheckKey(tex);
+	if (pIndex == nullptr) return false;
+
+	auto entry = Entries[*pIndex].get();
+	if (!entry->ready.load(std::memory_order_acquire)) return false;
+
+	for (auto &layer : entry->layers)
+	{
+		if (layer.tex == tex && layer.flags == flags && !layer.taken)
+		{
+			buffer = std::move(layer.buffer);
+			layer.taken = true;
+			if (*pIndex >= NextUpload) Hits++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void FTextureStreamer::Upload()
+{
+	UploadCycles.Reset();
+	if (NextUpload >= Entries.size()) return;
+
+	UploadCycles.Clock();
+	while (NextUpload < Entries.size() && UploadCycles.TimeMS() < gl_texstream_budget)
+	{
+		auto entry = Entries[NextUpload].get();
+		if (!entry->ready.load(std::memory_order_acquire)) break;
+
+		// The decoded buffers are picked up by hw_CreateTexBuffer while the hardware textures get created.
+		PrecacheTexture(entry->tex, entry->cache);
+		if (entry->sprites.CountUsed() > 0) PrecacheSprite(entry->tex, entry->sprites);
+
+		for (auto &layer : entry->layers)
+		{
+			if (!layer.taken) Discarded++;
+			layer.buffer = FTextureBuffer();
+			layer.taken = true;
+		}
+		NextUpload++;
+		Uploaded++;
+	}
+	UploadCycles.Unclock();
+
+	if (NextUpload == Entries.size()) Clear();
+}
+
+//==========================================================================
+//
+// Creates the buffer for a hardware texture, using the streamed one if
+// it has already been decoded.
+//
+//==========================================================================
+
+FTextureBuffer hw_CreateTexBuffer(FTexture *tex, int translation, int flags)
+{
+	FTextureBuffer buffer;
+	if (translation == 0 && TextureStreamer.Take(tex, flags, buffer)) return buffer;
+	return tex->CreateTexBuffer(translation, flags);
+}
+
+void hw_UploadStreamedTextures()
+{
+	TextureStreamer.Upload();
+}
+
+void hw_SetTextureStreamWindow(bool open)
+{
+	TextureStreamer.SetWindow(open);
+}
+
+//==========================================================================
+//
+// Distance of everything in the precache list from the player, so that
+// the streamer gets to the things that will be seen first.
+//
+//==========================================================================
+
+static void GetPrecacheDistances(FLevelLocals *Level, TArray<double> &texdist, TArray<double> &spritedist)
+{
+	DVector2 viewpos = Level->playerstarts[consoleplayer].pos;
+	if (playeringame[consoleplayer] && Level->Players[consoleplayer]->mo != nullptr)
+		viewpos = Level->Players[consoleplayer]->mo->Pos();
+
+	auto setDist = [&](FTextureID texid, double dist)
+	{
+		if (texid.isValid()) texdist[texid.GetIndex()] = MIN(texdist[texid.GetIndex()], dist);
+	};
+
+	for (auto &sec : Level->sectors)
+	{
+		double dist = (sec.centerspot - viewpos).LengthSquared();
+		setDist(sec.GetTexture(sector_t::floor), dist);
+		setDist(sec.GetTexture(sector_t::ceiling), dist);
+	}
+	for (auto &side : Level->sides)
+	{
+		auto line = side.linedef;
+		double dist = ((line->v1->fPos() + line->v2->fPos()) * 0.5 - viewpos).LengthSquared();
+		setDist(side.GetTexture(side_t::top), dist);
+		setDist(side.GetTexture(side_t::mid), dist);
+		setDist(side.GetTexture(side_t::bottom), dist);
+	}
+
+	// Sprites of actors that are not in the level yet go after all the others.
+	TMap<PClassActor *, double> classdist;
+	AActor *actor;
+	auto iterator = Level->GetThinkerIterator<AActor>();
+	while ((actor = iterator.Next()))
+	{
+		double dist = (actor->Pos().XY() - viewpos).LengthSquared();
+		auto pDist = classdist.CheckKey(actor->GetClass());
+		if (pDist == nullptr) classdist[actor->GetClass()] = dist;
+		else *pDist = MIN(*pDist, dist);
+	}
+
+	TMap<PClassActor *, double>::Iterator it(classdist);
+	TMap<PClassActor *, double>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		auto cls = pair->Key;
+		for (unsigned i = 0; i < cls->GetStateCount(); i++)
+		{
+			int sprite = cls->GetStates()[i].sprite;
+			spritedist[sprite] = MIN(spritedist[sprite], pair->Value);
+		}
+	}
+}
+
 //==========================================================================
 //
 // DFrameBuffer :: Precache
@@ -73,6 +437,9 @@ static void PrecacheSprite(FTexture *tex, SpriteHits &hits)
 
 void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitlist)
 {
+	// Anything still streaming from the last level is of no use anymore.
+	TextureStreamer.Clear();
+
 	SpriteHits *spritelist = new SpriteHits[sprites.Size()];
 	SpriteHits **spritehitlist = new SpriteHits*[TexMan.NumTextures()];
 	TMap<PClassActor*, bool>::Iterator it(actorhitlist);
@@ -220,7 +587,29 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 		}
 	}
 
-	if (gl_precache)
+	if (gl_precache && gl_texstream)
+	{
+		TArray<double> texdist(cnt, true), spritedist(sprites.Size(), true);
+		for (auto &d : texdist) d = DBL_MAX;
+		for (auto &d : spritedist) d = DBL_MAX;
+		GetPrecacheDistances(primaryLevel, texdist, spritedist);
+
+		for (int i = cnt - 1; i >= 0; i--)
+		{
+			FTexture *tex = TexMan.ByIndex(i);
+			if (tex == nullptr) continue;
+
+			int cache = texhitlist[i] & (FTextureManager::HIT_Wall | FTextureManager::HIT_Flat | FTextureManager::HIT_Sky);
+			SpriteHits *hits = spritehitlist[i] != nullptr && spritehitlist[i]->CountUsed() > 0 ? spritehitlist[i] : nullptr;
+			if (cache == 0 && hits == nullptr) continue;
+
+			double dist = cache ? texdist[i] : DBL_MAX;
+			if (hits != nullptr) dist = MIN(dist, spritedist[hits - spritelist]);
+			TextureStreamer.Add(tex, cache, hits, dist);
+		}
+		TextureStreamer.Start();
+	}
+	else if (gl_precache)
 	{
 		FImageSource::BeginPrecaching();
 
@@ -262,7 +651,10 @@ void hw_PrecacheTexture(uint8_t *texhitlist, TMap<PClassActor*, bool> &actorhitl
 
 
 		FImageSource::EndPrecaching();
+	}
 
+	if (gl_precache)
+	{
 		// cache all used models
 		FModelRenderer *renderer = screen->CreateModelRenderer(-1);
 		for (unsigned i = 0; i < Models.Size(); i++)
@@ -54,7 +54,9 @@ glcycle_t twoD, Flush3D;
 glcycle_t MTWait, WTTotal;
 int vertexcount, flatvertices, flatprimitives;
 
-int rendered_lines,rendered_flats,rendered_sprites,render_vertexsplit,render_texsplit,rendered_decals, rendered_portals, rendered_commandbuffers;
+int render_vertexsplit,rendered_decals, rendered_portals, rendered_commandbuffers;
+std::atomic<int> rendered_lines, rendered_flats, rendered_sprites, render_texsplit;
+std::atomic<int> wallcache_hits, wallcache_misses, flatcache_hits, flatcache_misses;
 int iter_dlightf, iter_dlight, draw_dlight, draw_dlightf;
 
 void ResetProfilingData()
@@ -79,6 +81,7 @@ void ResetProfilingData()
 
 	flatvertices=flatprimitives=vertexcount=0;
 	render_texsplit=render_vertexsplit=rendered_lines=rendered_flats=rendered_sprites=rendered_decals=rendered_portals = 0;
+	wallcache_hits=wallcache_misses=flatcache_hits=flatcache_misses=0;
 }
 
 //-----------------------------------------------------------------------------
@@ -114,7 +117,13 @@ static void AppendRenderStats(FString &out)
 	out.AppendFormat("Walls: %d (%d splits, %d t-splits, %d vertices)\n"
 		"Flats: %d (%d primitives, %d vertices)\n"
 		"Sprites: %d, Decals=%d, Portals: %d, Command buffers: %d\n",
-		rendered_lines, render_vertexsplit, render_texsplit, vertexcount, rendered_flats, flatprimitives, flatvertices, rendered_sprites,rendered_decals, rendered_portals, rendered_commandbuffers );
+		rendered_lines.load(), render_vertexsplit, render_texsplit.load(), vertexcount, rendered_flats.load(), flatprimitives, flatvertices, rendered_sprites.load(), rendered_decals, rendered_portals, rendered_commandbuffers );
+
+	int wallhits = wallcache_hits, walllookups = wallhits + wallcache_misses;
+	int flathits = flatcache_hits, flatlookups = flathits + flatcache_misses;
+	out.AppendFormat("Geometry cache: walls %d of %d (%d%%), flats %d of %d (%d%%)\n",
+		wallhits, walllookups, walllookups > 0 ? wallhits * 100 / walllookups : 0,
+		flathits, flatlookups, flatlookups > 0 ? flathits * 100 / flatlookups : 0);
 }
 
 static void AppendLightStats(FString &out)
@@ -1,6 +1,7 @@
 #ifndef __GL_CLOCK_H
 #define __GL_CLOCK_H
 
+#include <atomic>
 #include "stats.h"
 #include "x86.h"
 #include "m_fixed.h"
@@ -16,9 +17,13 @@ extern glcycle_t drawcalls, twoD, Flush3D;
 extern glcycle_t MTWait, WTTotal;
 
 extern int iter_dlightf, iter_dlight, draw_dlight, draw_dlightf;
-extern int rendered_lines,rendered_flats,rendered_sprites,rendered_decals,render_vertexsplit,render_texsplit;
+extern int rendered_decals,render_vertexsplit;
 extern int rendered_portals;
 
+// These are counted while processing the scene, which can happen on several BSP workers at once.
+extern std::atomic<int> rendered_lines, rendered_flats, rendered_sprites, render_texsplit;
+extern std::atomic<int> wallcache_hits, wallcache_misses, flatcache_hits, flatcache_misses;
+
 extern int vertexcount, flatvertices, flatprimitives;
 
 void ResetProfilingData();
@@ -87,6 +87,13 @@ void PolyTriangleDrawer::SetTransform(const DrawerCommandQueuePtr &queue, const
 	queue->Push<PolySetTransformCommand>(objectToClip, objectToWorld);
 }
 
+void PolyTriangleDrawer::SetBinning(const DrawerCommandQueuePtr &queue, bool enable)
+{
+	// Tile and line ownership differ. Wait for all threads before switching so that no pixel has two owners at once.
+	queue->Push<PolySetBinningCommand>(enable);
+	queue->Push<GroupMemoryBarrierCommand>();
+}
+
 void PolyTriangleDrawer::SetCullCCW(const DrawerCommandQueuePtr &queue, bool ccw)
 {
 	queue->Push<PolySetCullCCWCommand>(ccw);
@@ -126,6 +133,24 @@ void PolyTriangleThreadData::ClearStencil(uint8_t value)
 	int height = buffer->Height();
 	uint8_t *data = buffer->Values();
 
+	if (binning)
+	{
+		FlushBins();
+
+		int y0 = MAX(numa_start_y, 0);
+		int y1 = MIN(numa_end_y, height);
+		for (int y = y0; y < y1; y++)
+		{
+			int tileY = y >> TileShift;
+			for (int x = 0; x < width; x += TileSize)
+			{
+				if (tile_owned_by_thread(x >> TileShift, tileY))
+					memset(data + x + y * width, value, MIN(width - x, (int)TileSize));
+			}
+		}
+		return;
+	}
+
 	int skip = skipped_by_thread(0);
 	int count = count_for_thread(0, height);
 
@@ -139,6 +164,8 @@ void PolyTriangleThreadData::ClearStencil(uint8_t value)
 
 void PolyTriangleThreadData::SetViewport(int x, int y, int width, int height, uint8_t *new_dest, int new_dest_width, int new_dest_height, int new_dest_pitch, bool new_dest_bgra)
 {
+	FlushBins();
+
 	viewport_x = x;
 	viewport_y = y;
 	viewport_width = width;
@@ -152,6 +179,12 @@ void PolyTriangleThreadData::SetViewport(int x, int y, int width, int height, ui
 	weaponScene = false;
 }
 
+void PolyTriangleThreadData::SetBinning(bool enable)
+{
+	FlushBins();
+	binning = enable;
+}
+
 void PolyTriangleThreadData::SetTransform(const Mat4f *newObjectToClip, const Mat4f *newObjectToWorld)
 {
 	objectToClip = newObjectToClip;
@@ -430,7 +463,10 @@ void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *vert, boo
 			args->v3 = &clippedvert[i - 2];
 			if (IsFrontfacing(args) == ccw && args->CalculateGradients())
 			{
-				ScreenTriangle::Draw(args, this);
+				if (binning)
+					BinTriangle(args);
+				else
+					ScreenTriangle::Draw(args, this);
 			}
 		}
 	}
@@ -443,12 +479,219 @@ void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *vert, boo
 			args->v3 = &clippedvert[i];
 			if (IsFrontfacing(args) != ccw && args->CalculateGradients())
 			{
-				ScreenTriangle::Draw(args, this);
+				if (binning)
+					BinTriangle(args);
+				else
+					ScreenTriangle::Draw(args, this);
 			}
 		}
 	}
 }
 
+void PolyTriangleThreadData::BinTriangle(const TriDrawTriangleArgs *args)
+{
+	// Conservative screen bounds. The tile rasterizer clips the exact edges against each tile.
+	float minX = MIN(MIN(args->v1->x, args->v2->x), args->v3->x);
+	float maxX = MAX(MAX(args->v1->x, args->v2->x), args->v3->x);
+	float minY = MIN(MIN(args->v1->y, args->v2->y), args->v3->y);
+	float maxY = MAX(MAX(args->v1->y, args->v2->y), args->v3->y);
+
+	int cliptop = MAX(viewport_y, numa_start_y);
+	int clipbottom = MIN(dest_height, numa_end_y);
+
+	int x0 = clamp((int)floorf(minX), 0, dest_width);
+	int x1 = clamp((int)ceilf(maxX) + 1, 0, dest_width);
+	int y0 = clamp((int)(minY + 0.5f), cliptop, clipbottom);
+	int y1 = clamp((int)(maxY + 0.5f), cliptop, clipbottom);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	int newTilesX = (dest_width + TileSize - 1) >> TileShift;
+	int newTilesY = (dest_height + TileSize - 1) >> TileShift;
+	if (newTilesX != tilesX || newTilesY != tilesY)
+	{
+		tilesX = newTilesX;
+		tilesY = newTilesY;
+		tileBins.resize(tilesX * tilesY);
+	}
+
+	uint32_t index = (uint32_t)binnedTriangles.size();
+	bool binned = false;
+
+	int tileX0 = x0 >> TileShift;
+	int tileX1 = (x1 - 1) >> TileShift;
+	int tileY0 = y0 >> TileShift;
+	int tileY1 = (y1 - 1) >> TileShift;
+	for (int tileY = tileY0; tileY <= tileY1; tileY++)
+	{
+		for (int tileX = tileX0; tileX <= tileX1; tileX++)
+		{
+			if (tile_owned_by_thread(tileX, tileY))
+			{
+				// Skip tiles only the bounding box touches
+				uint64_t blocks = ScreenTriangle::BlockCoverage(args, tileX << TileShift, tileY << TileShift);
+				if (blocks != 0)
+				{
+					tileBins[tileX + tileY * tilesX].push_back({ index, blocks });
+					binned = true;
+				}
+			}
+		}
+	}
+
+	if (binned)
+	{
+		binnedTriangles.push_back(BinnedTriangle());
+		BinnedTriangle &tri = binnedTriangles.back();
+		tri.vertices[0] = *args->v1;
+		tri.vertices[1] = *args->v2;
+		tri.vertices[2] = *args->v3;
+		tri.args = *args;
+		tri.weaponScene = weaponScene;
+		tri.x0 = x0;
+		tri.y0 = y0;
+		tri.x1 = x1;
+		tri.y1 = y1;
+	}
+}
+
+void PolyTriangleThreadData::FlushBins()
+{
+	if (binnedTriangles.empty())
+		return;
+
+	for (BinnedTriangle &tri : binnedTriangles)
+	{
+		tri.args.v1 = &tri.vertices[0];
+		tri.args.v2 = &tri.vertices[1];
+		tri.args.v3 = &tri.vertices[2];
+	}
+
+	bool savedWeaponScene = weaponScene;
+
+	int cliptop = MAX(viewport_y, numa_start_y);
+	int clipbottom = MIN(dest_height, numa_end_y);
+
+	for (int tileY = 0; tileY < tilesY; tileY++)
+	{
+		for (int tileX = 0; tileX < tilesX; tileX++)
+		{
+			std::vector<TileBinEntry> &bin = tileBins[tileX + tileY * tilesX];
+			if (bin.empty())
+				continue;
+
+			int tileLeft = tileX << TileShift;
+			int tileRight = MIN(tileLeft + (int)TileSize, dest_width);
+			int tileTop = MAX(tileY << TileShift, cliptop);
+			int tileBottom = MIN((tileY << TileShift) + (int)TileSize, clipbottom);
+
+			// Depth buffer values only grow while depth testing is on, so the smallest value in the tile
+			// stays a valid lower bound until something writes depth without testing it.
+			bool tileDepthValid = false;
+			float tileDepth = 0.0f;
+
+			for (const TileBinEntry &entry : bin)
+			{
+				const BinnedTriangle &tri = binnedTriangles[entry.triangle];
+
+				// Narrow the area down to the covered blocks
+				int blockX0, blockY0, blockX1, blockY1;
+				BlockBounds(entry.blocks, blockX0, blockY0, blockX1, blockY1);
+				int x0 = MAX(MAX(tri.x0, tileLeft), (tileX << TileShift) + blockX0 * 8);
+				int x1 = MIN(MIN(tri.x1, tileRight), (tileX << TileShift) + blockX1 * 8);
+				int y0 = MAX(MAX(tri.y0, tileTop), (tileY << TileShift) + blockY0 * 8);
+				int y1 = MIN(MIN(tri.y1, tileBottom), (tileY << TileShift) + blockY1 * 8);
+				if (x0 >= x1 || y0 >= y1)
+					continue;
+
+				weaponScene = tri.weaponScene;
+
+				if (tri.args.uniforms->DepthTest())
+				{
+					if (!tileDepthValid)
+					{
+						tileDepth = TileDepthMin(tileLeft, tileTop, tileRight, tileBottom);
+						tileDepthValid = true;
+					}
+
+					// Early out if the whole triangle fails the depth test in this tile
+					if (TriangleDepthMax(&tri.args, x0, y0, x1, y1, weaponScene ? 1.0f : 0.0f) < tileDepth)
+						continue;
+				}
+				else if (tri.args.uniforms->WriteDepth())
+				{
+					tileDepthValid = false;
+				}
+
+				ScreenTriangle::DrawTile(&tri.args, this, x0, y0, x1, y1);
+			}
+
+			bin.clear();
+		}
+	}
+
+	binnedTriangles.clear();
+	weaponScene = savedWeaponScene;
+}
+
+void PolyTriangleThreadData::BlockBounds(uint64_t blocks, int &x0, int &y0, int &x1, int &y1)
+{
+	uint8_t columns = 0;
+	y0 = 8;
+	y1 = 0;
+	for (int y = 0; y < 8; y++)
+	{
+		uint8_t row = (uint8_t)(blocks >> (y * 8));
+		if (row)
+		{
+			columns |= row;
+			y0 = MIN(y0, y);
+			y1 = y + 1;
+		}
+	}
+
+	x0 = 8;
+	x1 = 0;
+	for (int x = 0; x < 8; x++)
+	{
+		if (columns & (1 << x))
+		{
+			x0 = MIN(x0, x);
+			x1 = x + 1;
+		}
+	}
+}
+
+float PolyTriangleThreadData::TileDepthMin(int x0, int y0, int x1, int y1)
+{
+	const float *zbuffer = PolyZBuffer::Instance()->Values();
+	int pitch = PolyStencilBuffer::Instance()->Width();
+
+	float depth = FLT_MAX;
+	for (int y = y0; y < y1; y++)
+	{
+		const float *line = zbuffer + y * pitch;
+		for (int x = x0; x < x1; x++)
+			depth = MIN(depth, line[x]);
+	}
+	return depth;
+}
+
+float PolyTriangleThreadData::TriangleDepthMax(const TriDrawTriangleArgs *args, int x0, int y0, int x1, int y1, float wOffset)
+{
+	// 1/w is linear in screen space. The largest value in the rectangle is found at one of its corners.
+	float stepXW = args->gradientX.W;
+	float stepYW = args->gradientY.W;
+	float startX = x0 + 0.5f - args->v1->x;
+	float endX = x1 - 0.5f - args->v1->x;
+	float startY = y0 + 0.5f - args->v1->y;
+	float endY = y1 - 0.5f - args->v1->y;
+	float w = args->v1->w + MAX(stepXW * startX, stepXW * endX) + MAX(stepYW * startY, stepYW * endY) + wOffset;
+
+	// Leave room for the rounding errors of the incremental stepping in the span loops
+	return w + fabsf(w) * (1.0f / 1024.0f);
+}
+
 int PolyTriangleThreadData::ClipEdge(const ShadedTriVertex *verts, ShadedTriVertex *clippedvert)
 {
 	// Clip and cull so that the following is true for all vertices:
@@ -687,6 +930,17 @@ void PolySetModelVertexShaderCommand::Execute(DrawerThread *thread)
 
 /////////////////////////////////////////////////////////////////////////////
 
+PolySetBinningCommand::PolySetBinningCommand(bool enable) : enable(enable)
+{
+}
+
+void PolySetBinningCommand::Execute(DrawerThread *thread)
+{
+	PolyTriangleThreadData::Get(thread)->SetBinning(enable);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 PolyClearStencilCommand::PolyClearStencilCommand(uint8_t value) : value(value)
 {
 }
@@ -42,6 +42,7 @@ public:
 	static void SetWeaponScene(const DrawerCommandQueuePtr &queue, bool enable);
 	static void SetModelVertexShader(const DrawerCommandQueuePtr &queue, int frame1, int frame2, float interpolationFactor);
 	static void SetTransform(const DrawerCommandQueuePtr &queue, const Mat4f *objectToClip, const Mat4f *objectToWorld);
+	static void SetBinning(const DrawerCommandQueuePtr &queue, bool enable);
 	static void DrawArray(const DrawerCommandQueuePtr &queue, const PolyDrawArgs &args, const void *vertices, int vcount, PolyDrawMode mode = PolyDrawMode::Triangles);
 	static void DrawElements(const DrawerCommandQueuePtr &queue, const PolyDrawArgs &args, const void *vertices, const unsigned int *elements, int count, PolyDrawMode mode = PolyDrawMode::Triangles);
 	static bool IsBgra();
@@ -59,6 +60,7 @@ public:
 	void SetTwoSided(bool value) { twosided = value; }
 	void SetWeaponScene(bool value) { weaponScene = value; }
 	void SetModelVertexShader(int frame1, int frame2, float interpolationFactor) { modelFrame1 = frame1; modelFrame2 = frame2; modelInterpolationFactor = interpolationFactor; }
+	void SetBinning(bool enable);
 
 	void DrawElements(const PolyDrawArgs &args, const void *vertices, const unsigned int *elements, int count, PolyDrawMode mode);
 	void DrawArray(const PolyDrawArgs &args, const void *vertices, int vcount, PolyDrawMode mode);
@@ -90,6 +92,20 @@ public:
 		return MAX(c, 0);
 	}
 
+	// Binning mode: the screen is split into tiles and each thread only rasterizes the tiles it owns
+	enum
+	{
+		TileShift = 6,
+		TileSize = 1 << TileShift // ScreenTriangle::BlockCoverage assumes 8x8 blocks of 8x8 pixels
+	};
+
+	bool binning = false;
+
+	bool tile_owned_by_thread(int tileX, int tileY)
+	{
+		return (tileX + tileY) % num_cores == core;
+	}
+
 	// Varyings
 	float worldposX[MAXWIDTH];
 	float worldposY[MAXWIDTH];
@@ -117,6 +133,31 @@ private:
 	static bool IsFrontfacing(TriDrawTriangleArgs *args);
 	static int ClipEdge(const ShadedTriVertex *verts, ShadedTriVertex *clippedvert);
 
+	void BinTriangle(const TriDrawTriangleArgs *args);
+	void FlushBins();
+	float TileDepthMin(int x0, int y0, int x1, int y1);
+	static void BlockBounds(uint64_t blocks, int &x0, int &y0, int &x1, int &y1);
+	static float TriangleDepthMax(const TriDrawTriangleArgs *args, int x0, int y0, int x1, int y1, float wOffset);
+
+	struct BinnedTriangle
+	{
+		ShadedTriVertex vertices[3];
+		TriDrawTriangleArgs args;
+		bool weaponScene;
+		int x0, y0, x1, y1;
+	};
+
+	struct TileBinEntry
+	{
+		uint32_t triangle;
+		uint64_t blocks; // 8x8 blocks of the tile the triangle may cover
+	};
+
+	std::vector<BinnedTriangle> binnedTriangles;
+	std::vector<std::vector<TileBinEntry>> tileBins;
+	int tilesX = 0;
+	int tilesY = 0;
+
 	int viewport_x = 0;
 	int viewport_width = 0;
 	int viewport_height = 0;
@@ -194,6 +235,17 @@ private:
 	float interpolationFactor;
 };
 
+class PolySetBinningCommand : public PolyDrawerCommand
+{
+public:
+	PolySetBinningCommand(bool enable);
+
+	void Execute(DrawerThread *thread) override;
+
+private:
+	bool enable;
+};
+
 class PolyClearStencilCommand : public PolyDrawerCommand
 {
 public:
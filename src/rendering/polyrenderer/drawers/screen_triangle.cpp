@@ -37,8 +37,10 @@
 #include "swrenderer/drawers/r_draw_rgba.h"
 #include "screen_triangle.h"
 #include "x86.h"
+#include "c_dispatch.h"
+#include <random>
 
-static void SortVertices(const TriDrawTriangleArgs *args, ShadedTriVertex **sortedVertices)
+void ScreenTriangle::SortVertices(const TriDrawTriangleArgs *args, ShadedTriVertex **sortedVertices)
 {
 	sortedVertices[0] = args->v1;
 	sortedVertices[1] = args->v2;
@@ -52,44 +54,15 @@ static void SortVertices(const TriDrawTriangleArgs *args, ShadedTriVertex **sort
 		std::swap(sortedVertices[1], sortedVertices[2]);
 }
 
-void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread)
+void ScreenTriangle::CalculateEdges(ShadedTriVertex **sortedVertices, int topY, int midY, int bottomY, int stepY, int clipleft, int clipright, int16_t *edges)
 {
-	using namespace TriScreenDrawerModes;
-
-	// Sort vertices by Y position
-	ShadedTriVertex *sortedVertices[3];
-	SortVertices(args, sortedVertices);
-
-	int clipleft = 0;
-	int cliptop = MAX(thread->viewport_y, thread->numa_start_y);
-	int clipright = thread->dest_width;
-	int clipbottom = MIN(thread->dest_height, thread->numa_end_y);
-
-	int topY = (int)(sortedVertices[0]->y + 0.5f);
-	int midY = (int)(sortedVertices[1]->y + 0.5f);
-	int bottomY = (int)(sortedVertices[2]->y + 0.5f);
-
-	topY = MAX(topY, cliptop);
-	midY = MIN(midY, clipbottom);
-	bottomY = MIN(bottomY, clipbottom);
-
-	if (topY >= bottomY)
-		return;
-
-	topY += thread->skipped_by_thread(topY);
-	int num_cores = thread->num_cores;
-
-	// Find start/end X positions for each line covered by the triangle:
-
-	int16_t edges[MAXHEIGHT * 2];
-
 	int y = topY;
 
 	float longDX = sortedVertices[2]->x - sortedVertices[0]->x;
 	float longDY = sortedVertices[2]->y - sortedVertices[0]->y;
 	float longStep = longDX / longDY;
 	float longPos = sortedVertices[0]->x + longStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
-	longStep *= num_cores;
+	longStep *= stepY;
 
 	if (y < midY)
 	{
@@ -97,7 +70,7 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadDat
 		float shortDY = sortedVertices[1]->y - sortedVertices[0]->y;
 		float shortStep = shortDX / shortDY;
 		float shortPos = sortedVertices[0]->x + shortStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
-		shortStep *= num_cores;
+		shortStep *= stepY;
 
 		while (y < midY)
 		{
@@ -112,7 +85,7 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadDat
 
 			shortPos += shortStep;
 			longPos += longStep;
-			y += num_cores;
+			y += stepY;
 		}
 	}
 
@@ -122,7 +95,7 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadDat
 		float shortDY = sortedVertices[2]->y - sortedVertices[1]->y;
 		float shortStep = shortDX / shortDY;
 		float shortPos = sortedVertices[1]->x + shortStep * (y + 0.5f - sortedVertices[1]->y) + 0.5f;
-		shortStep *= num_cores;
+		shortStep *= stepY;
 
 		while (y < bottomY)
 		{
@@ -137,9 +110,58 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadDat
 
 			shortPos += shortStep;
 			longPos += longStep;
-			y += num_cores;
+			y += stepY;
 		}
 	}
+}
+
+static void DrawClipped(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int clipleft, int cliptop, int clipright, int clipbottom, bool interleaved);
+
+void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread)
+{
+	int clipleft = 0;
+	int cliptop = MAX(thread->viewport_y, thread->numa_start_y);
+	int clipright = thread->dest_width;
+	int clipbottom = MIN(thread->dest_height, thread->numa_end_y);
+	DrawClipped(args, thread, clipleft, cliptop, clipright, clipbottom, true);
+}
+
+void ScreenTriangle::DrawTile(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int tileLeft, int tileTop, int tileRight, int tileBottom)
+{
+	// The tile belongs to this thread. Draw every line in it.
+	DrawClipped(args, thread, tileLeft, tileTop, tileRight, tileBottom, false);
+}
+
+static void DrawClipped(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int clipleft, int cliptop, int clipright, int clipbottom, bool interleaved)
+{
+	using namespace TriScreenDrawerModes;
+
+	// Sort vertices by Y position
+	ShadedTriVertex *sortedVertices[3];
+	ScreenTriangle::SortVertices(args, sortedVertices);
+
+	int topY = (int)(sortedVertices[0]->y + 0.5f);
+	int midY = (int)(sortedVertices[1]->y + 0.5f);
+	int bottomY = (int)(sortedVertices[2]->y + 0.5f);
+
+	topY = MAX(topY, cliptop);
+	midY = MIN(midY, clipbottom);
+	bottomY = MIN(bottomY, clipbottom);
+
+	if (topY >= bottomY)
+		return;
+
+	int stepY = 1;
+	if (interleaved)
+	{
+		topY += thread->skipped_by_thread(topY);
+		stepY = thread->num_cores;
+	}
+
+	// Find start/end X positions for each line covered by the triangle:
+
+	int16_t edges[MAXHEIGHT * 2];
+	ScreenTriangle::CalculateEdges(sortedVertices, topY, midY, bottomY, stepY, clipleft, clipright, edges);
 
 	int opt = 0;
 	if (args->uniforms->DepthTest()) opt |= SWTRI_DepthTest;
@@ -148,11 +170,145 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadDat
 	if (args->uniforms->WriteDepth()) opt |= SWTRI_WriteDepth;
 	if (args->uniforms->WriteStencil()) opt |= SWTRI_WriteStencil;
 	
-	TriangleDrawers[opt](args, thread, edges, topY, bottomY);
+	ScreenTriangle::TriangleDrawers[opt](args, thread, edges, topY, bottomY, stepY);
+}
+
+bool TriDrawTriangleArgs::CalculateGradients()
+{
+#ifdef NO_SSE
+	return CalculateGradientsScalar();
+#else
+	float bottomX = (v2->x - v3->x) * (v1->y - v3->y) - (v1->x - v3->x) * (v2->y - v3->y);
+	float bottomY = (v1->x - v3->x) * (v2->y - v3->y) - (v2->x - v3->x) * (v1->y - v3->y);
+	if ((bottomX >= -FLT_EPSILON && bottomX <= FLT_EPSILON) || (bottomY >= -FLT_EPSILON && bottomY <= FLT_EPSILON))
+		return false;
+
+	// Same math as CalculateGradientsScalar, but for all varyings at once:
+	// W, U, V and WorldX in the first register and WorldY and WorldZ in the second.
+	__m128 w1 = _mm_set1_ps(v1->w);
+	__m128 w2 = _mm_set1_ps(v2->w);
+	__m128 w3 = _mm_set1_ps(v3->w);
+	__m128 c0a = _mm_mul_ps(_mm_setr_ps(1.0f, v1->u, v1->v, v1->worldX), w1);
+	__m128 c1a = _mm_mul_ps(_mm_setr_ps(1.0f, v2->u, v2->v, v2->worldX), w2);
+	__m128 c2a = _mm_mul_ps(_mm_setr_ps(1.0f, v3->u, v3->v, v3->worldX), w3);
+	__m128 c0b = _mm_mul_ps(_mm_setr_ps(v1->worldY, v1->worldZ, 0.0f, 0.0f), w1);
+	__m128 c1b = _mm_mul_ps(_mm_setr_ps(v2->worldY, v2->worldZ, 0.0f, 0.0f), w2);
+	__m128 c2b = _mm_mul_ps(_mm_setr_ps(v3->worldY, v3->worldZ, 0.0f, 0.0f), w3);
+
+	__m128 dy13 = _mm_set1_ps(v1->y - v3->y);
+	__m128 dy23 = _mm_set1_ps(v2->y - v3->y);
+	__m128 dx13 = _mm_set1_ps(v1->x - v3->x);
+	__m128 dx23 = _mm_set1_ps(v2->x - v3->x);
+	__m128 mbottomX = _mm_set1_ps(bottomX);
+	__m128 mbottomY = _mm_set1_ps(bottomY);
+
+	__m128 d12a = _mm_sub_ps(c1a, c2a);
+	__m128 d02a = _mm_sub_ps(c0a, c2a);
+	__m128 d12b = _mm_sub_ps(c1b, c2b);
+	__m128 d02b = _mm_sub_ps(c0b, c2b);
+
+	__m128 gxa = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(d12a, dy13), _mm_mul_ps(d02a, dy23)), mbottomX);
+	__m128 gxb = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(d12b, dy13), _mm_mul_ps(d02b, dy23)), mbottomX);
+	__m128 gya = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(d12a, dx13), _mm_mul_ps(d02a, dx23)), mbottomY);
+	__m128 gyb = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(d12b, dx13), _mm_mul_ps(d02b, dx23)), mbottomY);
+
+	_mm_storeu_ps(&gradientX.W, gxa);
+	_mm_storel_pi((__m64*)&gradientX.WorldY, gxb);
+	_mm_storeu_ps(&gradientY.W, gya);
+	_mm_storel_pi((__m64*)&gradientY.WorldY, gyb);
+	return true;
+#endif
+}
+
+namespace
+{
+	// Edge function for one triangle edge: E = A * x + B * y + C, positive on the inside.
+	// C is the largest value E reaches in the block at 0,0 grown by one pixel in each direction.
+	struct BlockEdge
+	{
+		float A, B, C;
+	};
+
+	void SetupBlockEdges(const TriDrawTriangleArgs *args, int tileLeft, int tileTop, BlockEdge *edges)
+	{
+		const ShadedTriVertex *v[3] = { args->v1, args->v2, args->v3 };
+		float area = (v[1]->x - v[0]->x) * (v[2]->y - v[0]->y) - (v[1]->y - v[0]->y) * (v[2]->x - v[0]->x);
+		float sign = area < 0.0f ? -1.0f : 1.0f;
+
+		for (int i = 0; i < 3; i++)
+		{
+			const ShadedTriVertex *p = v[i];
+			const ShadedTriVertex *q = v[(i + 1) % 3];
+			float A = (p->y - q->y) * sign;
+			float B = (q->x - p->x) * sign;
+			edges[i].A = A;
+			edges[i].B = B;
+			edges[i].C = A * (tileLeft - 1 - p->x) + B * (tileTop - 1 - p->y) + MAX(A, 0.0f) * 10.0f + MAX(B, 0.0f) * 10.0f;
+		}
+	}
+}
+
+uint64_t ScreenTriangle::BlockCoverageScalar(const TriDrawTriangleArgs *args, int tileLeft, int tileTop)
+{
+	BlockEdge edges[3];
+	SetupBlockEdges(args, tileLeft, tileTop, edges);
+
+	uint64_t mask = 0;
+	for (int blockY = 0; blockY < 8; blockY++)
+	{
+		for (int blockX = 0; blockX < 8; blockX++)
+		{
+			bool covered = true;
+			for (int i = 0; i < 3; i++)
+				covered = covered && (edges[i].C + edges[i].A * (blockX * 8)) + edges[i].B * (blockY * 8) >= 0.0f;
+			if (covered)
+				mask |= (uint64_t)1 << (blockX + blockY * 8);
+		}
+	}
+	return mask;
+}
+
+uint64_t ScreenTriangle::BlockCoverage(const TriDrawTriangleArgs *args, int tileLeft, int tileTop)
+{
+#ifdef NO_SSE
+	return BlockCoverageScalar(args, tileLeft, tileTop);
+#else
+	BlockEdge edges[3];
+	SetupBlockEdges(args, tileLeft, tileTop, edges);
+
+	// Evaluate the edge functions for a row of eight blocks at a time
+	__m128 rowLeft[3], rowRight[3], stepY[3];
+	for (int i = 0; i < 3; i++)
+	{
+		__m128 A = _mm_set1_ps(edges[i].A);
+		__m128 C = _mm_set1_ps(edges[i].C);
+		rowLeft[i] = _mm_add_ps(C, _mm_mul_ps(A, _mm_setr_ps(0.0f, 8.0f, 16.0f, 24.0f)));
+		rowRight[i] = _mm_add_ps(C, _mm_mul_ps(A, _mm_setr_ps(32.0f, 40.0f, 48.0f, 56.0f)));
+		stepY[i] = _mm_set1_ps(edges[i].B);
+	}
+
+	__m128 zero = _mm_setzero_ps();
+	uint64_t mask = 0;
+	for (int blockY = 0; blockY < 8; blockY++)
+	{
+		__m128 offsetY = _mm_set1_ps((float)(blockY * 8));
+		__m128 left = _mm_set1_ps(-1.0f);
+		__m128 right = left;
+		for (int i = 0; i < 3; i++)
+		{
+			__m128 dy = _mm_mul_ps(stepY[i], offsetY);
+			left = _mm_and_ps(left, _mm_cmpge_ps(_mm_add_ps(rowLeft[i], dy), zero));
+			right = _mm_and_ps(right, _mm_cmpge_ps(_mm_add_ps(rowRight[i], dy), zero));
+		}
+		uint64_t bits = _mm_movemask_ps(left) | (_mm_movemask_ps(right) << 4);
+		mask |= bits << (blockY * 8);
+	}
+	return mask;
+#endif
 }
 
 template<typename OptT>
-void DrawTriangle(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int16_t *edges, int topY, int bottomY)
+void DrawTriangle(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int16_t *edges, int topY, int bottomY, int stepY)
 {
 	using namespace TriScreenDrawerModes;
 
@@ -200,8 +356,7 @@ void DrawTriangle(const TriDrawTriangleArgs *args, PolyTriangleThreadData *threa
 		weaponWOffset = thread->weaponScene ? 1.0f : 0.0f;
 	}
 
-	int num_cores = thread->num_cores;
-	for (int y = topY; y < bottomY; y += num_cores)
+	for (int y = topY; y < bottomY; y += stepY)
 	{
 		int x = edges[y << 1];
 		int xend = edges[(y << 1) + 1];
@@ -2244,7 +2399,7 @@ void(*ScreenTriangle::RectDrawers32[])(const void *, int, int, int, const RectDr
 	&DrawRect32<TriScreenDrawerModes::StyleAddShadedTranslated>
 };
 
-void(*ScreenTriangle::TriangleDrawers[])(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int16_t *edges, int topY, int bottomY) =
+void(*ScreenTriangle::TriangleDrawers[])(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int16_t *edges, int topY, int bottomY, int stepY) =
 {
 	nullptr,
 	nullptr,
@@ -2281,3 +2436,97 @@ void(*ScreenTriangle::TriangleDrawers[])(const TriDrawTriangleArgs *args, PolyTr
 };
 
 int ScreenTriangle::FuzzStart = 0;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Compares the vectorized triangle setup and block coverage against the scalar versions
+CCMD(poly_testsetup)
+{
+	int count = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 100000;
+
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> position(0.0f, 192.0f);
+	std::uniform_real_distribution<float> varying(-128.0f, 128.0f);
+	std::uniform_real_distribution<float> depth(0.01f, 1.0f);
+
+	// The tested tile is at 64,64. The triangles are spread out around it.
+	const int tileLeft = 64;
+	const int tileTop = 64;
+
+	int gradientMismatches = 0;
+	int coverageMismatches = 0;
+	int uncoveredPixels = 0;
+	int tested = 0;
+	int16_t edges[192 * 2];
+
+	for (int i = 0; i < count; i++)
+	{
+		ShadedTriVertex v[3];
+		memset(v, 0, sizeof(v));
+		for (int j = 0; j < 3; j++)
+		{
+			v[j].x = position(generator);
+			v[j].y = position(generator);
+			v[j].w = depth(generator);
+			v[j].u = varying(generator);
+			v[j].v = varying(generator);
+			v[j].worldX = varying(generator);
+			v[j].worldY = varying(generator);
+			v[j].worldZ = varying(generator);
+		}
+
+		TriDrawTriangleArgs args, reference;
+		args.v1 = &v[0];
+		args.v2 = &v[1];
+		args.v3 = &v[2];
+		args.uniforms = nullptr;
+		reference = args;
+
+		bool result = args.CalculateGradients();
+		if (result != reference.CalculateGradientsScalar())
+		{
+			gradientMismatches++;
+			continue;
+		}
+		if (!result)
+			continue;
+
+		tested++;
+		const float *a = &args.gradientX.W;
+		const float *b = &reference.gradientX.W;
+		for (int j = 0; j < 6; j++)
+		{
+			if (a[j] != b[j] || (&args.gradientY.W)[j] != (&reference.gradientY.W)[j])
+			{
+				gradientMismatches++;
+				break;
+			}
+		}
+
+		uint64_t mask = ScreenTriangle::BlockCoverage(&args, tileLeft, tileTop);
+		if (mask != ScreenTriangle::BlockCoverageScalar(&args, tileLeft, tileTop))
+			coverageMismatches++;
+
+		// Every pixel the scanline rasterizer draws in the tile must be in a covered block
+		ShadedTriVertex *sortedVertices[3];
+		ScreenTriangle::SortVertices(&args, sortedVertices);
+		int topY = MAX((int)(sortedVertices[0]->y + 0.5f), tileTop);
+		int midY = MIN((int)(sortedVertices[1]->y + 0.5f), tileTop + 64);
+		int bottomY = MIN((int)(sortedVertices[2]->y + 0.5f), tileTop + 64);
+		if (topY >= bottomY)
+			continue;
+
+		ScreenTriangle::CalculateEdges(sortedVertices, topY, midY, bottomY, 1, tileLeft, tileLeft + 64, edges);
+		for (int y = topY; y < bottomY; y++)
+		{
+			for (int x = edges[y << 1]; x < edges[(y << 1) + 1]; x++)
+			{
+				int block = ((x - tileLeft) >> 3) + ((y - tileTop) >> 3) * 8;
+				if (!(mask & ((uint64_t)1 << block)))
+					uncoveredPixels++;
+			}
+		}
+	}
+
+	Printf("%d triangles tested: %d gradient mismatches, %d block coverage mismatches, %d pixels outside the covered blocks\n", tested, gradientMismatches, coverageMismatches, uncoveredPixels);
+}
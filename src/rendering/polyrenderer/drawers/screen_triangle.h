@@ -52,7 +52,11 @@ struct TriDrawTriangleArgs
 	ScreenTriangleStepVariables gradientX;
 	ScreenTriangleStepVariables gradientY;
 
-	bool CalculateGradients()
+	// Calculates the screen space gradients of all varyings. Uses SSE when available.
+	bool CalculateGradients();
+
+	// Reference version with one varying at a time
+	bool CalculateGradientsScalar()
 	{
 		float bottomX = (v2->x - v3->x) * (v1->y - v3->y) - (v1->x - v3->x) * (v2->y - v3->y);
 		float bottomY = (v1->x - v3->x) * (v2->y - v3->y) - (v2->x - v3->x) * (v1->y - v3->y);
@@ -132,8 +136,17 @@ class ScreenTriangle
 {
 public:
 	static void Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread);
+	static void DrawTile(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int tileLeft, int tileTop, int tileRight, int tileBottom);
+
+	// Returns a bit for each 8x8 block in the 64x64 tile at tileLeft, tileTop (bit = blockX + blockY * 8) that the triangle may cover
+	static uint64_t BlockCoverage(const TriDrawTriangleArgs *args, int tileLeft, int tileTop);
+	static uint64_t BlockCoverageScalar(const TriDrawTriangleArgs *args, int tileLeft, int tileTop);
+
+	// Calculates the start and end X position of each line covered by the triangle
+	static void CalculateEdges(ShadedTriVertex **sortedVertices, int topY, int midY, int bottomY, int stepY, int clipleft, int clipright, int16_t *edges);
+	static void SortVertices(const TriDrawTriangleArgs *args, ShadedTriVertex **sortedVertices);
 
-	static void(*TriangleDrawers[])(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int16_t *edges, int topY, int bottomY);
+	static void(*TriangleDrawers[])(const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread, int16_t *edges, int topY, int bottomY, int stepY);
 
 	static void(*SpanDrawers8[])(int y, int x0, int x1, const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread);
 	static void(*SpanDrawers32[])(int y, int x0, int x1, const TriDrawTriangleArgs *args, PolyTriangleThreadData *thread);
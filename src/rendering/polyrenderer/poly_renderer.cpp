@@ -45,6 +45,8 @@ EXTERN_CVAR(Int, screenblocks)
 EXTERN_CVAR(Float, r_visibility)
 EXTERN_CVAR(Bool, r_models)
 
+CVAR(Bool, r_polybinning, false, 0)
+
 extern bool r_modelscene;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -175,10 +177,19 @@ void PolyRenderer::RenderActorView(AActor *actor, bool drawpsprites, bool dontma
 	PolyTriangleDrawer::ClearStencil(Threads.MainThread()->DrawQueue, 0);
 	SetSceneViewport();
 
+	// Bin the scene triangles into tiles. The player sprites use the rect drawers, which only know about line ownership.
+	bool binning = r_polybinning;
+	if (binning)
+		PolyTriangleDrawer::SetBinning(Threads.MainThread()->DrawQueue, true);
+
 	PolyPortalViewpoint mainViewpoint = SetupPerspectiveMatrix();
 	mainViewpoint.StencilValue = GetNextStencilValue();
 	Scene.CurrentViewpoint = &mainViewpoint;
 	Scene.Render(&mainViewpoint);
+
+	if (binning)
+		PolyTriangleDrawer::SetBinning(Threads.MainThread()->DrawQueue, false);
+
 	if (drawpsprites)
 		PlayerSprites.Render(Threads.MainThread());
 
@@ -264,8 +264,13 @@ DrawerCommandQueue::DrawerCommandQueue(RenderMemory *frameMemory) : FrameMemory(
 {
 }
 
+DrawerCommandQueue::DrawerCommandQueue(DrawerThread *immediateThread) : ImmediateThread(immediateThread)
+{
+}
+
 void *DrawerCommandQueue::AllocMemory(size_t size)
 {
+	RenderMemoryCategory category(FrameMemory, RenderMemory::Drawers);
 	return FrameMemory->AllocMemory<uint8_t>((int)size);
 }
 
@@ -33,6 +33,7 @@
 EXTERN_CVAR(Int, r_multithreaded)
 
 class PolyTriangleThreadData;
+namespace swrenderer { class FlatPlaneThreadRenderer; class SlopePlaneThreadRenderer; }
 
 // Worker data for each thread executing drawer commands
 class DrawerThread
@@ -61,6 +62,8 @@ public:
 	const uint8_t *tiltlighting[MAXWIDTH];
 
 	std::shared_ptr<PolyTriangleThreadData> poly;
+	std::shared_ptr<swrenderer::FlatPlaneThreadRenderer> flatplanes;
+	std::shared_ptr<swrenderer::SlopePlaneThreadRenderer> slopeplanes;
 
 	size_t debug_draw_pos = 0;
 
@@ -187,6 +190,9 @@ class DrawerCommandQueue
 {
 public:
 	DrawerCommandQueue(RenderMemory *memoryAllocator);
+
+	// Queue that executes its commands right away on the given thread. Used by commands that issue other commands.
+	DrawerCommandQueue(DrawerThread *immediateThread);
 	
 	void Clear() { commands.clear(); }
 	
@@ -195,7 +201,12 @@ public:
 	void Push(Types &&... args)
 	{
 		DrawerThreads *threads = DrawerThreads::Instance();
-		if (r_multithreaded != 0)
+		if (ImmediateThread)
+		{
+			T command(std::forward<Types>(args)...);
+			command.Execute(ImmediateThread);
+		}
+		else if (r_multithreaded != 0)
 		{
 			void *ptr = AllocMemory(sizeof(T));
 			T *command = new (ptr)T(std::forward<Types>(args)...);
@@ -213,7 +224,8 @@ private:
 	void *AllocMemory(size_t size);
 	
 	std::vector<DrawerCommand *> commands;
-	RenderMemory *FrameMemory;
+	RenderMemory *FrameMemory = nullptr;
+	DrawerThread *ImmediateThread = nullptr;
 	
 	friend class DrawerThreads;
 };
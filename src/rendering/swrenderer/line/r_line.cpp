@@ -55,6 +55,7 @@
 #include "swrenderer/drawers/r_draw.h"
 #include "swrenderer/segments/r_clipsegment.h"
 #include "swrenderer/segments/r_drawsegment.h"
+#include "swrenderer/segments/r_hizbuffer.h"
 #include "swrenderer/plane/r_visibleplane.h"
 #include "swrenderer/plane/r_visibleplanelist.h"
 #include "swrenderer/things/r_decal.h"
@@ -301,6 +302,8 @@ namespace swrenderer
 	// A wall segment will be drawn between start and stop pixels (inclusive).
 	bool SWRenderLine::RenderWallSegment(int start, int stop)
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Walls);
+
 		int i;
 		bool maskedtexture = false;
 
@@ -502,6 +505,7 @@ namespace swrenderer
 		}
 
 		MarkOpaquePassClip(start, stop);
+		Thread->HiZ->MarkWall(Thread, start, stop, WallC);
 
 		// save sprite clipping info
 		if (((draw_segment->silhouette & SIL_TOP) || maskedtexture) && draw_segment->sprtopclip == nullptr)
@@ -338,6 +338,8 @@ namespace swrenderer
 
 	void RenderWallPart::SetLights(WallDrawerArgs &drawerargs, int x, int y1)
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Walls);
+
 		bool mirror = !!(Thread->Portal->MirrorFlags & RF_XFLIP);
 		int tx = x;
 		if (mirror)
@@ -42,6 +42,7 @@
 #include "v_palette.h"
 #include "r_data/colormaps.h"
 #include "swrenderer/drawers/r_draw_rgba.h"
+#include "swrenderer/drawers/r_draw_pal.h"
 #include "a_dynlight.h"
 #include "swrenderer/segments/r_clipsegment.h"
 #include "swrenderer/segments/r_drawsegment.h"
@@ -53,6 +54,8 @@
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
 
+CVAR(Bool, r_planejobs, true, 0)
+
 namespace swrenderer
 {
 	RenderFlatPlane::RenderFlatPlane(RenderThread *thread)
@@ -67,14 +70,18 @@ namespace swrenderer
 			return;
 		}
 
-		tex = texture;
+		SpanDrawerArgs &drawerargs = setup.drawerargs;
 
 		drawerargs.SetSolidColor(3);
 		drawerargs.SetTexture(Thread, texture);
 
+		setup.texwidth = texture->GetWidth();
+		setup.texheight = texture->GetHeight();
+
 		double planeang = (pl->xform.Angle + pl->xform.baseAngle).Radians();
 		double xstep, ystep, leftxfrac, leftyfrac, rightxfrac, rightyfrac;
 		double x;
+		double pviewx, pviewy;
 
 		if (planeang != 0)
 		{
@@ -88,8 +95,8 @@ namespace swrenderer
 			pviewy = pl->xform.yOffs - Thread->Viewport->viewpoint.Pos.Y;
 		}
 
-		pviewx = _xscale * pviewx;
-		pviewy = _yscale * pviewy;
+		setup.pviewx = _xscale * pviewx;
+		setup.pviewy = _yscale * pviewy;
 
 		// left to right mapping
 		planeang += (Thread->Viewport->viewpoint.Angles.Yaw - 90).Radians();
@@ -117,40 +124,70 @@ namespace swrenderer
 		leftxfrac = _xscale * (cosine + x * xstep);
 		leftyfrac = _yscale * (sine + x * ystep);
 
-		basexfrac = leftxfrac;
-		baseyfrac = leftyfrac;
+		setup.basexfrac = leftxfrac;
+		setup.baseyfrac = leftyfrac;
 		if (pl->left != pl->right)
 		{
-			xstepscale = (rightxfrac - leftxfrac) / (pl->right - pl->left);
-			ystepscale = (rightyfrac - leftyfrac) / (pl->right - pl->left);
+			setup.xstepscale = (rightxfrac - leftxfrac) / (pl->right - pl->left);
+			setup.ystepscale = (rightyfrac - leftyfrac) / (pl->right - pl->left);
 		}
 		else
 		{
-			xstepscale = 0;
-			ystepscale = 0;
+			setup.xstepscale = 0;
+			setup.ystepscale = 0;
 		}
 
-		minx = pl->left;
+		setup.minx = pl->left;
 
-		planeheight = fabs(pl->height.Zat0() - Thread->Viewport->viewpoint.Pos.Z);
+		setup.planeheight = fabs(pl->height.Zat0() - Thread->Viewport->viewpoint.Pos.Z);
 
 		// [RH] set foggy flag
 		auto Level = Thread->Viewport->Level();
-		foggy = (Level->fadeto || colormap->Fade || (Level->flags & LEVEL_HASFADETABLE));
-		lightlevel = pl->lightlevel;
+		bool foggy = (Level->fadeto || colormap->Fade || (Level->flags & LEVEL_HASFADETABLE));
 
 		CameraLight *cameraLight = CameraLight::Instance();
-		plane_shade = cameraLight->FixedLightLevel() < 0 && !cameraLight->FixedColormap();
+		setup.plane_shade = cameraLight->FixedLightLevel() < 0 && !cameraLight->FixedColormap();
+		if (setup.plane_shade)
+		{
+			setup.planeshade = LightVisibility::LightLevelToShade(pl->lightlevel, foggy, viewport);
+			setup.planevis = Thread->Light->FlatPlaneVisScale(setup.planeheight, foggy);
+		}
 
 		drawerargs.SetStyle(masked, additive, alpha, colormap);
 
-		light_list = pl->lights;
-
-		RenderLines(pl);
+		setup.light_list = pl->lights;
+
+		setup.viewport = viewport;
+		setup.CenterX = viewport->CenterX;
+		setup.CenterY = viewport->CenterY;
+		setup.InvZtoScale = viewport->InvZtoScale;
+		setup.FocalLengthX = viewport->FocalLengthX;
+		setup.FocalLengthY = viewport->FocalLengthY;
+		setup.ViewPos = viewport->viewpoint.Pos;
+		setup.ViewSin = viewport->viewpoint.Sin;
+		setup.ViewCos = viewport->viewpoint.Cos;
+		setup.ViewTanSin = viewport->viewpoint.TanSin;
+		setup.ViewTanCos = viewport->viewpoint.TanCos;
+		setup.mirror = !!(renderportal->MirrorFlags & RF_XFLIP);
+		setup.bgra = viewport->RenderTarget->IsBgra();
+		setup.width = viewwidth;
+
+		if (r_planejobs && r_multithreaded != 0 && pl->left < pl->right)
+		{
+			const uint16_t *top, *bottom;
+			CopyOutline(Thread, pl, top, bottom);
+			Thread->PlaneQueue->Push<DrawFlatPlaneCommand>(setup, pl->left, pl->right, top, bottom);
+		}
+		else
+		{
+			RenderLines(pl);
+		}
 	}
 
 	void RenderFlatPlane::RenderLine(int y, int x1, int x2)
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Planes);
+
 #ifdef RANGECHECK
 		if (x2 < x1 || x1<0 || x2 >= viewwidth || (unsigned)y >= (unsigned)viewheight)
 		{
@@ -158,26 +195,50 @@ namespace swrenderer
 		}
 #endif
 
-		auto viewport = Thread->Viewport.get();
+		DrawerLight *lights = r_dynlights ? Thread->FrameMemory->AllocMemory<DrawerLight>(setup.CountLights()) : nullptr;
+		setup.SetupLine(y, x1, x2, lights);
+
+		setup.drawerargs.DrawSpan(Thread);
+		if (r_modelscene)
+			setup.drawerargs.DrawDepthSpan(Thread, setup.zbufferdepth, setup.zbufferdepth);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	int FlatPlaneSetup::CountLights() const
+	{
+		// Calculate max lights that can touch the row so we can allocate memory for the list
+		int max_lights = 0;
+		VisiblePlaneLight *cur_node = light_list;
+		while (cur_node)
+		{
+			if (cur_node->lightsource->IsActive())
+				max_lights++;
+			cur_node = cur_node->next;
+		}
+		return max_lights;
+	}
 
+	void FlatPlaneSetup::SetupLine(int y, int x1, int x2, DrawerLight *lights)
+	{
 		double curxfrac = basexfrac + xstepscale * (x1 - minx);
 		double curyfrac = baseyfrac + ystepscale * (x1 - minx);
 
-		double distance = viewport->PlaneDepth(y, planeheight);
+		double distance = (y + 0.5 < CenterY) ? FocalLengthY / (CenterY - y - 0.5) * planeheight : FocalLengthY / (y + 0.5 - CenterY) * planeheight;
 
-		float zbufferdepth = (float)(1.0 / fabs(planeheight / Thread->Viewport->ScreenToViewY(y, 1.0)));
+		zbufferdepth = (float)(1.0 / fabs(planeheight / ((CenterY - y - 0.5) / FocalLengthY)));
 
-		drawerargs.SetTextureUStep(distance * xstepscale / tex->GetWidth());
-		drawerargs.SetTextureUPos((distance * curxfrac + pviewx) / tex->GetWidth());
+		drawerargs.SetTextureUStep(distance * xstepscale / texwidth);
+		drawerargs.SetTextureUPos((distance * curxfrac + pviewx) / texwidth);
 
-		drawerargs.SetTextureVStep(distance * ystepscale / tex->GetHeight());
-		drawerargs.SetTextureVPos((distance * curyfrac + pviewy) / tex->GetHeight());
+		drawerargs.SetTextureVStep(distance * ystepscale / texheight);
+		drawerargs.SetTextureVPos((distance * curyfrac + pviewy) / texheight);
 		
-		if (viewport->RenderTarget->IsBgra())
+		if (bgra)
 		{
-			double distance2 = viewport->PlaneDepth(y + 1, planeheight);
-			double xmagnitude = fabs(ystepscale * (distance2 - distance) * viewport->FocalLengthX);
-			double ymagnitude = fabs(xstepscale * (distance2 - distance) * viewport->FocalLengthX);
+			double distance2 = (y + 1.5 < CenterY) ? FocalLengthY / (CenterY - y - 1.5) * planeheight : FocalLengthY / (y + 1.5 - CenterY) * planeheight;
+			double xmagnitude = fabs(ystepscale * (distance2 - distance) * FocalLengthX);
+			double ymagnitude = fabs(xstepscale * (distance2 - distance) * FocalLengthX);
 			double magnitude = MAX(ymagnitude, xmagnitude);
 			double min_lod = -1000.0;
 			drawerargs.SetTextureLOD(MAX(log2(magnitude) + r_lod_bias, min_lod));
@@ -186,22 +247,21 @@ namespace swrenderer
 		if (plane_shade)
 		{
 			// Determine lighting based on the span's distance from the viewer.
-			drawerargs.SetLight((float)Thread->Light->FlatPlaneVis(y, planeheight, foggy, viewport), lightlevel, foggy, viewport);
+			drawerargs.SetLight((float)(planevis * fabs(CenterY - y)), planeshade);
 		}
 
-		if (r_dynlights)
+		if (lights)
 		{
 			int tx = x1;
-			bool mirror = !!(Thread->Portal->MirrorFlags & RF_XFLIP);
 			if (mirror)
-				tx = viewwidth - tx - 1;
+				tx = width - tx - 1;
 
 			// Find row position in view space
-			float zspan = (float)(planeheight / (fabs(y + 0.5 - viewport->CenterY) / viewport->InvZtoScale));
-			drawerargs.dc_viewpos.X = (float)((tx + 0.5 - viewport->CenterX) / viewport->CenterX * zspan);
+			float zspan = (float)(planeheight / (fabs(y + 0.5 - CenterY) / InvZtoScale));
+			drawerargs.dc_viewpos.X = (float)((tx + 0.5 - CenterX) / CenterX * zspan);
 			drawerargs.dc_viewpos.Y = zspan;
-			drawerargs.dc_viewpos.Z = (float)((viewport->CenterY - y - 0.5) / viewport->InvZtoScale * zspan);
-			drawerargs.dc_viewpos_step.X = (float)(zspan / viewport->CenterX);
+			drawerargs.dc_viewpos.Z = (float)((CenterY - y - 0.5) / InvZtoScale * zspan);
+			drawerargs.dc_viewpos_step.X = (float)(zspan / CenterX);
 
 			if (mirror)
 				drawerargs.dc_viewpos_step.X = -drawerargs.dc_viewpos_step.X;
@@ -209,31 +269,21 @@ namespace swrenderer
 			// Plane normal
 			drawerargs.dc_normal.X = 0.0f;
 			drawerargs.dc_normal.Y = 0.0f;
-			drawerargs.dc_normal.Z = (y >= viewport->CenterY) ? 1.0f : -1.0f;
-
-			// Calculate max lights that can touch the row so we can allocate memory for the list
-			int max_lights = 0;
-			VisiblePlaneLight *cur_node = light_list;
-			while (cur_node)
-			{
-				if (cur_node->lightsource->IsActive())
-					max_lights++;
-				cur_node = cur_node->next;
-			}
+			drawerargs.dc_normal.Z = (y >= CenterY) ? 1.0f : -1.0f;
 
 			drawerargs.dc_num_lights = 0;
-			drawerargs.dc_lights = Thread->FrameMemory->AllocMemory<DrawerLight>(max_lights);
+			drawerargs.dc_lights = lights;
 
 			// Setup lights for row
-			cur_node = light_list;
+			VisiblePlaneLight *cur_node = light_list;
 			while (cur_node)
 			{
-				double lightX = cur_node->lightsource->X() - Thread->Viewport->viewpoint.Pos.X;
-				double lightY = cur_node->lightsource->Y() - Thread->Viewport->viewpoint.Pos.Y;
-				double lightZ = cur_node->lightsource->Z() - Thread->Viewport->viewpoint.Pos.Z;
+				double lightX = cur_node->lightsource->X() - ViewPos.X;
+				double lightY = cur_node->lightsource->Y() - ViewPos.Y;
+				double lightZ = cur_node->lightsource->Z() - ViewPos.Z;
 
-				float lx = (float)(lightX * Thread->Viewport->viewpoint.Sin - lightY * Thread->Viewport->viewpoint.Cos);
-				float ly = (float)(lightX * Thread->Viewport->viewpoint.TanCos + lightY * Thread->Viewport->viewpoint.TanSin) - drawerargs.dc_viewpos.Y;
+				float lx = (float)(lightX * ViewSin - lightY * ViewCos);
+				float ly = (float)(lightX * ViewTanCos + lightY * ViewTanSin) - drawerargs.dc_viewpos.Y;
 				float lz = (float)lightZ - drawerargs.dc_viewpos.Z;
 
 				// Precalculate the constant part of the dot here so the drawer doesn't have to.
@@ -268,10 +318,59 @@ namespace swrenderer
 		drawerargs.SetDestY(viewport, y);
 		drawerargs.SetDestX1(x1);
 		drawerargs.SetDestX2(x2);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	DrawFlatPlaneCommand::DrawFlatPlaneCommand(const FlatPlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom)
+		: setup(setup), left(left), right(right), top(top), bottom(bottom)
+	{
+	}
+
+	void DrawFlatPlaneCommand::Execute(DrawerThread *thread)
+	{
+		FlatPlaneThreadRenderer::Get(thread)->Render(setup, left, right, top, bottom);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	FlatPlaneThreadRenderer::FlatPlaneThreadRenderer(DrawerThread *thread) : Thread(thread)
+	{
+		Queue = std::make_shared<DrawerCommandQueue>(thread);
+		PalDrawers.reset(new SWPalDrawers(Queue));
+		TrueColorDrawers.reset(new SWTruecolorDrawers(Queue));
+	}
+
+	FlatPlaneThreadRenderer *FlatPlaneThreadRenderer::Get(DrawerThread *thread)
+	{
+		if (!thread->flatplanes)
+			thread->flatplanes = std::make_shared<FlatPlaneThreadRenderer>(thread);
+		return thread->flatplanes.get();
+	}
+
+	void FlatPlaneThreadRenderer::Render(const FlatPlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom)
+	{
+		Setup = setup;
+		RenderLines(left, right, top, bottom);
+	}
+
+	void FlatPlaneThreadRenderer::RenderLine(int y, int x1, int x2)
+	{
+		if (Thread->line_skipped_by_thread(y))
+			return;
+
+		DrawerLight *lights = nullptr;
+		if (r_dynlights)
+		{
+			Lights.resize(MAX(Setup.CountLights(), 1));
+			lights = Lights.data();
+		}
+		Setup.SetupLine(y, x1, x2, lights);
 
-		drawerargs.DrawSpan(Thread);
+		SWPixelFormatDrawers *drawers = Setup.bgra ? TrueColorDrawers.get() : PalDrawers.get();
+		Setup.drawerargs.DrawSpan(drawers);
 		if (r_modelscene)
-			drawerargs.DrawDepthSpan(Thread, zbufferdepth, zbufferdepth);
+			Setup.drawerargs.DrawDepthSpan(drawers, Setup.zbufferdepth, Setup.zbufferdepth);
 	}
 
 	/////////////////////////////////////////////////////////////////////////
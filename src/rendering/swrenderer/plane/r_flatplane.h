@@ -24,12 +24,45 @@
 
 #include "r_planerenderer.h"
 #include "swrenderer/viewport/r_spandrawer.h"
+#include "swrenderer/drawers/r_thread.h"
 
 namespace swrenderer
 {
 	class RenderThread;
 	struct VisiblePlaneLight;
 
+	// Per plane constants needed to set up its spans. Everything taken from the
+	// viewport is copied so that the spans can also be set up on a drawer thread.
+	struct FlatPlaneSetup
+	{
+		void SetupLine(int y, int x1, int x2, DrawerLight *lights);
+		int CountLights() const;
+
+		int minx;
+		double planeheight;
+		bool plane_shade;
+		int planeshade;
+		double planevis;
+		double pviewx, pviewy;
+		double xstepscale, ystepscale;
+		double basexfrac, baseyfrac;
+		double texwidth, texheight;
+		VisiblePlaneLight *light_list;
+
+		RenderViewport *viewport;
+		double CenterX, CenterY;
+		double InvZtoScale;
+		double FocalLengthX, FocalLengthY;
+		DVector3 ViewPos;
+		double ViewSin, ViewCos, ViewTanSin, ViewTanCos;
+		bool mirror;
+		bool bgra;
+		int width;
+
+		float zbufferdepth;
+		SpanDrawerArgs drawerargs;
+	};
+
 	class RenderFlatPlane : PlaneRenderer
 	{
 	public:
@@ -41,18 +74,45 @@ namespace swrenderer
 	private:
 		void RenderLine(int y, int x1, int x2) override;
 
-		int minx;
-		double planeheight;
-		bool plane_shade;
-		int lightlevel;
-		bool foggy;
-		double pviewx, pviewy;
-		double xstepscale, ystepscale;
-		double basexfrac, baseyfrac;
-		VisiblePlaneLight *light_list;
-		FSoftwareTexture *tex;
+		FlatPlaneSetup setup;
+	};
+
+	// Sets up and draws the spans of a flat plane on the drawer threads. Each thread only does the rows it owns.
+	class DrawFlatPlaneCommand : public DrawerCommand
+	{
+	public:
+		DrawFlatPlaneCommand(const FlatPlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom);
+		void Execute(DrawerThread *thread) override;
+
+	private:
+		const FlatPlaneSetup setup;
+		const int left;
+		const int right;
+		const uint16_t *const top;
+		const uint16_t *const bottom;
+	};
+
+	// Span renderer owned by each drawer thread. It works on its own copy of the setup,
+	// since SetupLine writes the drawer arguments and every drawer thread runs the same command.
+	class FlatPlaneThreadRenderer : PlaneRenderer
+	{
+	public:
+		FlatPlaneThreadRenderer(DrawerThread *thread);
+
+		static FlatPlaneThreadRenderer *Get(DrawerThread *thread);
+
+		void Render(const FlatPlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom);
+
+	private:
+		void RenderLine(int y, int x1, int x2) override;
+
+		DrawerThread *Thread;
+		FlatPlaneSetup Setup;
+		DrawerCommandQueuePtr Queue;
+		std::unique_ptr<SWPixelFormatDrawers> PalDrawers;
+		std::unique_ptr<SWPixelFormatDrawers> TrueColorDrawers;
+		std::vector<DrawerLight> Lights;
 
-		SpanDrawerArgs drawerargs;
 	};
 
 	class RenderColoredPlane : PlaneRenderer
@@ -39,28 +39,47 @@
 #include "a_dynlight.h"
 #include "swrenderer/plane/r_visibleplane.h"
 #include "swrenderer/plane/r_planerenderer.h"
+#include "swrenderer/r_memory.h"
+#include "swrenderer/r_renderthread.h"
 
 namespace swrenderer
 {
 	void PlaneRenderer::RenderLines(VisiblePlane *pl)
+	{
+		RenderLines(pl->left, pl->right, pl->top + pl->left, pl->bottom + pl->left);
+	}
+
+	void PlaneRenderer::CopyOutline(RenderThread *thread, VisiblePlane *pl, const uint16_t *&top, const uint16_t *&bottom)
+	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Planes);
+		int count = pl->right - pl->left;
+		uint16_t *t = thread->FrameMemory->AllocMemory<uint16_t>(count);
+		uint16_t *b = thread->FrameMemory->AllocMemory<uint16_t>(count);
+		memcpy(t, pl->top + pl->left, count * sizeof(uint16_t));
+		memcpy(b, pl->bottom + pl->left, count * sizeof(uint16_t));
+		top = t;
+		bottom = b;
+	}
+
+	void PlaneRenderer::RenderLines(int left, int right, const uint16_t *top, const uint16_t *bottom)
 	{
 		// t1/b1 are at x
 		// t2/b2 are at x+1
 		// spanend[y] is at the right edge
 
-		int x = pl->right - 1;
-		int t2 = pl->top[x];
-		int b2 = pl->bottom[x];
+		int x = right - 1;
+		int t2 = top[x - left];
+		int b2 = bottom[x - left];
 
 		if (b2 > t2)
 		{
 			fillshort(spanend + t2, b2 - t2, x);
 		}
 
-		for (--x; x >= pl->left; --x)
+		for (--x; x >= left; --x)
 		{
-			int t1 = pl->top[x];
-			int b1 = pl->bottom[x];
+			int t1 = top[x - left];
+			int b1 = bottom[x - left];
 			const int xr = x + 1;
 			int stop;
 
@@ -92,15 +111,15 @@ namespace swrenderer
 				spanend[--b1] = x;
 			}
 
-			t2 = pl->top[x];
-			b2 = pl->bottom[x];
+			t2 = top[x - left];
+			b2 = bottom[x - left];
 		}
 		// Draw any spans that are still open
 		while (t2 < b2)
 		{
 			int y = --b2;
 			int x2 = spanend[y];
-			RenderLine(y, pl->left, x2);
+			RenderLine(y, left, x2);
 		}
 	}
 }
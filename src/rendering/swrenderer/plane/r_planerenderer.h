@@ -28,14 +28,21 @@
 namespace swrenderer
 {
 	struct VisiblePlane;
+	class RenderThread;
 
 	class PlaneRenderer
 	{
 	public:
 		void RenderLines(VisiblePlane *pl);
 
+		// Renders the outline given by top and bottom, where index 0 is the left column
+		void RenderLines(int left, int right, const uint16_t *top, const uint16_t *bottom);
+
 		virtual void RenderLine(int y, int x1, int x2) = 0;
 
+		// Copies the outline of a plane to frame memory for a plane job. Visplanes may be reused once rendered.
+		static void CopyOutline(RenderThread *thread, VisiblePlane *pl, const uint16_t *&top, const uint16_t *&bottom);
+
 	private:
 		short spanend[MAXHEIGHT];
 	};
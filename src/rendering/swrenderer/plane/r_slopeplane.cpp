@@ -42,6 +42,7 @@
 #include "v_palette.h"
 #include "r_data/colormaps.h"
 #include "swrenderer/drawers/r_draw_rgba.h"
+#include "swrenderer/drawers/r_draw_pal.h"
 #include "a_dynlight.h"
 #include "swrenderer/segments/r_clipsegment.h"
 #include "swrenderer/segments/r_drawsegment.h"
@@ -57,6 +58,8 @@
 #pragma warning(disable:4244)
 #endif
 
+EXTERN_CVAR(Bool, r_planejobs)
+
 namespace swrenderer
 {
 	RenderSlopePlane::RenderSlopePlane(RenderThread *thread)
@@ -80,6 +83,9 @@ namespace swrenderer
 		FVector3 p, m, n;
 		double ang, planeang, cosine, sine;
 		double zeroheight;
+		fixed_t pviewx, pviewy;
+		FVector3 &plane_sz = setup.plane_sz, &plane_su = setup.plane_su, &plane_sv = setup.plane_sv;
+		SpanDrawerArgs &drawerargs = setup.drawerargs;
 
 		if (alpha <= 0)
 		{
@@ -89,10 +95,11 @@ namespace swrenderer
 		auto viewport = Thread->Viewport.get();
 
 		DVector3 worldNormal = pl->height.Normal();
+		DVector3 &planeNormal = setup.planeNormal;
 		planeNormal.X = worldNormal.X * viewport->viewpoint.Sin - worldNormal.Y * viewport->viewpoint.Cos;
 		planeNormal.Y = worldNormal.X * viewport->viewpoint.Cos + worldNormal.Y * viewport->viewpoint.Sin;
 		planeNormal.Z = worldNormal.Z;
-		planeD = -planeNormal.Z * (pl->height.ZatPoint(viewport->viewpoint.Pos.X, viewport->viewpoint.Pos.Y) - viewport->viewpoint.Pos.Z);
+		setup.planeD = -planeNormal.Z * (pl->height.ZatPoint(viewport->viewpoint.Pos.X, viewport->viewpoint.Pos.Y) - viewport->viewpoint.Pos.Z);
 
 
 		drawerargs.SetSolidColor(3);
@@ -173,21 +180,30 @@ namespace swrenderer
 		}
 
 		// [RH] set foggy flag
-		basecolormap = colormap;
+		setup.basecolormap = colormap;
 		auto Level = viewport->Level();
-		foggy = Level->fadeto || basecolormap->Fade || (Level->flags & LEVEL_HASFADETABLE);
+		bool foggy = Level->fadeto || colormap->Fade || (Level->flags & LEVEL_HASFADETABLE);
 
-		planelightfloat = (Thread->Light->SlopePlaneGlobVis(foggy) * lxscale * lyscale) / (fabs(pl->height.ZatPoint(Thread->Viewport->viewpoint.Pos) - Thread->Viewport->viewpoint.Pos.Z)) / 65536.f;
+		float planelightfloat = (Thread->Light->SlopePlaneGlobVis(foggy) * lxscale * lyscale) / (fabs(pl->height.ZatPoint(Thread->Viewport->viewpoint.Pos) - Thread->Viewport->viewpoint.Pos.Z)) / 65536.f;
 
 		if (pl->height.fC() > 0)
 			planelightfloat = -planelightfloat;
+		setup.planelightfloat = planelightfloat;
 
-		drawerargs.SetStyle(false, false, OPAQUE, basecolormap);
+		drawerargs.SetStyle(false, false, OPAQUE, colormap);
 
 		CameraLight *cameraLight = CameraLight::Instance();
-		plane_shade = cameraLight->FixedLightLevel() < 0 && !cameraLight->FixedColormap();
-
-		lightlevel = pl->lightlevel;
+		setup.plane_shade = cameraLight->FixedLightLevel() < 0 && !cameraLight->FixedColormap();
+		setup.planeshade = LightVisibility::LightLevelToShade(pl->lightlevel, foggy, viewport);
+		setup.pviewx = pviewx;
+		setup.pviewy = pviewy;
+
+		setup.viewport = viewport;
+		setup.CenterX = viewport->CenterX;
+		setup.CenterY = viewport->CenterY;
+		setup.FocalLengthX = viewport->FocalLengthX;
+		setup.FocalLengthY = viewport->FocalLengthY;
+		setup.bgra = viewport->RenderTarget->IsBgra();
 
 		// Hack in support for 1 x Z and Z x 1 texture sizes
 		if (drawerargs.TextureHeightBits() == 0)
@@ -199,28 +215,85 @@ namespace swrenderer
 			plane_su[2] = plane_su[1] = plane_su[0] = 0;
 		}
 
-		RenderLines(pl);
+		if (r_planejobs && r_multithreaded != 0 && pl->left < pl->right)
+		{
+			const uint16_t *top, *bottom;
+			CopyOutline(Thread, pl, top, bottom);
+			Thread->PlaneQueue->Push<DrawSlopePlaneCommand>(setup, pl->left, pl->right, top, bottom);
+		}
+		else
+		{
+			RenderLines(pl);
+		}
 	}
 
 	void RenderSlopePlane::RenderLine(int y, int x1, int x2)
 	{
-		drawerargs.DrawTiltedSpan(Thread, y, x1, x2, plane_sz, plane_su, plane_sv, plane_shade, lightlevel, foggy, planelightfloat, pviewx, pviewy, basecolormap);
+		setup.DrawLine(Thread->Drawers(setup.viewport), y, x1, x2);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void SlopePlaneSetup::DrawLine(SWPixelFormatDrawers *drawers, int y, int x1, int x2)
+	{
+		drawerargs.SetDestY(viewport, y);
+		drawerargs.SetDestX1(x1);
+		drawerargs.SetDestX2(x2);
+		drawers->DrawTiltedSpan(drawerargs, plane_sz, plane_su, plane_sv, plane_shade, planeshade, planelightfloat, pviewx, pviewy, basecolormap);
 
 		if (r_modelscene)
 		{
-			double viewZ = 1.0;
-			double viewX1 = Thread->Viewport->ScreenToViewX(x1, viewZ);
-			double viewX2 = Thread->Viewport->ScreenToViewX(x2 + 1, viewZ);
-			double viewY = Thread->Viewport->ScreenToViewY(y, viewZ);
+			double viewX1 = (x1 + 0.5 - CenterX) / FocalLengthX;
+			double viewX2 = (x2 + 1 + 0.5 - CenterX) / FocalLengthX;
+			double viewY = (CenterY - y - 0.5) / FocalLengthY;
 
 			// Find depth values for the span
-			float zbufferdepth1 = (float)(-planeD / (planeNormal | DVector3(viewX1, viewZ, viewY)));
-			float zbufferdepth2 = (float)(-planeD / (planeNormal | DVector3(viewX2, viewZ, viewY)));
+			float zbufferdepth1 = (float)(-planeD / (planeNormal | DVector3(viewX1, 1.0, viewY)));
+			float zbufferdepth2 = (float)(-planeD / (planeNormal | DVector3(viewX2, 1.0, viewY)));
 
-			drawerargs.SetDestX1(x1);
-			drawerargs.SetDestX2(x2);
-			drawerargs.SetDestY(Thread->Viewport.get(), y);
-			drawerargs.DrawDepthSpan(Thread, 1.0f / zbufferdepth1, 1.0f / zbufferdepth2);
+			drawerargs.DrawDepthSpan(drawers, 1.0f / zbufferdepth1, 1.0f / zbufferdepth2);
 		}
 	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	DrawSlopePlaneCommand::DrawSlopePlaneCommand(const SlopePlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom)
+		: setup(setup), left(left), right(right), top(top), bottom(bottom)
+	{
+	}
+
+	void DrawSlopePlaneCommand::Execute(DrawerThread *thread)
+	{
+		SlopePlaneThreadRenderer::Get(thread)->Render(setup, left, right, top, bottom);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	SlopePlaneThreadRenderer::SlopePlaneThreadRenderer(DrawerThread *thread) : Thread(thread)
+	{
+		Queue = std::make_shared<DrawerCommandQueue>(thread);
+		PalDrawers.reset(new SWPalDrawers(Queue));
+		TrueColorDrawers.reset(new SWTruecolorDrawers(Queue));
+	}
+
+	SlopePlaneThreadRenderer *SlopePlaneThreadRenderer::Get(DrawerThread *thread)
+	{
+		if (!thread->slopeplanes)
+			thread->slopeplanes = std::make_shared<SlopePlaneThreadRenderer>(thread);
+		return thread->slopeplanes.get();
+	}
+
+	void SlopePlaneThreadRenderer::Render(const SlopePlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom)
+	{
+		Setup = setup;
+		RenderLines(left, right, top, bottom);
+	}
+
+	void SlopePlaneThreadRenderer::RenderLine(int y, int x1, int x2)
+	{
+		if (Thread->line_skipped_by_thread(y))
+			return;
+
+		Setup.DrawLine(Setup.bgra ? TrueColorDrawers.get() : PalDrawers.get(), y, x1, x2);
+	}
 }
@@ -24,11 +24,36 @@
 
 #include "r_planerenderer.h"
 #include "swrenderer/viewport/r_spandrawer.h"
+#include "swrenderer/drawers/r_thread.h"
 
 namespace swrenderer
 {
 	class RenderThread;
 
+	// Per plane constants of a sloped plane. Like FlatPlaneSetup, everything taken from
+	// the viewport is copied so that the spans can also be drawn on a drawer thread.
+	struct SlopePlaneSetup
+	{
+		void DrawLine(SWPixelFormatDrawers *drawers, int y, int x1, int x2);
+
+		FVector3 plane_sz, plane_su, plane_sv;
+		float planelightfloat;
+		bool plane_shade;
+		int planeshade;
+		fixed_t pviewx, pviewy;
+		FDynamicColormap *basecolormap;
+
+		DVector3 planeNormal;
+		double planeD;
+
+		RenderViewport *viewport;
+		double CenterX, CenterY;
+		double FocalLengthX, FocalLengthY;
+		bool bgra;
+
+		SpanDrawerArgs drawerargs;
+	};
+
 	class RenderSlopePlane : PlaneRenderer
 	{
 	public:
@@ -40,17 +65,41 @@ namespace swrenderer
 	private:
 		void RenderLine(int y, int x1, int x2) override;
 
-		FVector3 plane_sz, plane_su, plane_sv;
-		float planelightfloat;
-		bool plane_shade;
-		int lightlevel;
-		bool foggy;
-		fixed_t pviewx, pviewy;
-		fixed_t xscale, yscale;
-		FDynamicColormap *basecolormap;
-		SpanDrawerArgs drawerargs;
+		SlopePlaneSetup setup;
+	};
 
-		DVector3 planeNormal;
-		double planeD;
+	// Draws the tilted spans of a sloped plane on the drawer threads. Each thread only does the rows it owns.
+	class DrawSlopePlaneCommand : public DrawerCommand
+	{
+	public:
+		DrawSlopePlaneCommand(const SlopePlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom);
+		void Execute(DrawerThread *thread) override;
+
+	private:
+		const SlopePlaneSetup setup;
+		const int left;
+		const int right;
+		const uint16_t *const top;
+		const uint16_t *const bottom;
+	};
+
+	// Tilted span renderer owned by each drawer thread
+	class SlopePlaneThreadRenderer : PlaneRenderer
+	{
+	public:
+		SlopePlaneThreadRenderer(DrawerThread *thread);
+
+		static SlopePlaneThreadRenderer *Get(DrawerThread *thread);
+
+		void Render(const SlopePlaneSetup &setup, int left, int right, const uint16_t *top, const uint16_t *bottom);
+
+	private:
+		void RenderLine(int y, int x1, int x2) override;
+
+		DrawerThread *Thread;
+		SlopePlaneSetup Setup;
+		DrawerCommandQueuePtr Queue;
+		std::unique_ptr<SWPixelFormatDrawers> PalDrawers;
+		std::unique_ptr<SWPixelFormatDrawers> TrueColorDrawers;
 	};
 }
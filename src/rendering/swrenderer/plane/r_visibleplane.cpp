@@ -55,6 +55,8 @@ namespace swrenderer
 {
 	VisiblePlane::VisiblePlane(RenderThread *thread)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Planes);
+
 		picnum.SetNull();
 		height.set(0.0, 0.0, 1.0, 0.0);
 
@@ -67,6 +69,8 @@ namespace swrenderer
 
 	void VisiblePlane::AddLights(RenderThread *thread, FLightNode *node)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Planes);
+
 		if (!r_dynlights)
 			return;
 
@@ -79,6 +79,9 @@ namespace swrenderer
 		int CurrentPortalUniq = 0; // mirror counter, counts all of them
 		int MirrorFlags = 0; // this is not related to CurrentMirror
 
+		// Set when the plane has been drawn as part of a plane merged across the thread slices
+		bool merged = false;
+
 		uint16_t *bottom = nullptr;
 		uint16_t *top = nullptr;
 	};
@@ -67,6 +67,8 @@ namespace swrenderer
 
 	VisiblePlane *VisiblePlaneList::Add(unsigned hash)
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Planes);
+
 		VisiblePlane *newplane = Thread->FrameMemory->NewObject<VisiblePlane>(Thread);
 		newplane->next = visplanes[hash];
 		visplanes[hash] = newplane;
@@ -349,7 +351,7 @@ namespace swrenderer
 				if (pl->CurrentPortalUniq != renderportal->CurrentPortalUniq || pl->CurrentSkybox != Thread->Clip3D->CurrentSkybox)
 					continue;
 				// kg3D - draw only real planes now
-				if (pl->sky >= 0) {
+				if (pl->sky >= 0 && !pl->merged) {
 					vpcount++;
 					pl->Render(Thread, OPAQUE, false, false);
 				}
@@ -362,6 +364,98 @@ namespace swrenderer
 		return vpcount;
 	}
 
+	bool VisiblePlaneList::IsMergeCandidate(const VisiblePlane *pl) const
+	{
+		// Only plain opaque flats of the main pass. Lit planes keep their per-slice light lists.
+		return !pl->merged && pl->sky == 0 && pl->picnum != skyflatnum && pl->portal == nullptr && pl->lights == nullptr && pl->left < pl->right &&
+			pl->CurrentPortalUniq == Thread->Portal->CurrentPortalUniq && pl->CurrentSkybox == Thread->Clip3D->CurrentSkybox;
+	}
+
+	bool VisiblePlaneList::CanMerge(const VisiblePlane *a, const VisiblePlane *b)
+	{
+		return a->height == b->height &&
+			a->picnum == b->picnum &&
+			a->lightlevel == b->lightlevel &&
+			a->colormap == b->colormap &&
+			a->xform == b->xform &&
+			a->MirrorFlags == b->MirrorFlags &&
+			a->viewpos == b->viewpos;
+	}
+
+	int VisiblePlaneList::RenderMerged(RenderThread *thread, const std::vector<VisiblePlaneList *> &slices)
+	{
+		PlaneCycles.Clock();
+
+		int vpcount = 0;
+		std::vector<VisiblePlane *> group;
+
+		// Matching planes hash to the same bucket in every slice
+		for (int i = 0; i < MAXVISPLANES; i++)
+		{
+			for (size_t s = 0; s < slices.size(); s++)
+			{
+				for (VisiblePlane *pl = slices[s]->visplanes[i]; pl; pl = pl->next)
+				{
+					if (!slices[s]->IsMergeCandidate(pl))
+						continue;
+
+					// Take at most one plane from each of the following slices
+					group.clear();
+					group.push_back(pl);
+					for (size_t t = s + 1; t < slices.size(); t++)
+					{
+						for (VisiblePlane *check = slices[t]->visplanes[i]; check; check = check->next)
+						{
+							if (slices[t]->IsMergeCandidate(check) && CanMerge(pl, check))
+							{
+								group.push_back(check);
+								break;
+							}
+						}
+					}
+
+					if (group.size() < 2)
+						continue;
+
+					RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Planes);
+					VisiblePlane *merged = thread->FrameMemory->NewObject<VisiblePlane>(thread);
+					merged->height = pl->height;
+					merged->picnum = pl->picnum;
+					merged->lightlevel = pl->lightlevel;
+					merged->xform = pl->xform;
+					merged->colormap = pl->colormap;
+					merged->extralight = pl->extralight;
+					merged->visibility = pl->visibility;
+					merged->viewpos = pl->viewpos;
+					merged->viewangle = pl->viewangle;
+					merged->Alpha = pl->Alpha;
+					merged->Additive = pl->Additive;
+					merged->CurrentPortalUniq = pl->CurrentPortalUniq;
+					merged->MirrorFlags = pl->MirrorFlags;
+					merged->CurrentSkybox = pl->CurrentSkybox;
+
+					// The slices cover disjoint column ranges, so the outlines can simply be copied in
+					for (VisiblePlane *member : group)
+					{
+						merged->left = MIN(merged->left, member->left);
+						merged->right = MAX(merged->right, member->right);
+						int count = member->right - member->left;
+						memcpy(merged->top + member->left, member->top + member->left, count * sizeof(uint16_t));
+						memcpy(merged->bottom + member->left, member->bottom + member->left, count * sizeof(uint16_t));
+						member->merged = true;
+					}
+
+					vpcount++;
+					merged->Render(thread, OPAQUE, false, false);
+				}
+			}
+		}
+
+		PlaneCycles.Unclock();
+
+		return vpcount;
+	}
+
 	void VisiblePlaneList::RenderHeight(double height)
 	{
 		VisiblePlane *pl;
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <vector>
 #include "r_defs.h"
 
 struct FSectorPortal;
@@ -50,12 +51,18 @@ namespace swrenderer
 		int Render();
 		void RenderHeight(double height);
 
+		// Joins the main pass planes the thread slices split between them and renders them on the given thread
+		static int RenderMerged(RenderThread *thread, const std::vector<VisiblePlaneList *> &slices);
+
 		RenderThread *Thread = nullptr;
 
 	private:
 		VisiblePlaneList();
 		VisiblePlane *Add(unsigned hash);
 
+		bool IsMergeCandidate(const VisiblePlane *pl) const;
+		static bool CanMerge(const VisiblePlane *a, const VisiblePlane *b);
+
 		enum { MAXVISPLANES = 128 }; // must be a power of 2
 		VisiblePlane *visplanes[MAXVISPLANES + 1];
 
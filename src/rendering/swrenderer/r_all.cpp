@@ -26,6 +26,7 @@
 #include "scene/r_scene.cpp"
 #include "scene/r_translucent_pass.cpp"
 #include "segments/r_clipsegment.cpp"
+#include "segments/r_hizbuffer.cpp"
 #include "segments/r_drawsegment.cpp"
 #include "segments/r_portalsegment.cpp"
 #include "things/r_decal.cpp"
@@ -37,11 +37,40 @@
 #include "po_man.h"
 #include "r_data/colormaps.h"
 #include "r_memory.h"
+#include "stats.h"
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+	std::mutex InstancesMutex;
+	std::vector<RenderMemory *> Instances;
+}
+
+RenderMemory::RenderMemory()
+{
+	std::unique_lock<std::mutex> lock(InstancesMutex);
+	Instances.push_back(this);
+}
+
+RenderMemory::~RenderMemory()
+{
+	std::unique_lock<std::mutex> lock(InstancesMutex);
+	Instances.erase(std::find(Instances.begin(), Instances.end(), this));
+}
 
 void *RenderMemory::AllocBytes(int size)
 {
 	size = (size + 15) / 16 * 16; // 16-byte align
-		
+
+	FrameBytes[CurrentCategory] += size;
+
+	if (size > BlockSize)
+	{
+		LargeBlocks.push_back(std::unique_ptr<MemoryBlock>(new MemoryBlock(size)));
+		return LargeBlocks.back()->Data;
+	}
+
 	if (UsedBlocks.empty() || UsedBlocks.back()->Position + size > BlockSize)
 	{
 		if (!FreeBlocks.empty())
@@ -54,22 +83,91 @@ void *RenderMemory::AllocBytes(int size)
 		else
 		{
 			UsedBlocks.push_back(std::unique_ptr<MemoryBlock>(new MemoryBlock()));
+			BlocksCreated++;
 		}
 	}
-		
+
 	auto &block = UsedBlocks.back();
 	void *data = block->Data + block->Position;
 	block->Position += size;
 
 	return data;
 }
-	
+
 void RenderMemory::Clear()
 {
+	size_t total = 0;
+	for (int i = 0; i < NumCategories; i++)
+	{
+		LastFrameBytes[i] = FrameBytes[i];
+		FrameBytes[i] = 0;
+		total += LastFrameBytes[i];
+	}
+	History[HistoryPos] = total;
+	HistoryPos = (HistoryPos + 1) % HistoryFrames;
+	HighWaterMark = MAX(HighWaterMark, total);
+
 	while (!UsedBlocks.empty())
 	{
 		auto block = std::move(UsedBlocks.back());
 		UsedBlocks.pop_back();
 		FreeBlocks.push_back(std::move(block));
 	}
+	LargeBlocks.clear();
+
+	ReserveBlocks();
+}
+
+void RenderMemory::ReserveBlocks()
+{
+	// Keep enough blocks around for the largest of the recent frames so that the next frame doesn't have to allocate any.
+	// Blocks beyond that are released once a peak has dropped out of the history.
+	size_t peak = 0;
+	for (int i = 0; i < HistoryFrames; i++)
+		peak = MAX(peak, History[i]);
+
+	// Rounding up to whole blocks wastes the tail of each block, so keep one extra
+	size_t wanted = (peak + BlockSize - 1) / BlockSize + (peak > 0 ? 1 : 0);
+
+	while (FreeBlocks.size() > wanted)
+		FreeBlocks.pop_back();
+
+	while (FreeBlocks.size() < wanted)
+	{
+		FreeBlocks.push_back(std::unique_ptr<MemoryBlock>(new MemoryBlock()));
+		BlocksCreated++;
+	}
+}
+
+FString RenderMemory::GetStats()
+{
+	static const char *names[NumCategories] = { "other", "walls", "planes", "sprites", "portals", "drawers" };
+
+	size_t bytes[NumCategories] = { };
+	size_t total = 0, highWater = 0, reserved = 0;
+	int blocksCreated = 0;
+
+	std::unique_lock<std::mutex> lock(InstancesMutex);
+	for (RenderMemory *memory : Instances)
+	{
+		for (int i = 0; i < NumCategories; i++)
+		{
+			bytes[i] += memory->LastFrameBytes[i];
+			total += memory->LastFrameBytes[i];
+		}
+		highWater += memory->HighWaterMark;
+		reserved += (memory->UsedBlocks.size() + memory->FreeBlocks.size()) * BlockSize;
+		blocksCreated += memory->BlocksCreated;
+	}
+
+	FString out;
+	out.Format("frame=%zu KB  high water=%zu KB  reserved=%zu KB  blocks created=%d\n", total / 1024, highWater / 1024, reserved / 1024, blocksCreated);
+	for (int i = 0; i < NumCategories; i++)
+		out.AppendFormat("%s=%zu KB  ", names[i], bytes[i] / 1024);
+	return out;
+}
+
+ADD_STAT(framememory)
+{
+	return RenderMemory::GetStats();
 }
@@ -3,41 +3,93 @@
 #include <memory>
 #include <vector>
 
+class FString;
+
 // Memory needed for the duration of a frame rendering
 class RenderMemory
 {
 public:
+	// Subsystems tracked by the framememory stat
+	enum Category
+	{
+		Other,
+		Walls,
+		Planes,
+		Sprites,
+		Portals,
+		Drawers,
+		NumCategories
+	};
+
+	RenderMemory();
+	~RenderMemory();
+
 	void Clear();
-		
+
 	template<typename T>
 	T *AllocMemory(int size = 1)
 	{
 		return (T*)AllocBytes(sizeof(T) * size);
 	}
-		
+
 	template<typename T, typename... Types>
 	T *NewObject(Types &&... args)
 	{
 		void *ptr = AllocBytes(sizeof(T));
 		return new (ptr)T(std::forward<Types>(args)...);
 	}
-		
+
+	// Changes which category allocations are counted towards. Returns the previous category.
+	Category SetCategory(Category category) { Category old = CurrentCategory; CurrentCategory = category; return old; }
+
+	static FString GetStats();
+
 private:
 	void *AllocBytes(int size);
-		
-	enum { BlockSize = 1024 * 1024 };
-		
+	void ReserveBlocks();
+
+	enum
+	{
+		BlockSize = 1024 * 1024,
+		HistoryFrames = 32
+	};
+
 	struct MemoryBlock
 	{
-		MemoryBlock() : Data(new uint8_t[BlockSize]), Position(0) { }
+		MemoryBlock(uint32_t size = BlockSize) : Data(new uint8_t[size]), Size(size), Position(0) { }
 		~MemoryBlock() { delete[] Data; }
-			
+
 		MemoryBlock(const MemoryBlock &) = delete;
 		MemoryBlock &operator=(const MemoryBlock &) = delete;
-			
+
 		uint8_t *Data;
+		uint32_t Size;
 		uint32_t Position;
 	};
 	std::vector<std::unique_ptr<MemoryBlock>> UsedBlocks;
 	std::vector<std::unique_ptr<MemoryBlock>> FreeBlocks;
+	std::vector<std::unique_ptr<MemoryBlock>> LargeBlocks; // Allocations bigger than BlockSize, released every frame
+
+	Category CurrentCategory = Other;
+	size_t FrameBytes[NumCategories] = { };
+	size_t LastFrameBytes[NumCategories] = { };
+	size_t History[HistoryFrames] = { };
+	int HistoryPos = 0;
+	size_t HighWaterMark = 0;
+	int BlocksCreated = 0;
+};
+
+// Counts allocations in a scope towards a category
+class RenderMemoryCategory
+{
+public:
+	RenderMemoryCategory(RenderMemory *memory, RenderMemory::Category category) : Memory(memory), Saved(memory->SetCategory(category)) { }
+	~RenderMemoryCategory() { Memory->SetCategory(Saved); }
+
+	RenderMemoryCategory(const RenderMemoryCategory &) = delete;
+	RenderMemoryCategory &operator=(const RenderMemoryCategory &) = delete;
+
+private:
+	RenderMemory *Memory;
+	RenderMemory::Category Saved;
 };
@@ -47,6 +47,7 @@
 #include "swrenderer/plane/r_visibleplanelist.h"
 #include "swrenderer/segments/r_drawsegment.h"
 #include "swrenderer/segments/r_clipsegment.h"
+#include "swrenderer/segments/r_hizbuffer.h"
 #include "swrenderer/drawers/r_thread.h"
 #include "swrenderer/drawers/r_draw.h"
 #include "swrenderer/drawers/r_draw_rgba.h"
@@ -64,6 +65,7 @@ namespace swrenderer
 		Viewport.reset(new RenderViewport());
 		Light.reset(new LightVisibility());
 		DrawQueue.reset(new DrawerCommandQueue(FrameMemory.get()));
+		PlaneQueue = DrawQueue;
 		OpaquePass.reset(new RenderOpaquePass(this));
 		TranslucentPass.reset(new RenderTranslucentPass(this));
 		SpriteList.reset(new VisibleSpriteList());
@@ -73,6 +75,7 @@ namespace swrenderer
 		PlaneList.reset(new VisiblePlaneList(this));
 		DrawSegments.reset(new DrawSegmentList(this));
 		ClipSegments.reset(new RenderClipSegment());
+		HiZ.reset(new RenderHiZBuffer());
 		tc_drawers.reset(new SWTruecolorDrawers(DrawQueue));
 		pal_drawers.reset(new SWPalDrawers(DrawQueue));
 	}
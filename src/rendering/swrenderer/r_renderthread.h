@@ -46,6 +46,7 @@ namespace swrenderer
 	class VisiblePlaneList;
 	class DrawSegmentList;
 	class RenderClipSegment;
+	class RenderHiZBuffer;
 	class RenderViewport;
 	class LightVisibility;
 	class SWPixelFormatDrawers;
@@ -73,10 +74,14 @@ namespace swrenderer
 		std::unique_ptr<VisiblePlaneList> PlaneList;
 		std::unique_ptr<DrawSegmentList> DrawSegments;
 		std::unique_ptr<RenderClipSegment> ClipSegments;
+		std::unique_ptr<RenderHiZBuffer> HiZ;
 		std::unique_ptr<RenderViewport> Viewport;
 		std::unique_ptr<LightVisibility> Light;
 		DrawerCommandQueuePtr DrawQueue;
 
+		// Where plane jobs are pushed. This is DrawQueue except while planes merged across the slices are rendered.
+		DrawerCommandQueuePtr PlaneQueue;
+
 		TArray<FDynamicLight*> AddedLightsArray;
 
 		std::thread thread;
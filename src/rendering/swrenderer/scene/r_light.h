@@ -83,7 +83,8 @@ namespace swrenderer
 		// The vis value to pass into the GETPALOOKUP or LIGHTSCALE macros
 		double WallVis(double screenZ, bool foggy) const { return WallGlobVis(foggy) / screenZ; }
 		double SpriteVis(double screenZ, bool foggy) const { return SpriteGlobVis(foggy) / MAX(screenZ, MINZ); }
-		double FlatPlaneVis(int screenY, double planeheight, bool foggy, RenderViewport *viewport) const { return FlatPlaneGlobVis(foggy) / planeheight * fabs(viewport->CenterY - screenY); }
+		double FlatPlaneVis(int screenY, double planeheight, bool foggy, RenderViewport *viewport) const { return FlatPlaneVisScale(planeheight, foggy) * fabs(viewport->CenterY - screenY); }
+		double FlatPlaneVisScale(double planeheight, bool foggy) const { return FlatPlaneGlobVis(foggy) / planeheight; }
 
 		double SlopePlaneGlobVis(bool foggy) const { return (NoLightFade && !foggy) ? 0.0f : TiltVisibility; }
 
@@ -47,6 +47,7 @@
 #include "swrenderer/things/r_particle.h"
 #include "swrenderer/things/r_model.h"
 #include "swrenderer/segments/r_clipsegment.h"
+#include "swrenderer/segments/r_hizbuffer.h"
 #include "swrenderer/line/r_wallsetup.h"
 #include "swrenderer/line/r_farclip_line.h"
 #include "swrenderer/scene/r_scene.h"
@@ -433,7 +434,17 @@ namespace swrenderer
 		// Find the first clippost that touches the source post
 		//	(adjacent pixels are touching).
 
-		return Thread->ClipSegments->IsVisible(sx1, sx2);
+		if (!Thread->ClipSegments->IsVisible(sx1, sx2))
+			return false;
+
+		// Columns closed by upper and lower walls are not solid clip segments, but they still hide anything farther away.
+		// The nearest point of the box is always one of its corners.
+		auto &viewpoint = Thread->Viewport->viewpoint;
+		double nearz =
+			MIN((bspcoord[BOXLEFT] - viewpoint.Pos.X) * viewpoint.TanCos, (bspcoord[BOXRIGHT] - viewpoint.Pos.X) * viewpoint.TanCos) +
+			MIN((bspcoord[BOXBOTTOM] - viewpoint.Pos.Y) * viewpoint.TanSin, (bspcoord[BOXTOP] - viewpoint.Pos.Y) * viewpoint.TanSin);
+
+		return !Thread->HiZ->IsOccluded(sx1, sx2, 0, viewheight, nearz);
 	}
 
 	void RenderOpaquePass::AddPolyobjs(subsector_t *sub)
@@ -616,7 +627,7 @@ namespace swrenderer
 		if ((unsigned int)(sub->Index()) < Level->subsectors.Size())
 		{ // Only do it for the main BSP.
 			int lightlevel = (floorlightlevel + ceilinglightlevel) / 2;
-			for (int i = frontsector->Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = frontsector->Level->Particles[i].snext)
+			for (uint32_t i = frontsector->Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = frontsector->Level->Particles[i].snext)
 			{
 				RenderParticle::Project(Thread, &frontsector->Level->Particles[i], sub->sector, lightlevel, FakeSide, foggy);
 			}
@@ -832,6 +843,8 @@ namespace swrenderer
 		SeenSpriteSectors.clear();
 		SeenActors.clear();
 
+		Thread->HiZ->Clear(Thread, MAX(Thread->Portal->WindowLeft, Thread->X1), MIN(Thread->Portal->WindowRight, Thread->X2));
+
 		InSubsector = nullptr;
 		RenderBSPNode(Level->HeadNode());	// The head node is the last node output.
 
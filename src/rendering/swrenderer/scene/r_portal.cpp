@@ -101,6 +101,8 @@ namespace swrenderer
 	//
 	void RenderPortal::RenderPlanePortals()
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Portals);
+
 		numskyboxes = 0;
 
 		VisiblePlaneList *planes = Thread->PlaneList.get();
@@ -544,6 +546,8 @@ namespace swrenderer
 
 	void RenderPortal::AddLinePortal(line_t *linedef, int x1, int x2, const short *topclip, const short *bottomclip)
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Portals);
+
 		WallPortals.Push(Thread->FrameMemory->NewObject<PortalDrawseg>(Thread, linedef, x1, x2, topclip, bottomclip));
 	}
 }
@@ -65,6 +65,7 @@ void PeekThreadedErrorPane();
 
 EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
+EXTERN_CVAR(Bool, r_planejobs)
 
 CVAR(Int, r_scene_multithreaded, 0, 0);
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
@@ -222,6 +223,8 @@ namespace swrenderer
 			Threads[i]->X1 = viewwidth * i / numThreads;
 			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
 		}
+		// Merged planes are drawn ahead of every slice, which the depth buffer of the model scene does not allow for
+		merge_planes = numThreads > 1 && r_planejobs && r_multithreaded != 0 && !r_modelscene;
 		run_id++;
 		start_lock.unlock();
 
@@ -289,6 +292,9 @@ namespace swrenderer
 
 		if (viewactive)
 		{
+			if (merge_planes)
+				MergeSlicePlanes(thread);
+
 			thread->PlaneList->Render();
 
 			thread->Portal->RenderPlanePortals();
@@ -300,6 +306,38 @@ namespace swrenderer
 		DrawerThreads::Execute(thread->DrawQueue);
 	}
 
+	void RenderScene::MergeSlicePlanes(RenderThread *thread)
+	{
+		// All slices wait here until the main thread has joined the planes they split between them.
+		// The merged planes are queued before any slice queue so they still draw before the translucent pass.
+		std::unique_lock<std::mutex> merge_lock(merge_mutex);
+		if (!thread->MainThread)
+		{
+			int generation = merge_generation;
+			merge_arrived++;
+			merge_condition.notify_all();
+			merge_condition.wait(merge_lock, [&]() { return merge_generation != generation; });
+			return;
+		}
+
+		merge_condition.wait(merge_lock, [&]() { return merge_arrived == Threads.size() - 1; });
+		merge_arrived = 0;
+
+		std::vector<VisiblePlaneList *> slices;
+		for (auto &slice : Threads)
+			slices.push_back(slice->PlaneList.get());
+
+		auto mergequeue = std::make_shared<DrawerCommandQueue>(thread->FrameMemory.get());
+		thread->PlaneQueue = mergequeue;
+		VisiblePlaneList::RenderMerged(thread, slices);
+		thread->PlaneQueue = thread->DrawQueue;
+		DrawerThreads::Execute(mergequeue);
+
+		merge_generation++;
+		merge_lock.unlock();
+		merge_condition.notify_all();
+	}
+
 	void RenderScene::StartThreads(size_t numThreads)
 	{
 		while (Threads.size() < (size_t)numThreads)
@@ -442,4 +480,22 @@ namespace swrenderer
 	{
 		bestwallcycles = HUGE_VAL;
 	}
+
+	static double bestplanecycles = HUGE_VAL;
+
+	// Compare with r_planejobs on and off to measure the plane jobs, as the span setup moves out of the scene thread
+	ADD_STAT(planecycles)
+	{
+		FString out;
+		double cycles = PlaneCycles.Time();
+		if (cycles && cycles < bestplanecycles)
+			bestplanecycles = cycles;
+		out.Format("%g", bestplanecycles);
+		return out;
+	}
+
+	CCMD(clearplanecycles)
+	{
+		bestplanecycles = HUGE_VAL;
+	}
 }
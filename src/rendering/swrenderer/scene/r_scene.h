@@ -59,6 +59,7 @@ namespace swrenderer
 		void RenderActorView(AActor *actor,bool renderplayersprite, bool dontmaplines);
 		void RenderThreadSlices();
 		void RenderThreadSlice(RenderThread *thread);
+		void MergeSlicePlanes(RenderThread *thread);
 		void RenderPSprites();
 
 		void StartThreads(size_t numThreads);
@@ -75,5 +76,10 @@ namespace swrenderer
 		std::mutex end_mutex;
 		std::condition_variable end_condition;
 		size_t finished_threads = 0;
+		bool merge_planes = false;
+		std::mutex merge_mutex;
+		std::condition_variable merge_condition;
+		size_t merge_arrived = 0;
+		int merge_generation = 0;
 	};
 }
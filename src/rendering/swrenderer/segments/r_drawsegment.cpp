@@ -95,6 +95,8 @@ namespace swrenderer
 
 	void DrawSegmentList::BuildSegmentGroups()
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Walls);
+
 		SegmentGroups.Clear();
 
 		unsigned int groupSize = 100;
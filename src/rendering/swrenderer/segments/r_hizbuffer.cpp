@@ -0,0 +1,189 @@
+//-----------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include "templates.h"
+#include "doomdef.h"
+#include "r_state.h"
+#include "c_cvars.h"
+#include "swrenderer/scene/r_opaque_pass.h"
+#include "swrenderer/scene/r_portal.h"
+#include "swrenderer/viewport/r_viewport.h"
+#include "swrenderer/line/r_line.h"
+#include "swrenderer/segments/r_hizbuffer.h"
+#include "swrenderer/r_renderthread.h"
+
+CVAR(Bool, r_hizcull, true, 0)
+
+namespace swrenderer
+{
+	void RenderHiZBuffer::Clear(RenderThread *thread, int x1, int x2)
+	{
+		Enabled = r_hizcull;
+		if (!Enabled)
+			return;
+
+		Width = viewwidth;
+		Height = viewheight;
+		TilesX = (Width + TileSize - 1) >> TileShift;
+		TilesY = (Height + TileSize - 1) >> TileShift;
+		ActiveX1 = clamp(x1, 0, Width);
+		ActiveX2 = clamp(x2, ActiveX1, Width);
+
+		TopRows.assign(Width, 0);
+		BottomRows.assign(Width, TilesY);
+		CoveredColumns.assign(TilesX * TilesY, 0);
+		TileDepth.assign(TilesX * TilesY, 0.0f);
+
+		// Nothing outside the window can be drawn in this pass
+		for (int x = 0; x < ActiveX1; x++)
+			UpdateColumn(x, Height, -1, 0.0f);
+		for (int x = ActiveX2; x < Width; x++)
+			UpdateColumn(x, Height, -1, 0.0f);
+
+		// Portals start out with everything outside their opening already clipped away
+		const short *ceilingclip = thread->OpaquePass->ceilingclip;
+		const short *floorclip = thread->OpaquePass->floorclip;
+		for (int x = ActiveX1; x < ActiveX2; x++)
+			UpdateColumn(x, ceilingclip[x], floorclip[x], 0.0f);
+	}
+
+	void RenderHiZBuffer::MarkWall(RenderThread *thread, int x1, int x2, const FWallCoords &wallc)
+	{
+		if (!Enabled)
+			return;
+
+		x1 = MAX(x1, ActiveX1);
+		x2 = MIN(x2, ActiveX2);
+		if (x1 >= x2)
+			return;
+
+		const short *ceilingclip = thread->OpaquePass->ceilingclip;
+		const short *floorclip = thread->OpaquePass->floorclip;
+
+		// 1/z is linear in screen space. Use the farthest of the two column edges to stay conservative.
+		float invZ1 = 1.0f / wallc.sz1;
+		float invZ2 = 1.0f / wallc.sz2;
+		float invZStep = (wallc.sx2 > wallc.sx1) ? (invZ2 - invZ1) / (wallc.sx2 - wallc.sx1) : 0.0f;
+		for (int x = x1; x < x2; x++)
+		{
+			float invZLeft = invZ1 + invZStep * (x - wallc.sx1);
+			float invZRight = invZLeft + invZStep;
+			float invZ = MIN(invZLeft, invZRight);
+			float depth = invZ > 0.0f ? 1.0f / invZ : MAX(wallc.sz1, wallc.sz2);
+			UpdateColumn(x, ceilingclip[x], floorclip[x], depth);
+		}
+	}
+
+	void RenderHiZBuffer::UpdateColumn(int x, int ceilingclip, int floorclip, float depth)
+	{
+		int oldTop = TopRows[x];
+		int oldBottom = BottomRows[x];
+		if (oldTop >= oldBottom)
+			return;
+
+		int top, bottom;
+		if (ceilingclip >= floorclip)
+		{
+			top = TilesY;
+			bottom = TilesY;
+		}
+		else
+		{
+			top = (ceilingclip >= Height) ? TilesY : (MAX(ceilingclip, 0) >> TileShift);
+			bottom = (floorclip + TileSize - 1) >> TileShift;
+		}
+
+		int newTop = clamp(top, oldTop, oldBottom);
+		int newBottom = clamp(bottom, newTop, oldBottom);
+
+		int tileX = x >> TileShift;
+		for (int y = oldTop; y < newTop; y++)
+			CoverTile(tileX, y, depth);
+		for (int y = newBottom; y < oldBottom; y++)
+			CoverTile(tileX, y, depth);
+
+		TopRows[x] = newTop;
+		BottomRows[x] = newBottom;
+	}
+
+	void RenderHiZBuffer::CoverTile(int tileX, int tileY, float depth)
+	{
+		int index = tileX + tileY * TilesX;
+		CoveredColumns[index]++;
+		TileDepth[index] = MAX(TileDepth[index], depth);
+	}
+
+	bool RenderHiZBuffer::IsOccluded(int x1, int x2, int y1, int y2, double nearz) const
+	{
+		if (!Enabled)
+			return false;
+
+		x1 = MAX(x1, ActiveX1);
+		x2 = MIN(x2, ActiveX2);
+		y1 = MAX(y1, 0);
+		y2 = MIN(y2, Height);
+		if (x1 >= x2 || y1 >= y2)
+			return false;
+
+		// Leave some room for rounding so that things touching a wall are never rejected
+		float limit = (float)(nearz * 0.99);
+
+		int tileX1 = x1 >> TileShift;
+		int tileX2 = (x2 - 1) >> TileShift;
+		int tileY1 = y1 >> TileShift;
+		int tileY2 = (y2 - 1) >> TileShift;
+		for (int tileY = tileY1; tileY <= tileY2; tileY++)
+		{
+			for (int tileX = tileX1; tileX <= tileX2; tileX++)
+			{
+				int index = tileX + tileY * TilesX;
+				int columns = MIN((int)TileSize, Width - (tileX << TileShift));
+				if (CoveredColumns[index] < columns || TileDepth[index] >= limit)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool RenderHiZBuffer::IsOccluded(RenderThread *thread, double tx, double tz, double radius, double gzb, double gzt) const
+	{
+		if (!Enabled)
+			return false;
+
+		auto viewport = thread->Viewport.get();
+
+		// tz is scaled by the focal tangent, tx is not
+		double depthRadius = radius * viewport->viewwindow.FocalTangent;
+		double nearz = tz - depthRadius;
+		double farz = tz + depthRadius;
+		if (nearz < MINZ)
+			return false;
+
+		double left = tx - radius;
+		double right = tx + radius;
+		int x1 = xs_FloorToInt(viewport->CenterX + left * viewport->CenterX / (left < 0.0 ? nearz : farz)) - 1;
+		int x2 = xs_CeilToInt(viewport->CenterX + right * viewport->CenterX / (right > 0.0 ? nearz : farz)) + 1;
+
+		double top = gzt - viewport->viewpoint.Pos.Z;
+		double bottom = gzb - viewport->viewpoint.Pos.Z;
+		int y1 = xs_FloorToInt(viewport->CenterY - top * viewport->InvZtoScale / (top > 0.0 ? nearz : farz)) - 1;
+		int y2 = xs_CeilToInt(viewport->CenterY - bottom * viewport->InvZtoScale / (bottom < 0.0 ? nearz : farz)) + 1;
+
+		return IsOccluded(x1, x2, y1, y2, nearz);
+	}
+}
@@ -0,0 +1,75 @@
+//-----------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+namespace swrenderer
+{
+	class RenderThread;
+	struct FWallCoords;
+
+	// Coarse per-tile depth buffer used to reject things hidden behind walls.
+	//
+	// The opaque pass only ever narrows the open range between ceilingclip and
+	// floorclip of a column. A tile becomes covered once every column in it has
+	// closed over the tile's rows, and its depth is the farthest wall depth that
+	// closed any of those columns. Anything that only touches covered tiles and
+	// lies entirely behind their depth can't be visible.
+	class RenderHiZBuffer
+	{
+	public:
+		enum
+		{
+			TileShift = 4,
+			TileSize = 1 << TileShift
+		};
+
+		// Starts a new scene pass. Columns outside [x1, x2) and rows already closed by the clip lists count as covered.
+		void Clear(RenderThread *thread, int x1, int x2);
+
+		// Marks rows the opaque pass clipped away in [x1, x2) as covered by the given wall.
+		void MarkWall(RenderThread *thread, int x1, int x2, const FWallCoords &wallc);
+
+		// Returns true if the screen rectangle is behind covered tiles at the given view depth.
+		bool IsOccluded(int x1, int x2, int y1, int y2, double nearz) const;
+
+		// Projects a world space box around a point and checks if it is occluded.
+		bool IsOccluded(RenderThread *thread, double tx, double tz, double radius, double gzb, double gzt) const;
+
+	private:
+		void UpdateColumn(int x, int ceilingclip, int floorclip, float depth);
+		void CoverTile(int tileX, int tileY, float depth);
+
+		int Width = 0;
+		int Height = 0;
+		int TilesX = 0;
+		int TilesY = 0;
+		int ActiveX1 = 0;
+		int ActiveX2 = 0;
+		bool Enabled = false;
+
+		// Per column: number of tile rows covered from the top and first covered tile row from the bottom.
+		std::vector<short> TopRows;
+		std::vector<short> BottomRows;
+
+		// Per tile: number of columns covered and the farthest depth among them.
+		std::vector<short> CoveredColumns;
+		std::vector<float> TileDepth;
+	};
+}
@@ -46,6 +46,8 @@ namespace swrenderer
 {
 	PortalDrawseg::PortalDrawseg(RenderThread *thread, line_t *linedef, int x1, int x2, const short *topclip, const short *bottomclip) : x1(x1), x2(x2)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Portals);
+
 		src = linedef;
 		dst = linedef->special == Line_Mirror ? linedef : linedef->getPortalDestination();
 		len = x2 - x1;
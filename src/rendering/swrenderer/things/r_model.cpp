@@ -38,6 +38,8 @@ namespace swrenderer
 {
 	void RenderModel::Project(RenderThread *thread, float x, float y, float z, FSpriteModelFrame *smf, AActor *actor)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Sprites);
+
 		// transform the origin point
 		double tr_x = x - thread->Viewport->viewpoint.Pos.X;
 		double tr_y = y - thread->Viewport->viewpoint.Pos.Y;
@@ -152,6 +154,8 @@ namespace swrenderer
 
 	void SWModelRenderer::AddLights(AActor *actor)
 	{
+		RenderMemoryCategory memoryCategory(Thread->FrameMemory.get(), RenderMemory::Sprites);
+
 		if (r_dynlights && actor)
 		{
 			auto &addedLights = Thread->AddedLightsArray;
@@ -71,6 +71,8 @@ namespace swrenderer
 {
 	void RenderParticle::Project(RenderThread *thread, particle_t *particle, const sector_t *sector, int lightlevel, WaterFakeSide fakeside, bool foggy)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Sprites);
+
 		double 				tr_x, tr_y;
 		double 				tx, ty;
 		double	 			tz, tiz;
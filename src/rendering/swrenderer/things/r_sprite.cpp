@@ -57,6 +57,7 @@
 #include "p_local.h"
 #include "r_voxel.h"
 #include "swrenderer/segments/r_drawsegment.h"
+#include "swrenderer/segments/r_hizbuffer.h"
 #include "swrenderer/scene/r_portal.h"
 #include "swrenderer/scene/r_scene.h"
 #include "swrenderer/scene/r_light.h"
@@ -74,6 +75,8 @@ namespace swrenderer
 {
 	void RenderSprite::Project(RenderThread *thread, AActor *thing, const DVector3 &pos, FTexture *ttex, const DVector2 &spriteScale, int renderflags, WaterFakeSide fakeside, F3DFloor *fakefloor, F3DFloor *fakeceiling, sector_t *current_sector, int lightlevel, bool foggy, FDynamicColormap *basecolormap)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Sprites);
+
 		FSoftwareTexture *tex = ttex->GetSoftwareTexture();
 		// transform the origin point
 		double tr_x = pos.X - thread->Viewport->viewpoint.Pos.X;
@@ -169,6 +172,12 @@ namespace swrenderer
 		if ((x2 < renderportal->WindowLeft || x2 <= x1))
 			return;
 
+		// hidden behind walls already drawn?
+		int y1 = xs_FloorToInt(viewport->CenterY - (gzt - viewport->viewpoint.Pos.Z) * viewport->InvZtoScale / tz);
+		int y2 = xs_CeilToInt(viewport->CenterY - (gzb - viewport->viewpoint.Pos.Z) * viewport->InvZtoScale / tz);
+		if (thread->HiZ->IsOccluded(x1, x2, y1, y2, tz))
+			return;
+
 		xscale = spriteScale.X * xscale / tex->GetScale().X;
 		fixed_t iscale = (fixed_t)(FRACUNIT / xscale); // Round towards zero to avoid wrapping in edge cases
 
@@ -48,6 +48,7 @@
 #include "swrenderer/things/r_visiblesprite.h"
 #include "swrenderer/things/r_voxel.h"
 #include "swrenderer/scene/r_portal.h"
+#include "swrenderer/segments/r_hizbuffer.h"
 #include "swrenderer/scene/r_translucent_pass.h"
 #include "swrenderer/scene/r_scene.h"
 #include "swrenderer/scene/r_light.h"
@@ -62,6 +63,8 @@ namespace swrenderer
 {
 	void RenderVoxel::Project(RenderThread *thread, AActor *thing, DVector3 pos, FVoxelDef *voxel, const DVector2 &spriteScale, int renderflags, WaterFakeSide fakeside, F3DFloor *fakefloor, F3DFloor *fakeceiling, sector_t *current_sector, int lightlevel, bool foggy, FDynamicColormap *basecolormap)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Sprites);
+
 		// transform the origin point
 		double tr_x = pos.X - thread->Viewport->viewpoint.Pos.X;
 		double tr_y = pos.Y - thread->Viewport->viewpoint.Pos.Y;
@@ -118,6 +121,13 @@ namespace swrenderer
 			}
 		}
 
+		// Reject voxels whose bounding cylinder is hidden behind walls already drawn
+		FVoxelMipLevel *mip = &voxel->Voxel->Mips[0];
+		double radiusX = MAX(mip->Pivot.X, mip->SizeX - mip->Pivot.X);
+		double radiusY = MAX(mip->Pivot.Y, mip->SizeY - mip->Pivot.Y);
+		if (thread->HiZ->IsOccluded(thread, tx, tz, xscale * sqrt(radiusX * radiusX + radiusY * radiusY), gzb, gzt))
+			return;
+
 		RenderVoxel *vis = thread->FrameMemory->NewObject<RenderVoxel>();
 
 		vis->CurrentPortalUniq = renderportal->CurrentPortalUniq;
@@ -204,6 +214,8 @@ namespace swrenderer
 
 	void RenderVoxel::Render(RenderThread *thread, short *cliptop, short *clipbottom, int minZ, int maxZ, Fake3DTranslucent clip3DFloor)
 	{
+		RenderMemoryCategory memoryCategory(thread->FrameMemory.get(), RenderMemory::Sprites);
+
 		auto spr = this;
 		auto viewport = thread->Viewport.get();
 
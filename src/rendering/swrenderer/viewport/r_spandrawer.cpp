@@ -133,6 +133,16 @@ namespace swrenderer
 		(thread->Drawers(ds_viewport)->*spanfunc)(*this);
 	}
 
+	void SpanDrawerArgs::DrawDepthSpan(SWPixelFormatDrawers *drawers, float idepth1, float idepth2)
+	{
+		drawers->DrawDepthSpan(*this, idepth1, idepth2);
+	}
+
+	void SpanDrawerArgs::DrawSpan(SWPixelFormatDrawers *drawers)
+	{
+		(drawers->*spanfunc)(*this);
+	}
+
 	void SpanDrawerArgs::DrawTiltedSpan(RenderThread *thread, int y, int x1, int x2, const FVector3 &plane_sz, const FVector3 &plane_su, const FVector3 &plane_sv, bool plane_shade, int lightlevel, bool foggy, float planelightfloat, fixed_t pviewx, fixed_t pviewy, FDynamicColormap *basecolormap)
 	{
 		SetDestY(thread->Viewport.get(), y);
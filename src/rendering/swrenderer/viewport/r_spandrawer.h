@@ -29,6 +29,8 @@ namespace swrenderer
 
 		void DrawDepthSpan(RenderThread *thread, float idepth1, float idepth2);
 		void DrawSpan(RenderThread *thread);
+		void DrawDepthSpan(SWPixelFormatDrawers *drawers, float idepth1, float idepth2);
+		void DrawSpan(SWPixelFormatDrawers *drawers);
 		void DrawTiltedSpan(RenderThread *thread, int y, int x1, int x2, const FVector3 &plane_sz, const FVector3 &plane_su, const FVector3 &plane_sv, bool plane_shade, int lightlevel, bool foggy, float planelightfloat, fixed_t pviewx, fixed_t pviewy, FDynamicColormap *basecolormap);
 		void DrawColoredSpan(RenderThread *thread, int y, int x1, int x2);
 		void DrawFogBoundaryLine(RenderThread *thread, int y, int x1, int x2);
@@ -213,7 +213,7 @@ void VkHardwareTexture::CreateImage(FTexture *tex, int translation, int flags)
 			translation = remap == nullptr ? 0 : remap->GetUniqueIndex();
 		}
 
-		FTextureBuffer texbuffer = tex->CreateTexBuffer(translation, flags | CTF_ProcessData);
+		FTextureBuffer texbuffer = hw_CreateTexBuffer(tex, translation, flags | CTF_ProcessData);
 		CreateTexture(texbuffer.mWidth, texbuffer.mHeight, 4, VK_FORMAT_B8G8R8A8_UNORM, texbuffer.mBuffer);
 	}
 	else
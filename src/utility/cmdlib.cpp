@@ -25,9 +25,11 @@
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#include <sys/utime.h>
 #else
 #include <dirent.h>
 #include <unistd.h>
+#include <utime.h>
 #include <sys/types.h>
 #include <pwd.h>
 #if !defined(__sun)
@@ -203,6 +205,55 @@ bool DirEntryExists(const char *pathname, bool *isdir)
 	return res;
 }
 
+//==========================================================================
+//
+// GetFileInfo
+//
+// Returns the size and modification time of a file.
+//
+//==========================================================================
+
+bool GetFileInfo(const char *pathname, size_t *size, time_t *time)
+{
+	if (pathname == NULL || *pathname == 0)
+		return false;
+
+#ifndef _WIN32
+	struct stat info;
+	bool res = stat(pathname, &info) == 0;
+#else
+	// Windows must use the wide version of stat to preserve non-standard paths.
+	auto wstr = WideString(pathname);
+	struct _stat64i32 info;
+	bool res = _wstat64i32(wstr.c_str(), &info) == 0;
+#endif
+	if (!res || (info.st_mode & S_IFDIR)) return false;
+	if (size) *size = (size_t)info.st_size;
+	if (time) *time = info.st_mtime;
+	return true;
+}
+
+//==========================================================================
+//
+// TouchFile
+//
+// Sets the modification time of a file to the current time.
+//
+//==========================================================================
+
+bool TouchFile(const char *pathname)
+{
+	if (pathname == NULL || *pathname == 0)
+		return false;
+
+#ifndef _WIN32
+	return utime(pathname, nullptr) == 0;
+#else
+	auto wstr = WideString(pathname);
+	return _wutime(wstr.c_str(), nullptr) == 0;
+#endif
+}
+
 //==========================================================================
 //
 // DefaultExtension		-- FString version
@@ -281,6 +281,32 @@ uint32_t FRandom::StaticSumSeeds ()
 		pr_damagemobj.sfmt.u[0] + pr_damagemobj.idx;
 }
 
+//==========================================================================
+//
+// FRandom :: StaticHashState
+//
+// Unlike StaticSumSeeds this folds in every named RNG, so that the
+// playsim checksum catches a difference in any of them. The index and the
+// start of the state array change as soon as a number gets drawn.
+//
+//==========================================================================
+
+uint64_t FRandom::StaticHashState (uint64_t hash)
+{
+	for (FRandom *rng = FRandom::RNGList; rng != NULL; rng = rng->Next)
+	{
+		if (rng->NameCRC != 0)
+		{
+			uint32_t values[] = { rng->NameCRC, (uint32_t)rng->idx, rng->sfmt.u[0], rng->sfmt.u[1] };
+			for (auto v : values)
+			{
+				hash = (hash ^ v) * 0x100000001b3ull;
+			}
+		}
+	}
+	return hash;
+}
+
 //==========================================================================
 //
 // FRandom :: StaticWriteRNGState
@@ -174,6 +174,7 @@ public:
 	// Static interface
 	static void StaticClearRandom ();
 	static uint32_t StaticSumSeeds ();
+	static uint64_t StaticHashState (uint64_t hash);
 	static void StaticReadRNGState (FSerializer &arc);
 	static void StaticWriteRNGState (FSerializer &file);
 	static FRandom *StaticFindRNG(const char *name);
@@ -56,13 +56,14 @@ struct FMemArena::Block
 //
 // RoundPointer
 //
-// Rounds a pointer up to a pointer-sized boundary.
+// Rounds a pointer up to a 16 byte boundary, the same as the allocation
+// sizes, so that every allocation is aligned like the result of new.
 //
 //==========================================================================
 
 static inline void *RoundPointer(void *ptr)
 {
-	return (void *)(((size_t)ptr + sizeof(void*) - 1) & ~(sizeof(void*) - 1));
+	return (void *)(((size_t)ptr + 15) & ~(size_t)15);
 }
 
 //==========================================================================
@@ -217,7 +218,7 @@ void FMemArena::FreeBlockChain(Block *&top)
 FMemArena::Block *FMemArena::AddBlock(size_t size)
 {
 	Block *mem, **last;
-	size += sizeof(Block);		// Account for header size
+	size += sizeof(Block) + 15;	// Account for header size and aligning the start
 
 	// Search for a free block to use
 	for (last = &FreeBlocks, mem = FreeBlocks; mem != NULL; last = &mem->NextBlock, mem = mem->NextBlock)
@@ -281,6 +282,120 @@ void *FMemArena::Block::Alloc(size_t size)
 	return res;
 }
 
+//==========================================================================
+//
+// FSizeClassPool Constructor
+//
+//==========================================================================
+
+FSizeClassPool::FSizeClassPool(size_t blocksize)
+	: Arena(blocksize)
+{
+	static_assert(sizeof(Header) <= HeaderSize, "Pool header does not fit");
+}
+
+//==========================================================================
+//
+// FSizeClassPool :: Alloc
+//
+// Takes a block from the size class's free list, or carves a new one out
+// of the arena if the list is empty.
+//
+//==========================================================================
+
+void *FSizeClassPool::Alloc(size_t size)
+{
+	size += HeaderSize;
+	Header *head;
+
+	if (size > MaxPooledSize)
+	{
+		head = (Header *)M_Malloc(size);
+		head->SizeClass = LargeClass;
+		LargeLive++;
+		LargeAllocs++;
+	}
+	else
+	{
+		unsigned sizeclass = SizeToClass(size);
+		SizeClass &cls = Classes[sizeclass];
+		head = cls.FreeList;
+		if (head != nullptr)
+		{
+			cls.FreeList = head->NextFree;
+			cls.Free--;
+		}
+		else
+		{
+			head = (Header *)Arena.Alloc(ClassToSize(sizeclass));
+			head->SizeClass = sizeclass;
+		}
+		cls.Live++;
+		cls.Allocs++;
+	}
+	head->Owner = nullptr;
+	return (uint8_t *)head + HeaderSize;
+}
+
+//==========================================================================
+//
+// FSizeClassPool :: Free
+//
+// Returns a block to its size class. Memory never goes back to the arena.
+//
+//==========================================================================
+
+void FSizeClassPool::Free(void *mem)
+{
+	if (mem == nullptr) return;
+
+	Header *head = GetHeader(mem);
+	if (head->SizeClass == LargeClass)
+	{
+		LargeLive--;
+		M_Free(head);
+	}
+	else
+	{
+		SizeClass &cls = Classes[head->SizeClass];
+		head->NextFree = cls.FreeList;
+		cls.FreeList = head;
+		cls.Live--;
+		cls.Free++;
+	}
+}
+
+//==========================================================================
+//
+// FSizeClassPool :: DumpInfo
+//
+// Prints the size classes that have been used so far.
+//
+//==========================================================================
+
+void FSizeClassPool::DumpInfo()
+{
+	size_t live = 0, free = 0;
+
+	Printf("%6s %8s %8s %10s\n", "Size", "Live", "Free", "Allocs");
+	for (unsigned i = 0; i < NumClasses; i++)
+	{
+		const SizeClass &cls = Classes[i];
+		if (cls.Allocs > 0)
+		{
+			size_t size = ClassToSize(i);
+			Printf("%6zu %8zu %8zu %10zu\n", size, cls.Live, cls.Free, cls.Allocs);
+			live += cls.Live * size;
+			free += cls.Free * size;
+		}
+	}
+	if (LargeAllocs > 0)
+	{
+		Printf("%6s %8zu %8s %10zu\n", "large", LargeLive, "-", LargeAllocs);
+	}
+	Printf("%zuK in use, %zuK on free lists\n", (live + 1023) >> 10, (free + 1023) >> 10);
+}
+
 //==========================================================================
 //
 // FSharedStringArena Constructor
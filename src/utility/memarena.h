@@ -89,5 +89,94 @@ private:
 	void *Alloc(size_t size) { return NULL; }	// No access to FMemArena::Alloc for outsiders.
 };
 
+// A pool of blocks sorted into size classes, carved out of an arena. Unlike
+// FMemArena, single allocations can be returned to the pool, where they are
+// reused by the next allocation of the same size class. Requests larger than
+// the biggest class are passed on to M_Malloc.
+class FSizeClassPool
+{
+public:
+	enum
+	{
+		HeaderSize = 16,
+		SmallLimit = 1024,			// 16 byte steps up to here
+		MaxPooledSize = 16384,		// 128 byte steps up to here
+		SmallClasses = SmallLimit / 16,
+		NumClasses = SmallClasses + (MaxPooledSize - SmallLimit) / 128,
+		LargeClass = NumClasses
+	};
+
+	FSizeClassPool(size_t blocksize = 256*1024);
+
+	void *Alloc(size_t size);
+	void Free(void *mem);
+	void DumpInfo();
+
+	// Returns true if the memory came out of one of the size classes.
+	static bool IsPooled(void *mem)
+	{
+		return GetHeader(mem)->SizeClass != LargeClass;
+	}
+
+	// Returns the number of bytes the allocation occupies in the pool, including its header.
+	static size_t GetSize(void *mem)
+	{
+		return ClassToSize(GetHeader(mem)->SizeClass);
+	}
+
+	// Lets the user attach a pointer to a live allocation. It is cleared by Alloc.
+	static void SetOwner(void *mem, void *owner)
+	{
+		GetHeader(mem)->Owner = owner;
+	}
+
+	static void *GetOwner(void *mem)
+	{
+		return GetHeader(mem)->Owner;
+	}
+
+protected:
+	struct Header
+	{
+		union
+		{
+			Header *NextFree;	// while on a free list
+			void *Owner;		// while allocated
+		};
+		uint32_t SizeClass;
+		uint32_t Pad;
+	};
+
+	struct SizeClass
+	{
+		Header *FreeList = nullptr;
+		size_t Live = 0;
+		size_t Free = 0;
+		size_t Allocs = 0;
+	};
+
+	static Header *GetHeader(void *mem)
+	{
+		return (Header *)((uint8_t *)mem - HeaderSize);
+	}
+
+	static unsigned SizeToClass(size_t size)
+	{
+		if (size <= SmallLimit) return unsigned((size - 1) >> 4);
+		return SmallClasses + unsigned((size - SmallLimit - 1) >> 7);
+	}
+
+	static size_t ClassToSize(unsigned sizeclass)
+	{
+		if (sizeclass < SmallClasses) return size_t(sizeclass + 1) << 4;
+		return SmallLimit + (size_t(sizeclass - SmallClasses + 1) << 7);
+	}
+
+	FMemArena Arena;
+	SizeClass Classes[NumClasses];
+	size_t LargeLive = 0;
+	size_t LargeAllocs = 0;
+};
+
 
 #endif